@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "boo/audiodev/IAudioSubmix.hpp"
+
+namespace boo {
+
+/** Uniformly partitioned FFT convolution effect for use as a submix callback.
+ *  The impulse response is split into partitionFrames-sized blocks and convolved in the
+ *  frequency domain, so cost grows with IR length / partition size rather than IR length.
+ *  Output is delayed by partitionFrames (rounded up to a power of two, min 32).
+ *  With tailThread set, all partitions after the first are accumulated on a worker thread
+ *  between callbacks, leaving the mixing thread one spectral multiply per channel.
+ *  Impulse responses are transformed (and resampled) on a loader thread and swapped in whole,
+ *  so the mixing thread never waits on a load or rate change */
+class ConvolutionReverb : public IAudioSubmixCallback {
+  struct Impl;
+  std::unique_ptr<Impl> m_impl;
+
+public:
+  explicit ConvolutionReverb(size_t partitionFrames = 256, bool tailThread = false);
+  ~ConvolutionReverb();
+
+  /** Copy in an interleaved impulse response; channel c of the submix uses IR channel c % channels.
+   *  The IR is resampled to the output rate when sampleRate differs. It takes effect once the
+   *  loader has built it; until the first one is ready the submix passes through dry.
+   *  An empty impulse (null, no frames, no channels or a non-positive rate) is rejected and the current one kept */
+  void loadImpulse(const float* ir, size_t frames, unsigned channels, double sampleRate);
+
+  /** Same as above for 16-bit PCM impulse responses */
+  void loadImpulse(const int16_t* ir, size_t frames, unsigned channels, double sampleRate);
+
+  /** Set dry (input) and wet (convolved) output gains; default is fully wet for aux-send use */
+  void setMix(float dry, float wet);
+
+  bool canApplyEffect() const override;
+  void applyEffect(int16_t* audio, size_t frameCount, const ChannelMap& chanMap, double sampleRate) const override;
+  void applyEffect(int32_t* audio, size_t frameCount, const ChannelMap& chanMap, double sampleRate) const override;
+  void applyEffect(float* audio, size_t frameCount, const ChannelMap& chanMap, double sampleRate) const override;
+  void resetOutputSampleRate(double sampleRate) override;
+};
+
+} // namespace boo
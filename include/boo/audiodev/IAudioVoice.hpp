@@ -23,6 +23,12 @@ enum class AudioChannel {
   Unknown = 0xff
 };
 
+enum class AudioFilterType { None, LowPass, HighPass };
+
+/** Sample-rate converter used by callback voices: High is soxr (20-bit),
+ *  Fast is a 4-point Hermite interpolator suited to heavily pitch-modulated sound effects */
+enum class AudioResamplerQuality { High, Fast };
+
 struct ChannelMap {
   unsigned m_channelCount = 0;
   std::array<AudioChannel, 8> m_channels{};
@@ -60,16 +66,37 @@ struct IAudioVoice : IObj {
   /** Called by client to dynamically adjust the pitch of voices with dynamic pitch enabled */
   virtual void setPitchRatio(double ratio, bool slew) = 0;
 
+  /** Set built-in biquad filter applied to the voice after resampling (cutoff in Hz).
+   *  Filtered voices are processed side by side by the engine; AudioFilterType::None bypasses the stage */
+  virtual void setFilter(AudioFilterType type, double cutoff, double q, bool slew) = 0;
+
   /** Instructs platform to begin consuming sample data; invoking callback as needed */
   virtual void start() = 0;
 
   /** Instructs platform to stop consuming sample data */
   virtual void stop() = 0;
+
+  /** Query whether voice is consuming sample data (sample voices stop themselves at the sample end) */
+  virtual bool isRunning() const = 0;
+
+  /* Timestamped variants of the setters above. `frame` is an absolute engine frame
+   * (see IAudioVoiceEngine::getMixPosition()); the engine splits its mixing interval at that frame
+   * so the change lands sample-accurately regardless of block size. Frames already mixed apply
+   * at the start of the next block. Events at the same frame apply in the order scheduled */
+  virtual void startAt(uint64_t frame) = 0;
+  virtual void stopAt(uint64_t frame) = 0;
+  virtual void setPitchRatioAt(uint64_t frame, double ratio, bool slew) = 0;
+  virtual void setMonoChannelLevelsAt(uint64_t frame, IAudioSubmix* submix, const float coefs[8], bool slew) = 0;
+  virtual void setStereoChannelLevelsAt(uint64_t frame, IAudioSubmix* submix, const float coefs[8][2], bool slew) = 0;
+
+  /** Drop all pending timestamped events */
+  virtual void clearScheduledEvents() = 0;
 };
 
 struct IAudioVoiceCallback {
   /** boo calls this on behalf of the audio platform to proactively invoke potential
-   *  pitch or panning changes before processing samples */
+   *  pitch or panning changes before processing samples (once per block; blocks are split
+   *  at timestamped event frames, so dt may be shorter than 5ms) */
   virtual void preSupplyAudio(boo::IAudioVoice& voice, double dt) = 0;
 
   /** boo calls this on behalf of the audio platform to request more audio
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <memory>
 #include <string>
 #include <utility>
@@ -10,6 +12,7 @@
 #include "boo/audiodev/IAudioSubmix.hpp"
 #include "boo/audiodev/IAudioVoice.hpp"
 #include "boo/audiodev/IMIDIPort.hpp"
+#include "boo/audiodev/IMIDIReader.hpp"
 
 namespace boo {
 struct IAudioVoiceEngine;
@@ -35,14 +38,44 @@ struct IAudioVoiceEngine {
    *  ChannelLayout automatically reduces to maximum-supported layout by HW.
    *
    *  Client must be prepared to supply audio frames via the callback when this is called;
-   *  the backing audio-buffers are primed with initial data for low-latency playback start
+   *  the backing audio-buffers are primed with initial data for low-latency playback start.
+   *
+   *  AudioResamplerQuality::Fast swaps soxr for a lightweight interpolator; pitch changes
+   *  still take effect per 5ms block and slew the same way
    */
   virtual ObjToken<IAudioVoice> allocateNewMonoVoice(double sampleRate, IAudioVoiceCallback* cb,
-                                                     bool dynamicPitch = false) = 0;
+                                                     bool dynamicPitch = false,
+                                                     AudioResamplerQuality quality = AudioResamplerQuality::High) = 0;
 
   /** Same as allocateNewMonoVoice, but source audio is stereo-interleaved */
   virtual ObjToken<IAudioVoice> allocateNewStereoVoice(double sampleRate, IAudioVoiceCallback* cb,
-                                                       bool dynamicPitch = false) = 0;
+                                                       bool dynamicPitch = false,
+                                                       AudioResamplerQuality quality = AudioResamplerQuality::High) = 0;
+
+  /** Client calls this to allocate a voice that plays 16-bit PCM directly from client memory.
+   *  The engine interpolates the sample itself, so no IAudioVoiceCallback or soxr instance is needed
+   *  and pitch may always be adjusted. The data must stay valid while the voice exists.
+   *  A loop region is active when loopEnd > loopStart; otherwise the voice stops after the last frame.
+   *  With cacheResampled set, the sample is resampled to the device rate once and shared through the
+   *  engine's sample cache, so repeated plays of static sounds skip rate conversion entirely */
+  virtual ObjToken<IAudioVoice> allocateSampleVoice(const int16_t* pcm, size_t frames, unsigned channels,
+                                                    double sampleRate, size_t loopStart = 0, size_t loopEnd = 0,
+                                                    bool cacheResampled = false) = 0;
+
+  /** Same as allocateSampleVoice, but source is IMA ADPCM in WAV block layout (blockAlign bytes per block).
+   *  Blocks are decoded only as the voice reaches them */
+  virtual ObjToken<IAudioVoice> allocateIMASampleVoice(const uint8_t* data, size_t blockAlign, size_t frames,
+                                                       unsigned channels, double sampleRate, size_t loopStart = 0,
+                                                       size_t loopEnd = 0) = 0;
+
+  /** Same as allocateSampleVoice, but source is Nintendo DSP-ADPCM; each channel is a separate stream
+   *  of 8-byte frames channelStride bytes apart, and coefs holds 16 coefficients per channel */
+  virtual ObjToken<IAudioVoice> allocateDSPSampleVoice(const uint8_t* data, size_t channelStride, const int16_t* coefs,
+                                                       size_t frames, unsigned channels, double sampleRate,
+                                                       size_t loopStart = 0, size_t loopEnd = 0) = 0;
+
+  /** Set memory budget of the resampled-sample cache in bytes (0 disables caching) */
+  virtual void setSampleCacheBudget(size_t bytes) = 0;
 
   /** Client calls this to allocate a Submix for gathering audio together for effects processing */
   virtual ObjToken<IAudioSubmix> allocateNewSubmix(bool mainOut, IAudioSubmixCallback* cb, int busId) = 0;
@@ -95,11 +128,25 @@ struct IAudioVoiceEngine {
   /** Open named MIDI in/out port, name format depends on OS */
   virtual std::unique_ptr<IMIDIInOut> newRealMIDIInOut(const char* name, ReceiveFunctor&& receiver) = 0;
 
+  /** Deliver MIDI posted through newMIDIScheduleReceiver() to reader on the mixing thread, at the frame matching
+   *  its timestamp plus latency seconds (which should cover the time between pump cycles; later arrivals play at the
+   *  start of the next block). The mix is split at each message, so voice changes made by the reader are
+   *  sample-accurate. Pass nullptr to stop delivery */
+  virtual void setMIDIScheduleReader(IMIDIReader* reader, double latency = 0.01) = 0;
+
+  /** Lock-free, allocation-free receiver to pass when opening MIDI inputs whose messages should go to the schedule reader.
+   *  Each port needs its own receiver; SysEx is not scheduled */
+  virtual ReceiveFunctor newMIDIScheduleReceiver() = 0;
+
   /** If this returns true, MIDI callbacks are assumed to be *not* thread-safe; need protection via mutex */
   virtual bool useMIDILock() const = 0;
 
   /** Get canonical count of frames for each 5ms output block */
   virtual size_t get5MsFrames() const = 0;
+
+  /** Get count of frames mixed since the engine was created. During engine and voice callbacks
+   *  this is the first frame of the block being mixed; used to timestamp voice events */
+  virtual uint64_t getMixPosition() const = 0;
 };
 
 /** Construct host platform's voice engine */
@@ -111,4 +158,20 @@ std::unique_ptr<IAudioVoiceEngine> NewWAVAudioVoiceEngine(const char* path, doub
 std::unique_ptr<IAudioVoiceEngine> NewWAVAudioVoiceEngine(const wchar_t* path, double sampleRate, int numChans);
 #endif
 
+/** One independent offline render performed by RenderWAVJobs.
+ *  render is invoked on a worker thread with a freshly constructed WAV engine; it should
+ *  allocate its voices/submixes, call pumpAndMixVoices() as many times as needed and
+ *  release every token before returning. Jobs share no mixing state, so output is
+ *  identical to rendering the same job alone */
+struct WAVRenderJob {
+  std::string path;
+  double sampleRate = 48000.0;
+  int numChans = 2;
+  std::function<void(IAudioVoiceEngine&)> render;
+  bool succeeded = false; /**< Set once the file was opened and render returned */
+};
+
+/** Render all jobs across a pool of threadCount workers (hardware concurrency when 0) and wait for completion */
+void RenderWAVJobs(std::vector<WAVRenderJob>& jobs, unsigned threadCount = 0);
+
 } // namespace boo
@@ -3,13 +3,33 @@
 #include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "boo/audiodev/MIDIPacketRing.hpp"
+
 namespace boo {
 struct IAudioVoiceEngine;
+
+/** Invoked on the port's receive thread with each run of bytes read from the device.
+ *  Opening a port with an empty ReceiveFunctor delivers into a MIDIPacketRing instead,
+ *  which avoids the per-read vector allocation and cross-thread callback */
 using ReceiveFunctor = std::function<void(std::vector<uint8_t>&&, double time)>;
 
+/** Receiver that takes the bytes in place on the port's receive thread */
+struct IMIDIReceiveHook {
+  virtual ~IMIDIReceiveHook() = default;
+  virtual void receive(const uint8_t* data, size_t len, double time) = 0;
+};
+
+/** ReceiveFunctor target wrapping a hook. Ports opened with one call the hook directly from
+ *  IMIDIReceiver::_receive, so reads are never copied into a vector */
+struct MIDIReceiveHookFunctor {
+  std::shared_ptr<IMIDIReceiveHook> m_hook;
+  void operator()(std::vector<uint8_t>&& bytes, double time) const { m_hook->receive(bytes.data(), bytes.size(), time); }
+};
+
 class IMIDIPort {
   bool m_virtual;
 
@@ -25,9 +45,30 @@ public:
 };
 
 class IMIDIReceiver {
+  std::unique_ptr<MIDIPacketRing> m_ring;
+  IMIDIReceiveHook* m_hook = nullptr;
+
 public:
   ReceiveFunctor m_receiver;
-  IMIDIReceiver(ReceiveFunctor&& receiver) : m_receiver(std::move(receiver)) {}
+  IMIDIReceiver(ReceiveFunctor&& receiver) : m_receiver(std::move(receiver)) {
+    if (!m_receiver)
+      m_ring = std::make_unique<MIDIPacketRing>();
+    else if (const auto* hook = m_receiver.target<MIDIReceiveHookFunctor>())
+      m_hook = hook->m_hook.get();
+  }
+
+  /** Ring of received packets when opened without a ReceiveFunctor, otherwise nullptr */
+  MIDIPacketRing* packetRing() const { return m_ring.get(); }
+
+  /** Called by backends from the receive thread */
+  void _receive(const uint8_t* data, size_t len, double time) {
+    if (m_ring)
+      m_ring->push(data, len, time);
+    else if (m_hook)
+      m_hook->receive(data, len, time);
+    else
+      m_receiver(std::vector<uint8_t>(data, data + len), time);
+  }
 };
 
 class IMIDIIn : public IMIDIPort, public IMIDIReceiver {
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <span>
 #include <vector>
 
 namespace boo {
@@ -12,8 +13,22 @@ class MIDIDecoder {
 
 public:
   MIDIDecoder(IMIDIReader& out) : m_out(out) {}
+
+  /** Decode bytes, dispatching each complete message to the reader (running status is kept across calls).
+   *  Returns the start of a trailing incomplete message, or end; prepend those bytes to the next call */
+  const uint8_t* receiveBytes(const uint8_t* begin, const uint8_t* end);
+
+  /** Same as above, returning the number of bytes consumed */
+  size_t receiveBytes(std::span<const uint8_t> bytes) {
+    return size_t(receiveBytes(bytes.data(), bytes.data() + bytes.size()) - bytes.data());
+  }
+
   std::vector<uint8_t>::const_iterator receiveBytes(std::vector<uint8_t>::const_iterator begin,
-                                                    std::vector<uint8_t>::const_iterator end);
+                                                    std::vector<uint8_t>::const_iterator end) {
+    if (begin == end)
+      return begin;
+    return begin + (receiveBytes(&*begin, &*begin + (end - begin)) - &*begin);
+  }
 };
 
 } // namespace boo
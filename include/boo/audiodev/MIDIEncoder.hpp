@@ -1,5 +1,7 @@
 #pragma once
 
+#include <array>
+#include <cstddef>
 #include <cstdint>
 #include <iterator>
 
@@ -12,6 +14,12 @@ class MIDIEncoder : public IMIDIReader {
   Sender& m_sender;
   uint8_t m_status = 0;
 
+  /* Buffered mode accumulates output for a single send() per flush */
+  bool m_buffered;
+  size_t m_bufferLen = 0;
+  std::array<uint8_t, 512> m_buffer;
+
+  void _send(const void* data, size_t len);
   void _sendMessage(const uint8_t* data, size_t len);
 
   template <typename ContiguousContainer>
@@ -22,7 +30,15 @@ class MIDIEncoder : public IMIDIReader {
   void _sendContinuedValue(uint32_t val);
 
 public:
-  MIDIEncoder(Sender& sender) : m_sender(sender) {}
+  /** With buffered set, messages are held (running status still applies) until the buffer fills
+   *  or flush() is called; flush once per audio block, e.g. from onPumpCycleComplete */
+  MIDIEncoder(Sender& sender, bool buffered = false) : m_sender(sender), m_buffered(buffered) {}
+
+  /** Sends whatever is still buffered; the sender must outlive the encoder */
+  ~MIDIEncoder() { flush(); }
+
+  /** Send all buffered bytes in one write */
+  void flush();
 
   void noteOff(uint8_t chan, uint8_t key, uint8_t velocity) override;
   void noteOn(uint8_t chan, uint8_t key, uint8_t velocity) override;
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace boo {
+class IMIDIReader;
+
+/** Standard MIDI File (format 0/1/2) decoded up front for sequencer playback.
+ *  Tracks are decoded in parallel and merged into one flat, time-ordered event array with
+ *  timestamps already tempo-mapped to seconds; SysEx payloads are referenced in place.
+ *  Format 2 sequences are merged as if they were format 1 tracks.
+ *  Playback dispatches through IMIDIReader without allocating; seek is a binary search plus
+ *  an optional controller chase from the nearest checkpoint */
+class MIDIFile {
+public:
+  struct Event {
+    double m_time;      /**< Seconds from the start of the file */
+    uint32_t m_payload; /**< data1 | data2 << 8, or for SysEx the file offset of its length-prefixed payload */
+    uint16_t m_track;
+    uint8_t m_status; /**< Channel status byte, or 0xF0/0xF7 for SysEx */
+  };
+
+private:
+  struct Mapping;
+  std::unique_ptr<Mapping> m_mapping;
+  std::vector<uint8_t> m_ownedData;
+  const uint8_t* m_data = nullptr;
+  size_t m_size = 0;
+
+  uint16_t m_format = 0;
+  uint16_t m_trackCount = 0;
+  std::vector<Event> m_events;
+  double m_duration = 0.0;
+
+  /* Channel state (program, pitch bend, controllers) before every CheckpointInterval-th event */
+  static constexpr size_t CheckpointInterval = 512;
+  struct ChannelState {
+    uint8_t m_program = 0xff;
+    uint16_t m_bend = 0xffff;
+    uint8_t m_controllers[128];
+    ChannelState();
+  };
+  std::vector<ChannelState> m_checkpoints; /* 16 per checkpoint */
+
+  size_t m_cursor = 0;
+
+  bool _parse();
+  void _buildCheckpoints();
+  static void _applyState(ChannelState* channels, const Event& ev);
+  void _dispatch(const Event& ev, IMIDIReader& out) const;
+
+public:
+  MIDIFile();
+  ~MIDIFile();
+  MIDIFile(MIDIFile&&) noexcept;
+  MIDIFile& operator=(MIDIFile&&) noexcept;
+
+  /** Memory-map and decode the file at path; returns false (and logs) on failure */
+  bool open(const char* path);
+
+  /** Decode an SMF image held in memory (the data is copied) */
+  bool load(std::span<const uint8_t> data);
+
+  void close();
+  bool isOpen() const { return m_data != nullptr; }
+
+  uint16_t format() const { return m_format; }
+  uint16_t trackCount() const { return m_trackCount; }
+  double duration() const { return m_duration; }
+  std::span<const Event> events() const { return m_events; }
+
+  /** Move the playback cursor to the first event at or after time.
+   *  If chase is provided it receives the state in effect at that point for each channel: bank select,
+   *  program, the remaining controllers (channel mode messages excluded), then pitch bend */
+  void seek(double time, IMIDIReader* chase = nullptr);
+
+  /** Dispatch events before `until` (seconds) from the cursor onward; returns the number dispatched */
+  size_t play(double until, IMIDIReader& out);
+
+  /** Time of the next event to be played, or duration() at the end */
+  double nextEventTime() const { return m_cursor < m_events.size() ? m_events[m_cursor].m_time : m_duration; }
+};
+
+} // namespace boo
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#undef min
+#undef max
+
+namespace boo {
+
+/** Timestamped run of raw MIDI bytes as delivered by the OS (time in seconds, backend clock) */
+struct MIDIPacket {
+  static constexpr size_t MaxBytes = 52; /* Packs the struct into 64 bytes */
+
+  double m_time = 0.0;
+  uint32_t m_length = 0;
+  uint8_t m_data[MaxBytes];
+
+  const uint8_t* begin() const { return m_data; }
+  const uint8_t* end() const { return m_data + m_length; }
+};
+
+/** Preallocated single-producer/single-consumer ring of MIDIPackets.
+ *  The port's receive thread pushes, one client thread (typically the audio thread) drains;
+ *  neither side locks or touches the heap. Packets arriving while the ring is full are dropped and counted */
+class MIDIPacketRing {
+public:
+  static constexpr size_t Capacity = 256;
+
+private:
+  std::array<MIDIPacket, Capacity> m_packets;
+  alignas(64) std::atomic<size_t> m_writeIdx{0};
+  alignas(64) std::atomic<size_t> m_readIdx{0};
+  std::atomic<size_t> m_dropped{0};
+
+public:
+  /** Producer side; bytes longer than MIDIPacket::MaxBytes span consecutive packets.
+   *  Returns false if the ring overflowed */
+  bool push(const uint8_t* data, size_t len, double time) {
+    size_t w = m_writeIdx.load(std::memory_order_relaxed);
+    const size_t r = m_readIdx.load(std::memory_order_acquire);
+    while (len) {
+      if (w - r == Capacity) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        break;
+      }
+      MIDIPacket& pkt = m_packets[w % Capacity];
+      pkt.m_time = time;
+      pkt.m_length = uint32_t(std::min(len, MIDIPacket::MaxBytes));
+      std::memcpy(pkt.m_data, data, pkt.m_length);
+      data += pkt.m_length;
+      len -= pkt.m_length;
+      ++w;
+    }
+    m_writeIdx.store(w, std::memory_order_release);
+    return len == 0;
+  }
+
+  /** Consumer side; invokes f(const MIDIPacket&) for every pending packet in arrival order
+   *  and returns the number of packets drained */
+  template <typename Func>
+  size_t drain(Func&& f) {
+    const size_t r = m_readIdx.load(std::memory_order_relaxed);
+    const size_t w = m_writeIdx.load(std::memory_order_acquire);
+    for (size_t i = r; i != w; ++i)
+      f(m_packets[i % Capacity]);
+    m_readIdx.store(w, std::memory_order_release);
+    return w - r;
+  }
+
+  bool empty() const {
+    return m_readIdx.load(std::memory_order_relaxed) == m_writeIdx.load(std::memory_order_acquire);
+  }
+
+  /** Total packets lost to overflow since the port was opened */
+  size_t droppedPackets() const { return m_dropped.load(std::memory_order_relaxed); }
+};
+
+} // namespace boo
@@ -6,6 +6,7 @@
 #include "inputdev/DeviceFinder.hpp"
 #include "inputdev/DolphinSmashAdapter.hpp"
 #include "inputdev/DualshockPad.hpp"
+#include "inputdev/EvdevPad.hpp"
 #include "inputdev/GenericPad.hpp"
 #include "inputdev/NintendoPowerA.hpp"
 #include "graphicsdev/IGraphicsCommandQueue.hpp"
@@ -8,6 +8,7 @@
 #include <vector>
 
 #include "boo/System.hpp"
+#include "boo/inputdev/InputHistory.hpp"
 
 #if _WIN32
 #include <hidsdi.h>
@@ -23,12 +24,17 @@ class DeviceBase : public std::enable_shared_from_this<DeviceBase> {
   friend class DeviceToken;
   friend struct DeviceSignature;
   friend class HIDDeviceIOKit;
+  friend class IHIDDevice;
 
   uint64_t m_typeHash;
   class DeviceToken* m_token;
   std::shared_ptr<IHIDDevice> m_hidDev;
+  InputClock::time_point m_reportTime{}; /* Stamped by backends that read at the syscall boundary */
   void _deviceDisconnected();
 
+protected:
+  InputLatencyStats m_pollLatency;
+
 public:
   DeviceBase(uint64_t typeHash, DeviceToken* token);
   virtual ~DeviceBase() = default;
@@ -48,12 +54,24 @@ public:
   }
   virtual void initialCycle() {}
   virtual void transferCycle() {}
+  /** Runs after the last report, on the reader or once it has stopped; the place to publish a final state */
   virtual void finalCycle() {}
 
   /* Low-Level API */
   bool sendUSBInterruptTransfer(const uint8_t* data, size_t length);
+  /** During a transferCycle run for a completed IN transfer (udev), takes that transfer's payload.
+   *  Anywhere else it reads the endpoint directly, blocking for up to a short timeout */
   size_t receiveUSBInterruptTransfer(uint8_t* data, size_t length);
 
+  /** Arrival time of the report or transfer being processed; falls back to now for backends that don't stamp */
+  InputClock::time_point reportTime() const {
+    return m_reportTime.time_since_epoch().count() ? m_reportTime : InputClock::now();
+  }
+
+  /** Report arrival to consumption through the device's polling accessor */
+  const InputLatencyStats& pollLatency() const { return m_pollLatency; }
+  void resetPollLatency() { m_pollLatency.reset(); }
+
   inline unsigned getVendorId() const;
   inline unsigned getProductId() const;
   inline std::string_view getVendorName() const;
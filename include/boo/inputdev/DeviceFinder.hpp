@@ -7,7 +7,9 @@
 
 #include "boo/inputdev/DeviceSignature.hpp"
 #include "boo/inputdev/DeviceToken.hpp"
+#include "boo/inputdev/HIDCapture.hpp"
 #include "boo/inputdev/IHIDListener.hpp"
+#include "boo/inputdev/InputHistory.hpp"
 
 #ifdef _WIN32
 #ifndef WIN32_LEAN_AND_MEAN
@@ -39,12 +41,15 @@ private:
   TDeviceTokens m_tokens;
   std::mutex m_tokensLock;
 
+  /* Listener first seeing a device to its deviceConnected returning */
+  InputLatencyStats m_arrivalLatency;
+
   /* Friend methods for platform-listener to find/insert/remove
    * tokens with type-filtering */
   bool _hasToken(const std::string& path) const {
     return m_tokens.find(path) != m_tokens.end();
   }
-  bool _insertToken(std::unique_ptr<DeviceToken>&& token);
+  bool _insertToken(std::unique_ptr<DeviceToken>&& token, InputClock::time_point arrival = InputClock::now());
   void _removeToken(const std::string& path);
 
 public:
@@ -79,6 +84,18 @@ public:
   /* Manual device scanning */
   bool scanNow();
 
+  /** Connect a virtual device that replays a capture recorded with SetHIDCaptureDirectory.
+   *  It is matched against the interested types like hardware, through deviceConnected.
+   *  A recorded unplug only ends the replay (or restarts it when looping); the device stays connected,
+   *  holding its last state, until removeReplayDevice or closeDevice */
+  bool addReplayDevice(const char* capturePath, const HIDReplayOptions& options = {});
+  void removeReplayDevice(const char* capturePath);
+
+  /** Time from a listener seeing each device (hotplug event, or the start of the scan that found it)
+   *  until deviceConnected returned for it */
+  const InputLatencyStats& arrivalLatency() const { return m_arrivalLatency; }
+  void resetArrivalLatency() { m_arrivalLatency.reset(); }
+
   virtual void deviceConnected(DeviceToken&) {}
   virtual void deviceDisconnected(DeviceToken&, DeviceBase*) {}
 
@@ -9,7 +9,7 @@
 
 namespace boo {
 
-enum class DeviceType { None = 0, USB = 1, Bluetooth = 2, HID = 3, XInput = 4 };
+enum class DeviceType { None = 0, USB = 1, Bluetooth = 2, HID = 3, XInput = 4, Evdev = 5 };
 
 class DeviceToken;
 class DeviceBase;
@@ -32,6 +32,10 @@ struct DeviceSignature {
   : m_name(name), m_typeHash(typeHash), m_vid(vid), m_pid(pid), m_factory(factory), m_type(type) {}
   static bool DeviceMatchToken(const DeviceToken& token, const TDeviceSignatureSet& sigSet);
   static std::shared_ptr<DeviceBase> DeviceNew(DeviceToken& token);
+
+  /** Signature of the dedicated device class for vid/pid, or null for generic devices.
+   *  Looked up through a hash index of BOO_DEVICE_SIGS built on first use */
+  static const DeviceSignature* Find(unsigned vid, unsigned pid);
 };
 
 #define DEVICE_SIG(name, vid, pid, type)                                                                               \
@@ -6,6 +6,8 @@
 
 #include "boo/System.hpp"
 #include "boo/inputdev/DeviceBase.hpp"
+#include "boo/inputdev/InputHistory.hpp"
+#include "boo/inputdev/TripleBuffer.hpp"
 
 namespace boo {
 
@@ -46,6 +48,12 @@ struct DolphinControllerState {
   void clamp();
 };
 
+/** All four adapter ports as of one payload; ports without a controller have type None */
+struct DolphinSmashAdapterState {
+  std::array<EDolphinControllerType, 4> m_types{};
+  std::array<DolphinControllerState, 4> m_states{};
+};
+
 struct IDolphinSmashAdapterCallback {
   virtual void controllerConnected([[maybe_unused]] unsigned idx, [[maybe_unused]] EDolphinControllerType type) {}
   virtual void controllerDisconnected([[maybe_unused]] unsigned idx) {}
@@ -61,6 +69,8 @@ class DolphinSmashAdapter final : public TDeviceBase<IDolphinSmashAdapterCallbac
   uint8_t m_rumbleRequest = 0;
   std::array<bool, 4> m_hardStop{};
   uint8_t m_rumbleState = 0xf; /* Force initial send of stop-rumble command */
+  TripleBuffer<TimedState<DolphinSmashAdapterState>> m_latestState;
+  InputHistory<DolphinSmashAdapterState> m_history;
   void deviceDisconnected() override;
   void initialCycle() override;
   void transferCycle() override;
@@ -70,6 +80,25 @@ public:
   DolphinSmashAdapter(DeviceToken* token);
   ~DolphinSmashAdapter() override;
 
+  /** Process one 37-byte adapter payload as received by transferCycle (public for replay and benchmarking) */
+  void receivedPayload(const uint8_t* payload, size_t length);
+
+  /** Newest parsed state for one polling thread; wait-free and independent of the callback */
+  const DolphinSmashAdapterState& latestState() {
+    if (m_latestState.update())
+      m_pollLatency.record(m_latestState.front().m_time);
+    return m_latestState.front().m_state;
+  }
+
+  /** Arrival time of the state last returned by latestState() */
+  InputClock::time_point latestStateTime() const { return m_latestState.front().m_time; }
+
+  /** Append the retained states that arrived in [begin, end), oldest first */
+  size_t queryHistory(InputClock::time_point begin, InputClock::time_point end,
+                      std::vector<TimedState<DolphinSmashAdapterState>>& out) const {
+    return m_history.query(begin, end, out);
+  }
+
   void setCallback(IDolphinSmashAdapterCallback* cb) {
     TDeviceBase<IDolphinSmashAdapterCallback>::setCallback(cb);
     m_knownControllers = 0;
@@ -4,6 +4,8 @@
 
 #include "boo/System.hpp"
 #include "boo/inputdev/DeviceBase.hpp"
+#include "boo/inputdev/InputHistory.hpp"
+#include "boo/inputdev/TripleBuffer.hpp"
 
 namespace boo {
 
@@ -113,6 +115,8 @@ class DualshockPad final : public TDeviceBase<IDualshockPadCallback> {
   uint8_t m_rumbleIntensity[2];
   EDualshockLED m_led;
   DualshockOutReport m_report;
+  TripleBuffer<TimedState<DualshockPadState>> m_latestState;
+  InputHistory<DualshockPadState> m_history;
   void deviceDisconnected() override;
   void initialCycle() override;
   void transferCycle() override;
@@ -137,6 +141,22 @@ public:
 
   void stopRumble(int motor) { m_rumbleRequest &= ~EDualshockMotor(motor); }
 
+  /** Newest parsed state for one polling thread; wait-free and independent of the callback */
+  const DualshockPadState& latestState() {
+    if (m_latestState.update())
+      m_pollLatency.record(m_latestState.front().m_time);
+    return m_latestState.front().m_state;
+  }
+
+  /** Arrival time of the state last returned by latestState() */
+  InputClock::time_point latestStateTime() const { return m_latestState.front().m_time; }
+
+  /** Append the retained states that arrived in [begin, end), oldest first */
+  size_t queryHistory(InputClock::time_point begin, InputClock::time_point end,
+                      std::vector<TimedState<DualshockPadState>>& out) const {
+    return m_history.query(begin, end, out);
+  }
+
   EDualshockLED getLED() const { return m_led; }
 
   void setLED(EDualshockLED led, bool on = true) {
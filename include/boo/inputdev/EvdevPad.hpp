@@ -0,0 +1,139 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "boo/System.hpp"
+#include "boo/inputdev/DeviceBase.hpp"
+#include "boo/inputdev/InputHistory.hpp"
+#include "boo/inputdev/TripleBuffer.hpp"
+
+namespace boo {
+
+/** One kernel input event (linux/input.h input_event without its timestamp).
+ *  Evdev devices deliver each SYN_REPORT-terminated frame of these as a single input report */
+struct EvdevEvent {
+  uint16_t m_type;
+  uint16_t m_code;
+  int32_t m_value;
+};
+
+/** Range of an absolute axis, laid out as linux/input.h input_absinfo.
+ *  Read as the feature report whose message is the ABS_* code */
+struct EvdevAxisInfo {
+  int32_t m_value;
+  int32_t m_minimum;
+  int32_t m_maximum;
+  int32_t m_fuzz;
+  int32_t m_flat;
+  int32_t m_resolution;
+};
+
+/** Bits 0-31 are BTN_JOYSTICK + n (BTN_TRIGGER through BTN_THUMBR), bits 32-35 the BTN_DPAD_* keys */
+enum class EEvdevPadButtons : uint64_t {
+  None = 0,
+  South = uint64_t(1) << 16,
+  East = uint64_t(1) << 17,
+  C = uint64_t(1) << 18,
+  North = uint64_t(1) << 19,
+  West = uint64_t(1) << 20,
+  Z = uint64_t(1) << 21,
+  TL = uint64_t(1) << 22,
+  TR = uint64_t(1) << 23,
+  TL2 = uint64_t(1) << 24,
+  TR2 = uint64_t(1) << 25,
+  Select = uint64_t(1) << 26,
+  Start = uint64_t(1) << 27,
+  Mode = uint64_t(1) << 28,
+  ThumbL = uint64_t(1) << 29,
+  ThumbR = uint64_t(1) << 30,
+  DPadUp = uint64_t(1) << 32,
+  DPadDown = uint64_t(1) << 33,
+  DPadLeft = uint64_t(1) << 34,
+  DPadRight = uint64_t(1) << 35,
+};
+ENABLE_BITWISE_ENUM(EEvdevPadButtons)
+
+/** Absolute axes, numbered by ABS_* code */
+enum class EEvdevPadAxis : uint8_t {
+  X = 0x00,
+  Y = 0x01,
+  Z = 0x02,
+  RX = 0x03,
+  RY = 0x04,
+  RZ = 0x05,
+  Throttle = 0x06,
+  Rudder = 0x07,
+  Wheel = 0x08,
+  Gas = 0x09,
+  Brake = 0x0a,
+  Hat0X = 0x10,
+  Hat0Y = 0x11,
+  Hat1X = 0x12,
+  Hat1Y = 0x13,
+  Hat2X = 0x14,
+  Hat2Y = 0x15,
+  Hat3X = 0x16,
+  Hat3Y = 0x17,
+  Count = 0x18,
+};
+
+struct EvdevPadState {
+  EEvdevPadButtons m_buttons = EEvdevPadButtons::None;
+  std::array<int32_t, size_t(EEvdevPadAxis::Count)> m_axes{};
+
+  bool pressed(EEvdevPadButtons button) const { return True(m_buttons & button); }
+  int32_t axis(EEvdevPadAxis axis) const { return m_axes[size_t(axis)]; }
+  bool operator==(const EvdevPadState& other) const = default;
+};
+
+class EvdevPad;
+struct IEvdevPadCallback {
+  virtual void controllerConnected() {}
+  virtual void controllerDisconnected() {}
+  /** Called once per SYN_REPORT frame that changed the state */
+  virtual void controllerUpdate(EvdevPad& pad, const EvdevPadState& state) {}
+};
+
+/** Gamepad or joystick driven by its kernel driver through an evdev node (Linux only) */
+class EvdevPad final : public TDeviceBase<IEvdevPadCallback> {
+  std::array<EvdevAxisInfo, size_t(EEvdevPadAxis::Count)> m_axisInfo{};
+  EvdevPadState m_last{};
+  TripleBuffer<TimedState<EvdevPadState>> m_latestState;
+  InputHistory<EvdevPadState> m_history;
+  void deviceDisconnected() override;
+  void initialCycle() override;
+  void finalCycle() override;
+  void receivedHIDReport(const uint8_t* data, size_t length, HIDReportType tp, uint32_t message) override;
+
+public:
+  explicit EvdevPad(DeviceToken* token);
+  ~EvdevPad() override;
+
+  /** Range reported by the driver for axis; all zero for axes the device lacks.
+   *  Valid once the controller has connected */
+  const EvdevAxisInfo& axisInfo(EEvdevPadAxis axis) const { return m_axisInfo[size_t(axis)]; }
+
+  /** axis of state scaled to [-1, 1] over its reported range, or 0 for axes the device lacks */
+  float normalizedAxis(const EvdevPadState& state, EEvdevPadAxis axis) const;
+
+  /** Newest state for one polling thread; wait-free and independent of the callback */
+  const EvdevPadState& latestState() {
+    if (m_latestState.update())
+      m_pollLatency.record(m_latestState.front().m_time);
+    return m_latestState.front().m_state;
+  }
+
+  /** Arrival time of the state last returned by latestState() */
+  InputClock::time_point latestStateTime() const { return m_latestState.front().m_time; }
+
+  /** Append the retained states that arrived in [begin, end), oldest first.
+   *  An entry is recorded for every frame, changed or not */
+  size_t queryHistory(InputClock::time_point begin, InputClock::time_point end,
+                      std::vector<TimedState<EvdevPadState>>& out) const {
+    return m_history.query(begin, end, out);
+  }
+};
+
+} // namespace boo
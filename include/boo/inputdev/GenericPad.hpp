@@ -1,20 +1,41 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <functional>
+#include <span>
+#include <vector>
 
 #include "boo/inputdev/DeviceBase.hpp"
 #include "boo/inputdev/HIDParser.hpp"
+#include "boo/inputdev/InputHistory.hpp"
+#include "boo/inputdev/TripleBuffer.hpp"
 
 namespace boo {
 
 struct IGenericPadCallback {
   virtual void controllerConnected() {}
   virtual void controllerDisconnected() {}
+
+  /** Called for each value that changed since the previous report (every value on first arrival) */
   virtual void valueUpdate(const HIDMainItem& item, int32_t value) {}
+
+  /** Called once per report that changed anything, after any valueUpdate calls.
+   *  Bit (slot % 64) of changed[slot / 64] is set for each changed value slot; values holds every slot */
+  virtual void valuesChanged(std::span<const uint64_t> changed, std::span<const int32_t> values) {}
 };
 
 class GenericPad final : public TDeviceBase<IGenericPadCallback> {
   HIDParser m_parser;
+  std::atomic_bool m_batchedUpdates = false;
+
+  /* Indexed by HIDParser value slot; owned by the device thread */
+  std::vector<int32_t> m_values;
+  std::vector<int32_t> m_decoded;
+  std::vector<uint64_t> m_received;
+  std::vector<uint64_t> m_changed;
+  TripleBuffer<TimedState<std::vector<int32_t>>> m_latestState;
+  InputHistory<std::vector<int32_t>> m_history;
 
 public:
   GenericPad(DeviceToken* token);
@@ -25,6 +46,31 @@ public:
   void receivedHIDReport(const uint8_t* data, size_t length, HIDReportType tp, uint32_t message) override;
 
   void enumerateValues(const std::function<bool(const HIDMainItem& item)>& valueCB) const;
+
+  /** Deliver changes through valuesChanged only, skipping the per-value valueUpdate calls */
+  void setBatchedUpdates(bool batched) { m_batchedUpdates = batched; }
+
+  /** Value slots in enumerateValues order, valid once the controller has connected */
+  size_t valueCount() const { return m_parser.GetValueCount(); }
+  const HIDMainItem& valueItem(size_t slot) const { return m_parser.GetValueItem(slot); }
+
+  /** Latest value of every slot for one polling thread, instead of (or alongside) callbacks.
+   *  Wait-free; the reference stays valid until the next call */
+  const std::vector<int32_t>& snapshot() {
+    if (m_latestState.update())
+      m_pollLatency.record(m_latestState.front().m_time);
+    return m_latestState.front().m_state;
+  }
+
+  /** Arrival time of the values last returned by snapshot() */
+  InputClock::time_point snapshotTime() const { return m_latestState.front().m_time; }
+
+  /** Append the retained value sets that arrived in [begin, end), oldest first.
+   *  An entry is recorded for every input report, changed or not */
+  size_t queryHistory(InputClock::time_point begin, InputClock::time_point end,
+                      std::vector<TimedState<std::vector<int32_t>>>& out) const {
+    return m_history.query(begin, end, out);
+  }
 };
 
 } // namespace boo
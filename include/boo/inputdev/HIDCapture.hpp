@@ -0,0 +1,18 @@
+#pragma once
+
+#include <string_view>
+
+namespace boo {
+
+/** Record the raw traffic (report descriptor, input reports, interrupt transfers and feature reads)
+ *  of every device opened from now on into dir, one .bhc capture file per device.
+ *  An empty dir stops recording newly opened devices. Captures are made by the udev backend */
+void SetHIDCaptureDirectory(std::string_view dir);
+
+/** Playback of a capture added through DeviceFinder::addReplayDevice */
+struct HIDReplayOptions {
+  double m_speed = 1.0; /**< Rate relative to the recorded timing; 0 replays as fast as possible */
+  bool m_loop = false;  /**< Restart from the first report after the last one */
+};
+
+} // namespace boo
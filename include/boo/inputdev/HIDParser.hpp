@@ -4,7 +4,6 @@
 #include <cstdint>
 #include <functional>
 #include <memory>
-#include <stack>
 #include <utility>
 #include <vector>
 
@@ -16,8 +15,6 @@
 
 namespace boo {
 struct HIDItemState;
-struct HIDCollectionItem;
-struct HIDReports;
 
 enum class HIDUsagePage : uint8_t {
   Undefined = 0,
@@ -173,23 +170,60 @@ public:
 private:
   ParserStatus m_status = ParserStatus::OK;
 #if _WIN32
-#if !WINDOWS_STORE
   std::vector<HIDMainItem> m_itemPool;
+#if !WINDOWS_STORE
   mutable std::vector<HIDP_DATA> m_dataList;
   PHIDP_PREPARSED_DATA m_descriptorData = nullptr;
 #endif
+  /* Value slot -> item pool index, in EnumerateValues order */
+  std::unique_ptr<uint32_t[]> m_valueItems;
+  uint32_t m_valueCount = 0;
 #else
-  std::unique_ptr<HIDMainItem[]> m_itemPool;
   using Report = std::pair<uint32_t, std::pair<uint32_t, uint32_t>>;
-  std::unique_ptr<Report[]> m_reportPool;
-  std::pair<uint32_t, uint32_t> m_inputReports = {};
-  std::pair<uint32_t, uint32_t> m_outputReports = {};
-  std::pair<uint32_t, uint32_t> m_featureReports = {};
-  bool m_multipleReports = false;
-  static ParserStatus ParseItem(HIDReports& reportsOut, std::stack<HIDItemState>& stateStack,
-                                std::stack<HIDCollectionItem>& collectionStack, const uint8_t*& it, const uint8_t* end,
-                                bool& multipleReports);
+
+  /* Input reports compiled at parse time into flat extraction plans.
+   * An op is either a single bit field or a run of byte-aligned 8/16-bit fields */
+  struct ExtractOp {
+    uint32_t m_byteOffset;
+    uint32_t m_value;   /* First output slot */
+    uint32_t m_mask;
+    uint32_t m_signBit; /* 0 for unsigned fields */
+    uint8_t m_shift;
+    uint8_t m_width;  /* Element size in bytes for runs, 0 for bit fields */
+    uint16_t m_count; /* Elements in a run */
+  };
+  struct InputPlan {
+    uint32_t m_reportId;
+    std::pair<uint32_t, uint32_t> m_ops;
+    std::pair<uint32_t, uint32_t> m_values;
+    uint32_t m_length; /* Bytes spanned by every field */
+  };
+
+  /* Everything derived from one report descriptor in a single pass. Immutable once built and shared
+   * by every parser of identical descriptor bytes; the pools are carved from one arena allocation */
+  struct Layout {
+    ParserStatus m_status = ParserStatus::OK;
+    std::unique_ptr<uint8_t[]> m_arena;
+    HIDMainItem* m_itemPool = nullptr;
+    Report* m_reportPool = nullptr;
+    ExtractOp* m_opPool = nullptr;
+    InputPlan* m_inputPlans = nullptr;
+    uint32_t* m_valueItems = nullptr; /* Value slot -> item pool index, in EnumerateValues order */
+    std::pair<uint32_t, uint32_t> m_inputReports = {};
+    std::pair<uint32_t, uint32_t> m_outputReports = {};
+    std::pair<uint32_t, uint32_t> m_featureReports = {};
+    uint32_t m_valueCount = 0;
+    bool m_multipleReports = false;
+    size_t m_maxInputReportSize = 0;
+    std::pair<HIDUsagePage, HIDUsage> m_applicationUsage = {};
+  };
+  std::shared_ptr<const Layout> m_layout;
+
+  static std::shared_ptr<const Layout> _getLayout(const uint8_t* descriptorData, size_t len);
+  static std::shared_ptr<const Layout> _buildLayout(const uint8_t* descriptorData, size_t len);
+  static void _compileInputPlans(Layout& layout);
 #endif
+  mutable std::unique_ptr<int32_t[]> m_scanValues;
 
 public:
 #if _WIN32
@@ -198,6 +232,8 @@ public:
 #endif
 #else
   ParserStatus Parse(const uint8_t* descriptorData, size_t len);
+
+  /* Parses are cached by descriptor contents, so these and Parse share one parse per distinct descriptor */
   static size_t CalculateMaxInputReportSize(const uint8_t* descriptorData, size_t len);
   static std::pair<HIDUsagePage, HIDUsage> GetApplicationUsage(const uint8_t* descriptorData, size_t len);
 #endif
@@ -205,6 +241,19 @@ public:
   void EnumerateValues(const std::function<bool(const HIDMainItem& item)>& valueCB) const;
   void ScanValues(const std::function<bool(const HIDMainItem& item, int32_t value)>& valueCB, const uint8_t* data,
                   size_t len) const;
+
+  /** Number of non-constant input values; slots are numbered in EnumerateValues order */
+#if _WIN32
+  size_t GetValueCount() const { return m_valueCount; }
+  const HIDMainItem& GetValueItem(size_t slot) const { return m_itemPool[m_valueItems[slot]]; }
+#else
+  size_t GetValueCount() const { return m_layout ? m_layout->m_valueCount : 0; }
+  const HIDMainItem& GetValueItem(size_t slot) const { return m_layout->m_itemPool[m_layout->m_valueItems[slot]]; }
+#endif
+
+  /** Decode an input report into a caller-provided array of GetValueCount() values without allocating.
+   *  Returns the [first, last) slot range the report carried; empty if it matched no input report */
+  std::pair<uint32_t, uint32_t> DecodeValues(const uint8_t* data, size_t len, int32_t* values) const;
 };
 
 } // namespace boo
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#undef min
+#undef max
+
+namespace boo {
+
+/** Input timestamps use the monotonic clock (CLOCK_MONOTONIC on Linux) */
+using InputClock = std::chrono::steady_clock;
+
+/** Parsed device state tagged with the time its report arrived */
+template <typename T>
+struct TimedState {
+  InputClock::time_point m_time{};
+  T m_state{};
+};
+
+/** Fixed-size ring of the most recent Capacity parsed states of one device, for latency analysis
+ *  and rollback. The device thread records; any thread may query. The lock is only held while
+ *  copying entries, never across callbacks */
+template <typename T, size_t Capacity = 256>
+class InputHistory {
+  mutable std::mutex m_lock;
+  std::array<TimedState<T>, Capacity> m_entries;
+  size_t m_written = 0;
+
+public:
+  void record(InputClock::time_point time, const T& state) {
+    std::lock_guard lk(m_lock);
+    TimedState<T>& entry = m_entries[m_written++ % Capacity];
+    entry.m_time = time;
+    entry.m_state = state;
+  }
+
+  /** Append retained entries with begin <= m_time < end to out, oldest first; returns the number appended */
+  size_t query(InputClock::time_point begin, InputClock::time_point end, std::vector<TimedState<T>>& out) const {
+    std::lock_guard lk(m_lock);
+    const size_t first = m_written - std::min(m_written, Capacity);
+    const size_t prevSize = out.size();
+    for (size_t i = first; i < m_written; ++i) {
+      const TimedState<T>& entry = m_entries[i % Capacity];
+      if (entry.m_time >= end)
+        break;
+      if (entry.m_time >= begin)
+        out.push_back(entry);
+    }
+    return out.size() - prevSize;
+  }
+
+  /** Total states recorded, including those since overwritten */
+  size_t recorded() const {
+    std::lock_guard lk(m_lock);
+    return m_written;
+  }
+};
+
+/** Histogram of report arrival to consumption by the game, in power-of-two microsecond buckets.
+ *  Recorded by the consuming thread, readable from any thread */
+class InputLatencyStats {
+public:
+  static constexpr size_t Buckets = 21; /* Bucket i counts latencies below 2^i us; the last holds the rest */
+
+  struct Summary {
+    uint64_t m_count = 0;
+    uint64_t m_totalNs = 0;
+    uint64_t m_maxNs = 0;
+    std::array<uint64_t, Buckets> m_histogram{};
+
+    double meanUs() const { return m_count ? m_totalNs / (1000.0 * m_count) : 0.0; }
+
+    /** Upper bound (us) of the bucket containing the given fraction [0, 1] of samples */
+    double percentileUs(double fraction) const {
+      if (!m_count)
+        return 0.0;
+      const auto target = std::max<uint64_t>(1, uint64_t(std::ceil(fraction * m_count)));
+      uint64_t seen = 0;
+      for (size_t i = 0; i < Buckets - 1; ++i) {
+        seen += m_histogram[i];
+        if (seen >= target)
+          return double(uint64_t(1) << i);
+      }
+      return double(uint64_t(1) << (Buckets - 1));
+    }
+  };
+
+private:
+  std::atomic<uint64_t> m_count{0};
+  std::atomic<uint64_t> m_totalNs{0};
+  std::atomic<uint64_t> m_maxNs{0};
+  std::array<std::atomic<uint64_t>, Buckets> m_histogram{};
+
+public:
+  void record(InputClock::time_point arrival, InputClock::time_point consumed = InputClock::now()) {
+    const auto ns = uint64_t(std::max<int64_t>(0, std::chrono::nanoseconds(consumed - arrival).count()));
+    size_t bucket = 0;
+    while (bucket < Buckets - 1 && ns >= (uint64_t(1000) << bucket))
+      ++bucket;
+    m_histogram[bucket].fetch_add(1, std::memory_order_relaxed);
+    m_totalNs.fetch_add(ns, std::memory_order_relaxed);
+    if (ns > m_maxNs.load(std::memory_order_relaxed))
+      m_maxNs.store(ns, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  Summary summary() const {
+    Summary ret;
+    ret.m_count = m_count.load(std::memory_order_relaxed);
+    ret.m_totalNs = m_totalNs.load(std::memory_order_relaxed);
+    ret.m_maxNs = m_maxNs.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < Buckets; ++i)
+      ret.m_histogram[i] = m_histogram[i].load(std::memory_order_relaxed);
+    return ret;
+  }
+
+  void reset() {
+    m_count.store(0, std::memory_order_relaxed);
+    m_totalNs.store(0, std::memory_order_relaxed);
+    m_maxNs.store(0, std::memory_order_relaxed);
+    for (auto& bucket : m_histogram)
+      bucket.store(0, std::memory_order_relaxed);
+  }
+};
+
+} // namespace boo
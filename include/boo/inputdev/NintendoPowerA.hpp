@@ -1,6 +1,8 @@
 #pragma once
 #include "DeviceBase.hpp"
 #include "boo/System.hpp"
+#include "boo/inputdev/InputHistory.hpp"
+#include "boo/inputdev/TripleBuffer.hpp"
 
 namespace boo {
 struct NintendoPowerAState {
@@ -35,6 +37,8 @@ struct INintendoPowerACallback {
 
 class NintendoPowerA final : public TDeviceBase<INintendoPowerACallback> {
   NintendoPowerAState m_last{};
+  TripleBuffer<TimedState<NintendoPowerAState>> m_latestState;
+  InputHistory<NintendoPowerAState> m_history;
   void deviceDisconnected() override;
   void initialCycle() override;
   void transferCycle() override;
@@ -44,5 +48,21 @@ class NintendoPowerA final : public TDeviceBase<INintendoPowerACallback> {
 public:
   explicit NintendoPowerA(DeviceToken*);
   ~NintendoPowerA() override;
+
+  /** Newest parsed state for one polling thread; wait-free and independent of the callback */
+  const NintendoPowerAState& latestState() {
+    if (m_latestState.update())
+      m_pollLatency.record(m_latestState.front().m_time);
+    return m_latestState.front().m_state;
+  }
+
+  /** Arrival time of the state last returned by latestState() */
+  InputClock::time_point latestStateTime() const { return m_latestState.front().m_time; }
+
+  /** Append the retained states that arrived in [begin, end), oldest first */
+  size_t queryHistory(InputClock::time_point begin, InputClock::time_point end,
+                      std::vector<TimedState<NintendoPowerAState>>& out) const {
+    return m_history.query(begin, end, out);
+  }
 };
 } // namespace boo
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace boo {
+
+/** Wait-free latest-value channel between one writer thread (the device's input thread) and one
+ *  reader thread (typically the game's main thread). The writer fills back() and publishes it;
+ *  the reader picks up the newest published value on update() and reads it from front().
+ *  Neither side blocks or retries, and intermediate values the reader never saw are simply skipped */
+template <typename T>
+class TripleBuffer {
+  static constexpr uint8_t IndexMask = 0x3;
+  static constexpr uint8_t FreshBit = 0x4;
+
+  T m_buffers[3]{};
+  alignas(64) std::atomic<uint8_t> m_middle{1}; /* Index of the buffer in exchange, plus FreshBit */
+  alignas(64) uint8_t m_back = 0;               /* Writer-owned */
+  alignas(64) uint8_t m_front = 2;              /* Reader-owned */
+
+public:
+  /** Writer side; buffer to fill before publish(). Holds an older value, not the last one published */
+  T& back() { return m_buffers[m_back]; }
+  void publish() { m_back = m_middle.exchange(m_back | FreshBit, std::memory_order_acq_rel) & IndexMask; }
+  void publish(const T& value) {
+    back() = value;
+    publish();
+  }
+
+  /** Reader side; adopts the newest published value, returning false if nothing was published since the last call */
+  bool update() {
+    if (!(m_middle.load(std::memory_order_relaxed) & FreshBit))
+      return false;
+    m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & IndexMask;
+    return true;
+  }
+  const T& front() const { return m_buffers[m_front]; }
+};
+
+} // namespace boo
@@ -322,8 +322,7 @@ struct AQSAudioVoiceEngine : BaseAudioVoiceEngine {
   static void MIDIReceiveProc(const MIDIPacketList* pktlist, IMIDIReceiver* readProcRefCon, void*) {
     const MIDIPacket* packet = &pktlist->packet[0];
     for (int i = 0; i < pktlist->numPackets; ++i) {
-      std::vector<uint8_t> bytes(std::cbegin(packet->data), std::cbegin(packet->data) + packet->length);
-      readProcRefCon->m_receiver(std::move(bytes), AudioConvertHostTimeToNanos(packet->timeStamp) / 1.0e9);
+      readProcRefCon->_receive(packet->data, packet->length, AudioConvertHostTimeToNanos(packet->timeStamp) / 1.0e9);
       packet = MIDIPacketNext(packet);
     }
   }
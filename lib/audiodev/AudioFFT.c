@@ -0,0 +1,84 @@
+/* Exposes the SIMD pffft vendored with soxr (whose entry points are file-static) to boo's effects */
+
+/* soxr only builds pffft's SIMD path where FindSIMD finds SSE. Other targets get the scalar code;
+ * the vendored NEON path doesn't build on 32-bit ARM (pffft_zconvolve is an #error there) */
+#if !defined(PFFFT_SIMD_DISABLE) && !(defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1))
+#define PFFFT_SIMD_DISABLE
+#endif
+
+#include "soxr/src/pffft.c"
+#include "lib/audiodev/AudioFFT.h"
+
+void* boo_fft_new_setup(int n) { return pffft_new_setup(n, PFFFT_REAL); }
+
+void boo_fft_destroy_setup(void* setup) { pffft_destroy_setup((PFFFT_Setup*)setup); }
+
+void boo_fft_forward(void* setup, const float* in, float* out, float* work) {
+  pffft_transform((PFFFT_Setup*)setup, in, out, work, PFFFT_FORWARD);
+}
+
+void boo_fft_backward(void* setup, const float* in, float* out, float* work) {
+  pffft_transform((PFFFT_Setup*)setup, in, out, work, PFFFT_BACKWARD);
+}
+
+/* pffft_zconvolve_accumulate is compiled out of soxr's copy; this is its portable body */
+void boo_fft_zconvolve_accumulate(void* setup, const float* a, const float* b, float* ab, float scaling) {
+  const PFFFT_Setup* s = (const PFFFT_Setup*)setup;
+  int i, Ncvec = s->Ncvec;
+#if !defined(PFFFT_SIMD_DISABLE)
+  const v4sf* RESTRICT va = (const v4sf*)a;
+  const v4sf* RESTRICT vb = (const v4sf*)b;
+  v4sf* RESTRICT vab = (v4sf*)ab;
+  const v4sf vscal = LD_PS1(scaling);
+
+  /* The first lane of the first two vectors packs the DC and Nyquist bins of a real transform */
+  const float ar0 = ((const v4sf_union*)va)[0].f[0];
+  const float ai0 = ((const v4sf_union*)va)[1].f[0];
+  const float br0 = ((const v4sf_union*)vb)[0].f[0];
+  const float bi0 = ((const v4sf_union*)vb)[1].f[0];
+  const float abr0 = ((v4sf_union*)vab)[0].f[0];
+  const float abi0 = ((v4sf_union*)vab)[1].f[0];
+
+  for (i = 0; i < Ncvec; i += 2) {
+    v4sf ar, ai, br, bi;
+    ar = va[2 * i + 0];
+    ai = va[2 * i + 1];
+    br = vb[2 * i + 0];
+    bi = vb[2 * i + 1];
+    VCPLXMUL(ar, ai, br, bi);
+    vab[2 * i + 0] = VMADD(ar, vscal, vab[2 * i + 0]);
+    vab[2 * i + 1] = VMADD(ai, vscal, vab[2 * i + 1]);
+    ar = va[2 * i + 2];
+    ai = va[2 * i + 3];
+    br = vb[2 * i + 2];
+    bi = vb[2 * i + 3];
+    VCPLXMUL(ar, ai, br, bi);
+    vab[2 * i + 2] = VMADD(ar, vscal, vab[2 * i + 2]);
+    vab[2 * i + 3] = VMADD(ai, vscal, vab[2 * i + 3]);
+  }
+  if (s->transform == PFFFT_REAL) {
+    ((v4sf_union*)vab)[0].f[0] = abr0 + ar0 * br0 * scaling;
+    ((v4sf_union*)vab)[1].f[0] = abi0 + ai0 * bi0 * scaling;
+  }
+#else
+  if (s->transform == PFFFT_REAL) {
+    /* fftpack ordering: DC first, Nyquist last, both real */
+    ab[0] += a[0] * b[0] * scaling;
+    ab[2 * Ncvec - 1] += a[2 * Ncvec - 1] * b[2 * Ncvec - 1] * scaling;
+    ++ab;
+    ++a;
+    ++b;
+    --Ncvec;
+  }
+  for (i = 0; i < Ncvec; ++i) {
+    float ar, ai, br, bi;
+    ar = a[2 * i + 0];
+    ai = a[2 * i + 1];
+    br = b[2 * i + 0];
+    bi = b[2 * i + 1];
+    VCPLXMUL(ar, ai, br, bi);
+    ab[2 * i + 0] += ar * scaling;
+    ab[2 * i + 1] += ai * scaling;
+  }
+#endif
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+/* Real-input FFT (pffft, as vendored with soxr).
+ * Spectra use pffft's internal unordered layout and are only meant to be fed back to
+ * boo_fft_zconvolve_accumulate / boo_fft_backward. Buffers must be 16-byte aligned; transforms are unscaled */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void* boo_fft_new_setup(int n);
+void boo_fft_destroy_setup(void* setup);
+void boo_fft_forward(void* setup, const float* in, float* out, float* work);
+void boo_fft_backward(void* setup, const float* in, float* out, float* work);
+/* ab += a * b * scaling, spectrum by spectrum */
+void boo_fft_zconvolve_accumulate(void* setup, const float* a, const float* b, float* ab, float scaling);
+
+#ifdef __cplusplus
+}
+#endif
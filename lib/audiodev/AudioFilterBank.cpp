@@ -0,0 +1,246 @@
+#include "lib/audiodev/AudioFilterBank.hpp"
+#include "lib/audiodev/AudioMatrix.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#undef min
+#undef max
+
+namespace boo {
+namespace {
+constexpr double Pi = 3.14159265358979323846;
+
+using LaneParams = std::vector<float>[AudioFilterBank::LaneParamCount];
+
+template <typename T>
+T StoreFiltered(float v);
+template <>
+int16_t StoreFiltered<int16_t>(float v) {
+  return Clamp16(v);
+}
+template <>
+int32_t StoreFiltered<int32_t>(float v) {
+  return Clamp32(v);
+}
+template <>
+float StoreFiltered<float>(float v) {
+  return v;
+}
+
+#if __SSE__
+/* Runs V groups of 4 lanes in lockstep; independent recursions hide each other's latency */
+template <unsigned V, bool Ramp>
+void BiquadGroups(float* samples, size_t frames, LaneParams& p, size_t lane) {
+  __m128 c[AudioFilterBank::LaneParamCount][V];
+  for (unsigned k = 0; k < AudioFilterBank::LaneParamCount; ++k)
+    for (unsigned v = 0; v < V; ++v)
+      c[k][v] = _mm_loadu_ps(p[k].data() + lane + v * 4);
+
+  for (size_t f = 0; f < frames; ++f) {
+    for (unsigned v = 0; v < V; ++v) {
+      float* s = samples + (v * frames + f) * 4;
+      __m128 x = _mm_loadu_ps(s);
+      __m128 y = _mm_add_ps(_mm_mul_ps(c[AudioFilterBank::B0][v], x), c[AudioFilterBank::Z1][v]);
+      c[AudioFilterBank::Z1][v] =
+          _mm_add_ps(_mm_sub_ps(_mm_mul_ps(c[AudioFilterBank::B1][v], x), _mm_mul_ps(c[AudioFilterBank::A1][v], y)),
+                     c[AudioFilterBank::Z2][v]);
+      c[AudioFilterBank::Z2][v] =
+          _mm_sub_ps(_mm_mul_ps(c[AudioFilterBank::B2][v], x), _mm_mul_ps(c[AudioFilterBank::A2][v], y));
+      _mm_storeu_ps(s, y);
+      if constexpr (Ramp) {
+        for (unsigned k = 0; k < 5; ++k)
+          c[AudioFilterBank::B0 + k][v] = _mm_add_ps(c[AudioFilterBank::B0 + k][v], c[AudioFilterBank::DB0 + k][v]);
+      }
+    }
+  }
+
+  for (unsigned v = 0; v < V; ++v) {
+    _mm_storeu_ps(p[AudioFilterBank::Z1].data() + lane + v * 4, c[AudioFilterBank::Z1][v]);
+    _mm_storeu_ps(p[AudioFilterBank::Z2].data() + lane + v * 4, c[AudioFilterBank::Z2][v]);
+  }
+}
+
+template <bool Ramp>
+void BiquadLanes(float* samples, size_t frames, size_t groups, LaneParams& p) {
+  size_t g = 0;
+  for (; g + 4 <= groups; g += 4)
+    BiquadGroups<4, Ramp>(samples + g * frames * 4, frames, p, g * 4);
+  if (g + 2 <= groups) {
+    BiquadGroups<2, Ramp>(samples + g * frames * 4, frames, p, g * 4);
+    g += 2;
+  }
+  if (g < groups)
+    BiquadGroups<1, Ramp>(samples + g * frames * 4, frames, p, g * 4);
+}
+#else
+template <bool Ramp>
+void BiquadLanes(float* samples, size_t frames, size_t groups, LaneParams& p) {
+  for (size_t lane = 0; lane < groups * 4; ++lane) {
+    float c[AudioFilterBank::LaneParamCount];
+    for (unsigned k = 0; k < AudioFilterBank::LaneParamCount; ++k)
+      c[k] = p[k][lane];
+    float* s = samples + (lane / 4) * frames * 4 + lane % 4;
+    for (size_t f = 0; f < frames; ++f) {
+      const float x = s[f * 4];
+      const float y = c[AudioFilterBank::B0] * x + c[AudioFilterBank::Z1];
+      c[AudioFilterBank::Z1] = c[AudioFilterBank::B1] * x - c[AudioFilterBank::A1] * y + c[AudioFilterBank::Z2];
+      c[AudioFilterBank::Z2] = c[AudioFilterBank::B2] * x - c[AudioFilterBank::A2] * y;
+      s[f * 4] = y;
+      if constexpr (Ramp) {
+        for (unsigned k = 0; k < 5; ++k)
+          c[AudioFilterBank::B0 + k] += c[AudioFilterBank::DB0 + k];
+      }
+    }
+    p[AudioFilterBank::Z1][lane] = c[AudioFilterBank::Z1];
+    p[AudioFilterBank::Z2][lane] = c[AudioFilterBank::Z2];
+  }
+}
+#endif
+} // Anonymous namespace
+
+void AudioVoiceFilter::setParameters(AudioFilterType type, double cutoff, double q, double sampleRate, bool slew) {
+  if (type == AudioFilterType::None) {
+    m_type = AudioFilterType::None;
+    m_ramp = false;
+    return;
+  }
+
+  /* RBJ cookbook low/high-pass */
+  const double fc = std::clamp(cutoff, 10.0, sampleRate * 0.49);
+  const double w0 = 2.0 * Pi * fc / sampleRate;
+  const double cosw = std::cos(w0);
+  const double alpha = std::sin(w0) / (2.0 * std::max(q, 0.01));
+  const double a0 = 1.0 + alpha;
+
+  AudioBiquadCoefs c;
+  if (type == AudioFilterType::LowPass) {
+    c.b0 = float((1.0 - cosw) * 0.5 / a0);
+    c.b1 = float((1.0 - cosw) / a0);
+  } else {
+    c.b0 = float((1.0 + cosw) * 0.5 / a0);
+    c.b1 = float(-(1.0 + cosw) / a0);
+  }
+  c.b2 = c.b0;
+  c.a1 = float(-2.0 * cosw / a0);
+  c.a2 = float((1.0 - alpha) / a0);
+
+  m_target = c;
+  if (slew && isActive()) {
+    m_ramp = true;
+  } else {
+    if (!isActive()) {
+      std::fill(std::begin(m_z1), std::end(m_z1), 0.f);
+      std::fill(std::begin(m_z2), std::end(m_z2), 0.f);
+    }
+    m_coefs = c;
+    m_ramp = false;
+  }
+  m_type = type;
+}
+
+template <typename T>
+void AudioFilterBank::gather(AudioVoice& voice, AudioVoiceFilter& filter, unsigned channels, const T* in,
+                             size_t frames, size_t blockFrames) {
+  if (m_slots.empty())
+    m_blockFrames = blockFrames;
+
+  Slot slot{&voice, &filter, m_lanes, channels, std::min(frames, m_blockFrames)};
+  m_lanes += channels;
+  const size_t sampleCount = size_t((m_lanes + 3) / 4) * m_blockFrames * 4;
+  if (m_samples.size() < sampleCount)
+    m_samples.resize(sampleCount);
+
+  for (unsigned ch = 0; ch < channels; ++ch) {
+    const unsigned lane = slot.m_firstLane + ch;
+    float* dst = m_samples.data() + (lane / 4) * m_blockFrames * 4 + lane % 4;
+    size_t f = 0;
+    for (; f < slot.m_frames; ++f)
+      dst[f * 4] = float(in[f * channels + ch]);
+    for (; f < m_blockFrames; ++f)
+      dst[f * 4] = 0.f;
+  }
+
+  m_slots.push_back(slot);
+}
+
+template void AudioFilterBank::gather<int16_t>(AudioVoice& voice, AudioVoiceFilter& filter, unsigned channels,
+                                               const int16_t* in, size_t frames, size_t blockFrames);
+template void AudioFilterBank::gather<int32_t>(AudioVoice& voice, AudioVoiceFilter& filter, unsigned channels,
+                                               const int32_t* in, size_t frames, size_t blockFrames);
+template void AudioFilterBank::gather<float>(AudioVoice& voice, AudioVoiceFilter& filter, unsigned channels,
+                                             const float* in, size_t frames, size_t blockFrames);
+
+void AudioFilterBank::process() {
+  if (m_slots.empty())
+    return;
+
+  /* Padding lanes run with zeroed coefficients and produce silence */
+  const size_t groups = (m_lanes + 3) / 4;
+  for (auto& param : m_params)
+    param.assign(groups * 4, 0.f);
+
+  bool ramp = false;
+  const float invFrames = 1.f / float(m_blockFrames);
+  for (const Slot& slot : m_slots) {
+    const AudioVoiceFilter& filter = *slot.m_filter;
+    const AudioBiquadCoefs& c = filter.m_coefs;
+    const AudioBiquadCoefs& t = filter.m_ramp ? filter.m_target : filter.m_coefs;
+    ramp |= filter.m_ramp;
+    for (unsigned ch = 0; ch < slot.m_channels; ++ch) {
+      const unsigned lane = slot.m_firstLane + ch;
+      m_params[B0][lane] = c.b0;
+      m_params[B1][lane] = c.b1;
+      m_params[B2][lane] = c.b2;
+      m_params[A1][lane] = c.a1;
+      m_params[A2][lane] = c.a2;
+      m_params[DB0][lane] = (t.b0 - c.b0) * invFrames;
+      m_params[DB1][lane] = (t.b1 - c.b1) * invFrames;
+      m_params[DB2][lane] = (t.b2 - c.b2) * invFrames;
+      m_params[DA1][lane] = (t.a1 - c.a1) * invFrames;
+      m_params[DA2][lane] = (t.a2 - c.a2) * invFrames;
+      m_params[Z1][lane] = filter.m_z1[ch];
+      m_params[Z2][lane] = filter.m_z2[ch];
+    }
+  }
+
+  if (ramp)
+    BiquadLanes<true>(m_samples.data(), m_blockFrames, groups, m_params);
+  else
+    BiquadLanes<false>(m_samples.data(), m_blockFrames, groups, m_params);
+
+  for (const Slot& slot : m_slots) {
+    AudioVoiceFilter& filter = *slot.m_filter;
+    for (unsigned ch = 0; ch < slot.m_channels; ++ch) {
+      filter.m_z1[ch] = m_params[Z1][slot.m_firstLane + ch];
+      filter.m_z2[ch] = m_params[Z2][slot.m_firstLane + ch];
+    }
+    if (filter.m_ramp) {
+      filter.m_coefs = filter.m_target;
+      filter.m_ramp = false;
+    }
+  }
+}
+
+template <typename T>
+size_t AudioFilterBank::scatter(size_t idx, T* out) const {
+  const Slot& slot = m_slots[idx];
+  for (unsigned ch = 0; ch < slot.m_channels; ++ch) {
+    const unsigned lane = slot.m_firstLane + ch;
+    const float* src = m_samples.data() + (lane / 4) * m_blockFrames * 4 + lane % 4;
+    for (size_t f = 0; f < slot.m_frames; ++f)
+      out[f * slot.m_channels + ch] = StoreFiltered<T>(src[f * 4]);
+  }
+  return slot.m_frames;
+}
+
+template size_t AudioFilterBank::scatter<int16_t>(size_t idx, int16_t* out) const;
+template size_t AudioFilterBank::scatter<int32_t>(size_t idx, int32_t* out) const;
+template size_t AudioFilterBank::scatter<float>(size_t idx, float* out) const;
+
+void AudioFilterBank::clear() {
+  m_slots.clear();
+  m_lanes = 0;
+}
+
+} // namespace boo
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "boo/audiodev/IAudioVoice.hpp"
+
+namespace boo {
+class AudioVoice;
+
+struct AudioBiquadCoefs {
+  float b0 = 1.f;
+  float b1 = 0.f;
+  float b2 = 0.f;
+  float a1 = 0.f;
+  float a2 = 0.f;
+};
+
+/** Per-voice filter settings and history (transposed direct form II), run by AudioFilterBank */
+struct AudioVoiceFilter {
+  static constexpr unsigned MaxChannels = 2;
+
+  AudioFilterType m_type = AudioFilterType::None;
+  AudioBiquadCoefs m_coefs;
+  AudioBiquadCoefs m_target;
+  bool m_ramp = false;
+  float m_z1[MaxChannels] = {};
+  float m_z2[MaxChannels] = {};
+
+  bool isActive() const { return m_type != AudioFilterType::None; }
+  void setParameters(AudioFilterType type, double cutoff, double q, double sampleRate, bool slew);
+};
+
+/** Gathers filtered voices each 5ms interval and runs their biquads side by side.
+ *  Every voice channel occupies one lane; lanes are stored in groups of 4 (structure-of-arrays)
+ *  and processed 4, 8 or 16 at a time so the recursion latency of one filter overlaps the others.
+ *  Coefficient changes made with slew are ramped linearly across the interval */
+class AudioFilterBank {
+public:
+  /* Per-lane coefficients, ramp deltas and history */
+  enum LaneParam { B0, B1, B2, A1, A2, DB0, DB1, DB2, DA1, DA2, Z1, Z2, LaneParamCount };
+
+private:
+  struct Slot {
+    AudioVoice* m_voice;
+    AudioVoiceFilter* m_filter;
+    unsigned m_firstLane;
+    unsigned m_channels;
+    size_t m_frames;
+  };
+  std::vector<Slot> m_slots;
+  unsigned m_lanes = 0;
+  size_t m_blockFrames = 0;
+
+  /* Samples as [group][frame][4 lanes] */
+  std::vector<float> m_samples;
+
+  std::vector<float> m_params[LaneParamCount];
+
+public:
+  /** Queue a voice's rendered block for filtering; lanes past `frames` are zero-filled */
+  template <typename T>
+  void gather(AudioVoice& voice, AudioVoiceFilter& filter, unsigned channels, const T* in, size_t frames,
+              size_t blockFrames);
+
+  /** Run all queued filters and store updated history back into each AudioVoiceFilter */
+  void process();
+
+  /** Write a slot's filtered block as interleaved samples; returns frame count */
+  template <typename T>
+  size_t scatter(size_t slot, T* out) const;
+
+  size_t slotCount() const { return m_slots.size(); }
+  AudioVoice& voice(size_t slot) const { return *m_slots[slot].m_voice; }
+  void clear();
+};
+
+} // namespace boo
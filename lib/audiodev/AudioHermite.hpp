@@ -0,0 +1,69 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+#include "lib/audiodev/AudioMatrix.hpp"
+
+#undef min
+#undef max
+
+namespace boo {
+
+/* Interpolation kernels shared by the engine's built-in resamplers.
+ * Inputs are int16-scaled floats; StoreSample/StoreVec convert to the mix format */
+
+constexpr float HermiteInt16ToFlt = 1.f / 32768.f;
+
+/** 4-point, 3rd-order Hermite (x-form) */
+static inline float Hermite(float xm1, float x0, float x1, float x2, float t) {
+  float c1 = 0.5f * (x1 - xm1);
+  float c2 = xm1 - 2.5f * x0 + 2.f * x1 - 0.5f * x2;
+  float c3 = 0.5f * (x2 - xm1) + 1.5f * (x0 - x1);
+  return ((c3 * t + c2) * t + c1) * t + x0;
+}
+
+template <typename T>
+void StoreSample(T* out, float v);
+template <>
+inline void StoreSample<int16_t>(int16_t* out, float v) {
+  *out = Clamp16(v);
+}
+template <>
+inline void StoreSample<int32_t>(int32_t* out, float v) {
+  *out = int32_t(std::clamp(v, -32768.f, 32767.f) * 65536.f);
+}
+template <>
+inline void StoreSample<float>(float* out, float v) {
+  *out = v * HermiteInt16ToFlt;
+}
+
+#if __SSE__
+static inline __m128 HermiteVec(__m128 xm1, __m128 x0, __m128 x1, __m128 x2, __m128 t) {
+  const __m128 half = _mm_set1_ps(0.5f);
+  __m128 c1 = _mm_mul_ps(half, _mm_sub_ps(x1, xm1));
+  __m128 c2 = _mm_sub_ps(_mm_add_ps(xm1, _mm_add_ps(x1, x1)),
+                         _mm_add_ps(_mm_mul_ps(_mm_set1_ps(2.5f), x0), _mm_mul_ps(half, x2)));
+  __m128 c3 = _mm_add_ps(_mm_mul_ps(half, _mm_sub_ps(x2, xm1)), _mm_mul_ps(_mm_set1_ps(1.5f), _mm_sub_ps(x0, x1)));
+  return _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(c3, t), c2), t), c1), t), x0);
+}
+
+template <typename T>
+void StoreVec(T* out, __m128 v);
+template <>
+inline void StoreVec<int16_t>(int16_t* out, __m128 v) {
+  __m128i i = _mm_cvttps_epi32(v);
+  _mm_storel_epi64(reinterpret_cast<__m128i*>(out), _mm_packs_epi32(i, i));
+}
+template <>
+inline void StoreVec<int32_t>(int32_t* out, __m128 v) {
+  v = _mm_min_ps(_mm_max_ps(v, _mm_set1_ps(-32768.f)), _mm_set1_ps(32767.f));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_cvttps_epi32(_mm_mul_ps(v, _mm_set1_ps(65536.f))));
+}
+template <>
+inline void StoreVec<float>(float* out, __m128 v) {
+  _mm_storeu_ps(out, _mm_mul_ps(v, _mm_set1_ps(HermiteInt16ToFlt)));
+}
+#endif
+
+} // namespace boo
@@ -14,6 +14,12 @@ union TVectorUnion {
 static constexpr TVectorUnion Min32Vec = {{INT32_MIN, INT32_MIN, INT32_MIN, INT32_MIN}};
 static constexpr TVectorUnion Max32Vec = {{INT32_MAX, INT32_MAX, INT32_MAX, INT32_MAX}};
 
+/* Stereo mono-mix paths consume two frames per vector; a trailing odd frame
+ * (blocks are split at voice event timestamps) takes the scalar path instead */
+static unsigned MonoMixLayout(const ChannelMap& chmap, size_t s, size_t samples) {
+  return (chmap.m_channelCount == 2 && s + 1 == samples) ? 0 : chmap.m_channelCount;
+}
+
 void AudioMatrixMono::setDefaultMatrixCoefficients(AudioChannelSet acSet) {
   m_curSlewFrame = 0;
   m_slewFrames = 0;
@@ -72,7 +78,7 @@ int32_t* AudioMatrixMono::mixMonoSampleData(const AudioVoiceEngineMixInfo& info,
       float t = m_curSlewFrame / float(m_slewFrames);
       float omt = 1.f - t;
 
-      switch (chmap.m_channelCount) {
+      switch (MonoMixLayout(chmap, s, samples)) {
       case 2: {
         ++m_curSlewFrame;
         float t2 = m_curSlewFrame / float(m_slewFrames);
@@ -163,7 +169,7 @@ int32_t* AudioMatrixMono::mixMonoSampleData(const AudioVoiceEngineMixInfo& info,
 
       ++m_curSlewFrame;
     } else {
-      switch (chmap.m_channelCount) {
+      switch (MonoMixLayout(chmap, s, samples)) {
       case 2: {
         TVectorUnion coefs, samps;
         coefs.q = _mm_shuffle_ps(m_coefs.q[0], m_coefs.q[0], _MM_SHUFFLE(1, 0, 1, 0));
@@ -254,7 +260,7 @@ float* AudioMatrixMono::mixMonoSampleData(const AudioVoiceEngineMixInfo& info, c
       float t = m_curSlewFrame / float(m_slewFrames);
       float omt = 1.f - t;
 
-      switch (chmap.m_channelCount) {
+      switch (MonoMixLayout(chmap, s, samples)) {
       case 2: {
         ++m_curSlewFrame;
         float t2 = m_curSlewFrame / float(m_slewFrames);
@@ -290,7 +296,7 @@ float* AudioMatrixMono::mixMonoSampleData(const AudioVoiceEngineMixInfo& info, c
 
       ++m_curSlewFrame;
     } else {
-      switch (chmap.m_channelCount) {
+      switch (MonoMixLayout(chmap, s, samples)) {
       case 2: {
         TVectorUnion coefs, samps;
         coefs.q = _mm_shuffle_ps(m_coefs.q[0], m_coefs.q[0], _MM_SHUFFLE(1, 0, 1, 0));
@@ -0,0 +1,124 @@
+#include "lib/audiodev/AudioResampler.hpp"
+#include "lib/audiodev/AudioHermite.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#undef min
+#undef max
+
+namespace boo {
+
+AudioStreamResampler::AudioStreamResampler(unsigned channels, InputFn fn, void* ctx)
+: m_channels(channels), m_inputFn(fn), m_inputCtx(ctx) {
+  reset();
+}
+
+void AudioStreamResampler::reset() {
+  /* One frame of silence stands in for the tap preceding the first input frame */
+  m_fifo.assign(m_channels * 8, 0);
+  m_fifoFrames = 1;
+  m_pos = 1.0;
+}
+
+void AudioStreamResampler::setRatio(double ratio, size_t slewFrames) {
+  m_targetStep = ratio;
+  if (slewFrames) {
+    m_slewDelta = (ratio - m_step) / double(slewFrames);
+    m_slewFrames = slewFrames;
+  } else {
+    m_step = ratio;
+    m_slewFrames = 0;
+  }
+}
+
+void AudioStreamResampler::_compact() {
+  const size_t drop = std::min(size_t(m_pos) - 1, m_fifoFrames);
+  if (!drop)
+    return;
+  m_fifoFrames -= drop;
+  std::memmove(m_fifo.data(), m_fifo.data() + drop * m_channels, m_fifoFrames * m_channels * sizeof(int16_t));
+  m_pos -= double(drop);
+}
+
+void AudioStreamResampler::_fill(size_t frames) {
+  if (m_fifo.size() < frames * m_channels)
+    m_fifo.resize(frames * m_channels);
+  while (m_fifoFrames < frames) {
+    int16_t* data;
+    const size_t got = std::min(m_inputFn(m_inputCtx, &data, frames - m_fifoFrames), frames - m_fifoFrames);
+    if (!got)
+      break;
+    std::memcpy(m_fifo.data() + m_fifoFrames * m_channels, data, got * m_channels * sizeof(int16_t));
+    m_fifoFrames += got;
+  }
+}
+
+template <unsigned Chans, typename T>
+size_t AudioStreamResampler::_output(T* out, size_t frames) {
+  _compact();
+  const double maxStep = std::max(m_step, m_targetStep);
+  _fill(size_t(m_pos + double(frames) * maxStep) + 3);
+
+  const int16_t* fifo = m_fifo.data();
+  const size_t limit = m_fifoFrames;
+
+  size_t f = 0;
+#if __SSE__
+  constexpr size_t Block = 4 / Chans;
+  while (f + Block <= frames && size_t(m_pos + double(Block) * maxStep) + 2 < limit) {
+    alignas(16) float xm1[4], x0[4], x1[4], x2[4], t[4];
+    for (size_t k = 0; k < Block; ++k) {
+      const size_t i = size_t(m_pos);
+      const float frac = float(m_pos - double(i));
+      const int16_t* s = fifo + (i - 1) * Chans;
+      for (unsigned c = 0; c < Chans; ++c) {
+        xm1[k * Chans + c] = s[c];
+        x0[k * Chans + c] = s[Chans + c];
+        x1[k * Chans + c] = s[Chans * 2 + c];
+        x2[k * Chans + c] = s[Chans * 3 + c];
+        t[k * Chans + c] = frac;
+      }
+      m_pos += _advanceStep();
+    }
+
+    StoreVec(out + f * Chans,
+             HermiteVec(_mm_load_ps(xm1), _mm_load_ps(x0), _mm_load_ps(x1), _mm_load_ps(x2), _mm_load_ps(t)));
+    f += Block;
+  }
+#endif
+
+  for (; f < frames; ++f) {
+    const size_t i = size_t(m_pos);
+    if (i + 2 >= limit)
+      break;
+    const float frac = float(m_pos - double(i));
+    const int16_t* s = fifo + (i - 1) * Chans;
+    for (unsigned c = 0; c < Chans; ++c)
+      StoreSample(out + f * Chans + c, Hermite(s[c], s[Chans + c], s[Chans * 2 + c], s[Chans * 3 + c], frac));
+    m_pos += _advanceStep();
+  }
+
+  return f;
+}
+
+template <typename T>
+size_t AudioStreamResampler::output(T* out, size_t frames) {
+  if (m_channels == 2)
+    return _output<2>(out, frames);
+  return _output<1>(out, frames);
+}
+
+template size_t AudioStreamResampler::output<int16_t>(int16_t* out, size_t frames);
+template size_t AudioStreamResampler::output<int32_t>(int32_t* out, size_t frames);
+template size_t AudioStreamResampler::output<float>(float* out, size_t frames);
+
+void AudioStreamResampler::skip(size_t frames) {
+  for (; frames && m_slewFrames; --frames)
+    m_pos += _advanceStep();
+  m_pos += m_step * double(frames);
+  _fill(size_t(m_pos) + 3);
+  _compact();
+}
+
+} // namespace boo
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace boo {
+
+/** Streaming 4-point Hermite resampler for callback voices created with AudioResamplerQuality::Fast.
+ *  Pulls int16 frames through an input function (same contract as a soxr input_fn) into a short FIFO
+ *  and interpolates 4 lanes at a time. Far cheaper than soxr's variable-rate engine at the cost of
+ *  some aliasing on large upward pitch shifts */
+class AudioStreamResampler {
+public:
+  using InputFn = size_t (*)(void* ctx, int16_t** data, size_t frames);
+
+private:
+  unsigned m_channels;
+  InputFn m_inputFn;
+  void* m_inputCtx;
+
+  /* Interleaved input frames; frame 0 is the oldest tap still needed */
+  std::vector<int16_t> m_fifo;
+  size_t m_fifoFrames = 0;
+  double m_pos = 1.0;
+
+  double m_step = 1.0;
+  double m_targetStep = 1.0;
+  double m_slewDelta = 0.0;
+  size_t m_slewFrames = 0;
+
+  double _advanceStep() {
+    double step = m_step;
+    if (m_slewFrames) {
+      m_step += m_slewDelta;
+      if (--m_slewFrames == 0)
+        m_step = m_targetStep;
+    }
+    return step;
+  }
+  void _compact();
+  void _fill(size_t frames);
+
+  template <unsigned Chans, typename T>
+  size_t _output(T* out, size_t frames);
+
+public:
+  AudioStreamResampler(unsigned channels, InputFn fn, void* ctx);
+
+  /** Set input frames consumed per output frame, optionally ramping over slewFrames */
+  void setRatio(double ratio, size_t slewFrames);
+
+  /** Drop buffered input and interpolation history */
+  void reset();
+
+  /** Resample up to `frames` interleaved frames into out; returns fewer if input runs dry */
+  template <typename T>
+  size_t output(T* out, size_t frames);
+
+  /** Consume input for `frames` output frames without interpolating (used while voice is silent) */
+  void skip(size_t frames);
+};
+
+} // namespace boo
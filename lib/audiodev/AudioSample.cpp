@@ -0,0 +1,200 @@
+#include "lib/audiodev/AudioSample.hpp"
+#include "lib/audiodev/AudioHermite.hpp"
+#include "lib/audiodev/AudioSampleDecoder.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#undef min
+#undef max
+
+namespace boo {
+
+AudioSamplePlayback::AudioSamplePlayback(const AudioSampleInfo& info) : m_info(info) {
+  if (!m_info.isCompressed())
+    return;
+
+  const unsigned chans = m_info.m_channels;
+  m_decoder = std::make_unique<AudioSampleDecoder>(m_info);
+  m_window.resize((m_decoder->blockFrames() * 2 + 3) * chans);
+
+  /* Taps that wrap past the loop end read the loop head from here rather than
+   * dragging the window back and forth; decoding it now also records the DSP loop history */
+  if (m_info.isLooped()) {
+    const size_t headFrames = std::min(size_t(3), m_info.m_loopEnd - m_info.m_loopStart);
+    const int16_t* head = _decodedFrames(int64_t(m_info.m_loopStart), int64_t(m_info.m_loopStart + headFrames - 1));
+    std::memcpy(m_loopHead, head, headFrames * chans * sizeof(int16_t));
+  }
+}
+
+AudioSamplePlayback::~AudioSamplePlayback() = default;
+
+const int16_t* AudioSamplePlayback::_decodedFrames(int64_t lo, int64_t hi) {
+  const unsigned chans = m_info.m_channels;
+  if (lo < m_winStart || lo > m_winEnd) {
+    m_decoder->seek(size_t(lo));
+    m_winStart = m_winEnd = int64_t(m_decoder->nextFrame());
+  } else if (hi >= m_winEnd && lo > m_winStart) {
+    /* Keep the overlapping taps and refill behind them */
+    std::memmove(m_window.data(), m_window.data() + (lo - m_winStart) * chans,
+                 (m_winEnd - lo) * chans * sizeof(int16_t));
+    m_winStart = lo;
+  }
+  while (hi >= m_winEnd) {
+    const size_t decoded = m_decoder->decodeBlock(m_window.data() + (m_winEnd - m_winStart) * chans);
+    if (!decoded)
+      break;
+    m_winEnd += int64_t(decoded);
+  }
+  return m_window.data() + (lo - m_winStart) * chans;
+}
+
+double AudioSamplePlayback::_nextPos(double pos) const {
+  if (m_info.isLooped() && pos >= double(m_info.m_loopEnd)) {
+    double loopLen = double(m_info.m_loopEnd - m_info.m_loopStart);
+    pos = m_info.m_loopStart + std::fmod(pos - m_info.m_loopStart, loopLen);
+  }
+  return pos;
+}
+
+void AudioSamplePlayback::setStep(double step, size_t slewFrames) {
+  m_targetStep = step;
+  if (slewFrames) {
+    m_slewDelta = (step - m_step) / double(slewFrames);
+    m_slewFrames = slewFrames;
+  } else {
+    m_step = step;
+    m_slewFrames = 0;
+  }
+}
+
+template <unsigned Chans, typename T>
+size_t AudioSamplePlayback::_render(T* out, size_t frames) {
+  const int16_t* pcm = m_info.m_pcm;
+  const bool looped = m_info.isLooped();
+  const int64_t limit = int64_t(looped ? m_info.m_loopEnd : m_info.m_frames);
+  const int64_t loopStart = int64_t(m_info.m_loopStart);
+  const int64_t loopLen = limit - loopStart;
+
+  /* Slow path for taps straddling the sample start, loop point or end */
+  auto fetch = [&](int64_t idx, unsigned ch) -> float {
+    if (idx < 0)
+      return 0.f;
+    if (idx >= limit) {
+      if (!looped)
+        return 0.f;
+      idx = loopStart + (idx - loopStart) % loopLen;
+      if (m_decoder)
+        return m_loopHead[(idx - loopStart) * Chans + ch];
+    }
+    if (m_decoder)
+      return _decodedFrames(idx, idx)[ch];
+    return pcm[idx * Chans + ch];
+  };
+
+  size_t f = 0;
+#if __SSE__
+  /* Interpolation math runs 4 lanes wide: 4 mono frames or 2 stereo frames per vector */
+  constexpr size_t Block = 4 / Chans;
+  while (f + Block <= frames) {
+    if (!looped && m_pos + (Block + 1) * std::max(m_step, m_targetStep) >= double(limit))
+      break;
+
+    alignas(16) float xm1[4], x0[4], x1[4], x2[4], t[4];
+    for (size_t k = 0; k < Block; ++k) {
+      const int64_t i = int64_t(m_pos);
+      const float frac = float(m_pos - double(i));
+      if (i >= 1 && i + 2 < limit) {
+        const int16_t* s = m_decoder ? _decodedFrames(i - 1, i + 2) : pcm + (i - 1) * Chans;
+        for (unsigned c = 0; c < Chans; ++c) {
+          xm1[k * Chans + c] = s[c];
+          x0[k * Chans + c] = s[Chans + c];
+          x1[k * Chans + c] = s[Chans * 2 + c];
+          x2[k * Chans + c] = s[Chans * 3 + c];
+        }
+      } else {
+        for (unsigned c = 0; c < Chans; ++c) {
+          xm1[k * Chans + c] = fetch(i - 1, c);
+          x0[k * Chans + c] = fetch(i, c);
+          x1[k * Chans + c] = fetch(i + 1, c);
+          x2[k * Chans + c] = fetch(i + 2, c);
+        }
+      }
+      for (unsigned c = 0; c < Chans; ++c)
+        t[k * Chans + c] = frac;
+      m_pos = _nextPos(m_pos + _advanceStep());
+    }
+
+    StoreVec(out + f * Chans,
+             HermiteVec(_mm_load_ps(xm1), _mm_load_ps(x0), _mm_load_ps(x1), _mm_load_ps(x2), _mm_load_ps(t)));
+    f += Block;
+  }
+#endif
+
+  for (; f < frames; ++f) {
+    if (!looped && m_pos >= double(limit))
+      break;
+    const int64_t i = int64_t(m_pos);
+    const float frac = float(m_pos - double(i));
+    for (unsigned c = 0; c < Chans; ++c)
+      StoreSample(out + f * Chans + c, Hermite(fetch(i - 1, c), fetch(i, c), fetch(i + 1, c), fetch(i + 2, c), frac));
+    m_pos = _nextPos(m_pos + _advanceStep());
+  }
+
+  if (!looped && m_pos >= double(limit))
+    m_done = true;
+
+  return f;
+}
+
+template <unsigned Chans, typename T>
+size_t AudioSamplePlayback::_renderUnity(T* out, size_t frames) {
+  /* Source already at the output rate (e.g. a cached resample) and unpitched; plain format conversion */
+  const bool looped = m_info.isLooped();
+  const size_t limit = looped ? m_info.m_loopEnd : m_info.m_frames;
+
+  size_t f = 0;
+  while (f < frames) {
+    const size_t i = size_t(m_pos);
+    if (i >= limit)
+      break;
+    const size_t run = std::min(frames - f, limit - i);
+    const int16_t* in = m_info.m_pcm + i * Chans;
+    for (size_t s = 0; s < run * Chans; ++s)
+      StoreSample(out + f * Chans + s, float(in[s]));
+    f += run;
+    m_pos = _nextPos(double(i + run));
+  }
+
+  if (!looped && m_pos >= double(limit))
+    m_done = true;
+
+  return f;
+}
+
+template <typename T>
+size_t AudioSamplePlayback::render(T* out, size_t frames) {
+  if (m_done)
+    return 0;
+  const bool unity = !m_decoder && !m_slewFrames && m_step == 1.0 && m_pos == std::floor(m_pos);
+  if (m_info.m_channels == 2)
+    return unity ? _renderUnity<2>(out, frames) : _render<2>(out, frames);
+  return unity ? _renderUnity<1>(out, frames) : _render<1>(out, frames);
+}
+
+template size_t AudioSamplePlayback::render<int16_t>(int16_t* out, size_t frames);
+template size_t AudioSamplePlayback::render<int32_t>(int32_t* out, size_t frames);
+template size_t AudioSamplePlayback::render<float>(float* out, size_t frames);
+
+void AudioSamplePlayback::skip(size_t frames) {
+  if (m_done)
+    return;
+  for (; frames && m_slewFrames; --frames)
+    m_pos += _advanceStep();
+  m_pos = _nextPos(m_pos + m_step * double(frames));
+  if (!m_info.isLooped() && m_pos >= double(m_info.m_frames))
+    m_done = true;
+}
+
+} // namespace boo
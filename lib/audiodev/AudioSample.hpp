@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace boo {
+class AudioSampleDecoder;
+
+enum class AudioSampleFormat { PCM16, IMAADPCM, DSPADPCM };
+
+/** Immutable sample data owned by the client (may be memory-mapped) */
+struct AudioSampleInfo {
+  AudioSampleFormat m_format = AudioSampleFormat::PCM16;
+  /* PCM16: interleaved frames */
+  const int16_t* m_pcm = nullptr;
+  /* IMAADPCM: WAV-layout blocks of m_blockBytes covering all channels.
+   * DSPADPCM: one stream of 8-byte frames per channel, m_blockBytes apart, with 8 coefficient pairs per channel */
+  const uint8_t* m_adpcm = nullptr;
+  size_t m_blockBytes = 0;
+  const int16_t* m_dspCoefs = nullptr;
+  size_t m_frames = 0;
+  unsigned m_channels = 1;
+  double m_sampleRate = 32000.0;
+  size_t m_loopStart = 0;
+  size_t m_loopEnd = 0;
+  /* Keeps engine-owned data (e.g. a cached resample) alive for as long as the sample is in use */
+  std::shared_ptr<const void> m_owner;
+  bool isLooped() const { return m_loopEnd > m_loopStart && m_loopEnd <= m_frames; }
+  bool isCompressed() const { return m_format != AudioSampleFormat::PCM16; }
+};
+
+/** Playback cursor for engine-owned sample voices.
+ *  Renders pitch-shifted frames straight from the shared sample data using
+ *  4-point cubic Hermite interpolation; no client callback or intermediate copy is involved.
+ *  ADPCM sources are expanded a block at a time into a small per-voice window */
+class AudioSamplePlayback {
+  AudioSampleInfo m_info;
+  double m_pos = 0.0;
+  double m_step = 1.0;
+  double m_targetStep = 1.0;
+  double m_slewDelta = 0.0;
+  size_t m_slewFrames = 0;
+  bool m_done = false;
+
+  /* Compressed sources only */
+  std::unique_ptr<AudioSampleDecoder> m_decoder;
+  std::vector<int16_t> m_window;
+  int64_t m_winStart = 0;
+  int64_t m_winEnd = 0;
+  int16_t m_loopHead[3 * 2] = {};
+  const int16_t* _decodedFrames(int64_t lo, int64_t hi);
+
+  double _nextPos(double pos) const;
+  double _advanceStep() {
+    double step = m_step;
+    if (m_slewFrames) {
+      m_step += m_slewDelta;
+      if (--m_slewFrames == 0)
+        m_step = m_targetStep;
+    }
+    return step;
+  }
+
+  template <unsigned Chans, typename T>
+  size_t _render(T* out, size_t frames);
+  template <unsigned Chans, typename T>
+  size_t _renderUnity(T* out, size_t frames);
+
+public:
+  explicit AudioSamplePlayback(const AudioSampleInfo& info);
+  ~AudioSamplePlayback();
+
+  const AudioSampleInfo& info() const { return m_info; }
+
+  /** Set source frames consumed per output frame, optionally ramping over slewFrames */
+  void setStep(double step, size_t slewFrames);
+
+  /** Return cursor to start of sample */
+  void rewind() {
+    m_pos = 0.0;
+    m_done = false;
+  }
+
+  /** True once a non-looping sample has played past its last frame */
+  bool isDone() const { return m_done; }
+
+  /** Interpolate up to `frames` interleaved frames into out; returns frames written */
+  template <typename T>
+  size_t render(T* out, size_t frames);
+
+  /** Advance cursor without rendering (used while voice is silent) */
+  void skip(size_t frames);
+};
+
+} // namespace boo
@@ -0,0 +1,128 @@
+#include "lib/audiodev/AudioSampleCache.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include <logvisor/logvisor.hpp>
+#include <soxr.h>
+
+#include "xxhash/xxhash.h"
+
+#undef min
+#undef max
+
+namespace boo {
+static logvisor::Module Log("boo::AudioSampleCache");
+
+namespace {
+constexpr unsigned long CacheQuality = SOXR_20_BITQ;
+
+struct CacheKeyParams {
+  uint64_t m_dataHash;
+  uint64_t m_frames;
+  double m_sampleRate;
+  double m_deviceRate;
+  uint64_t m_loopStart;
+  uint64_t m_loopEnd;
+  uint32_t m_channels;
+  uint32_t m_quality;
+};
+} // Anonymous namespace
+
+void AudioSampleCache::_evict() {
+  while (m_usage > m_budget && !m_lru.empty()) {
+    const Entry& entry = *m_lru.back();
+    m_usage -= _entryBytes(entry);
+    m_index.erase(entry.m_key);
+    m_lru.pop_back();
+  }
+}
+
+void AudioSampleCache::setBudget(size_t bytes) {
+  std::unique_lock lk(m_lock);
+  m_budget = bytes;
+  _evict();
+}
+
+void AudioSampleCache::clear() {
+  std::unique_lock lk(m_lock);
+  m_lru.clear();
+  m_index.clear();
+  m_usage = 0;
+}
+
+AudioSampleInfo AudioSampleCache::lookup(const AudioSampleInfo& info, double deviceRate) {
+  {
+    std::unique_lock lk(m_lock);
+    if (!m_budget)
+      return {};
+  }
+
+  CacheKeyParams params = {};
+  params.m_dataHash = XXH64(info.m_pcm, info.m_frames * info.m_channels * sizeof(int16_t), 0);
+  params.m_frames = info.m_frames;
+  params.m_sampleRate = info.m_sampleRate;
+  params.m_deviceRate = deviceRate;
+  params.m_loopStart = info.m_loopStart;
+  params.m_loopEnd = info.m_loopEnd;
+  params.m_channels = info.m_channels;
+  params.m_quality = CacheQuality;
+  const uint64_t key = XXH64(&params, sizeof(params), 0);
+
+  {
+    std::unique_lock lk(m_lock);
+    auto search = m_index.find(key);
+    if (search != m_index.end()) {
+      m_lru.splice(m_lru.begin(), m_lru, search->second);
+      const std::shared_ptr<const Entry>& entry = *search->second;
+      AudioSampleInfo ret = entry->m_info;
+      ret.m_owner = entry;
+      return ret;
+    }
+  }
+
+  /* Miss: resample outside the lock, this runs on the allocating client thread */
+  const double ratio = deviceRate / info.m_sampleRate;
+  auto entry = std::make_shared<Entry>();
+  entry->m_key = key;
+  entry->m_pcm.resize((size_t(std::ceil(info.m_frames * ratio)) + 1) * info.m_channels);
+
+  soxr_io_spec_t ioSpec = soxr_io_spec(SOXR_INT16_I, SOXR_INT16_I);
+  soxr_quality_spec_t qSpec = soxr_quality_spec(CacheQuality, 0);
+  size_t outFrames = 0;
+  soxr_error_t err = soxr_oneshot(info.m_sampleRate, deviceRate, info.m_channels, info.m_pcm, info.m_frames, nullptr,
+                                  entry->m_pcm.data(), entry->m_pcm.size() / info.m_channels, &outFrames, &ioSpec,
+                                  &qSpec, nullptr);
+  if (err) {
+    Log.report(logvisor::Error, FMT_STRING("unable to resample cached sample: {}"), soxr_strerror(err));
+    return {};
+  }
+  entry->m_pcm.resize(outFrames * info.m_channels);
+
+  AudioSampleInfo& resampled = entry->m_info;
+  resampled = info;
+  resampled.m_pcm = entry->m_pcm.data();
+  resampled.m_frames = outFrames;
+  resampled.m_sampleRate = deviceRate;
+  if (info.isLooped()) {
+    resampled.m_loopStart = std::min(size_t(std::llround(info.m_loopStart * ratio)), outFrames);
+    resampled.m_loopEnd = std::min(size_t(std::llround(info.m_loopEnd * ratio)), outFrames);
+  }
+
+  std::shared_ptr<const Entry> constEntry = std::move(entry);
+  {
+    std::unique_lock lk(m_lock);
+    if (m_index.find(key) == m_index.end()) {
+      m_lru.push_front(constEntry);
+      m_index[key] = m_lru.begin();
+      m_usage += _entryBytes(*constEntry);
+      _evict();
+    }
+  }
+
+  AudioSampleInfo ret = constEntry->m_info;
+  ret.m_owner = constEntry;
+  return ret;
+}
+
+} // namespace boo
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "lib/audiodev/AudioSample.hpp"
+
+namespace boo {
+
+/** Content-addressed store of PCM samples pre-resampled to the device rate.
+ *  Entries are keyed by xxhash of the sample data together with source rate,
+ *  device rate and resampler quality; least-recently-used entries are dropped
+ *  once the memory budget is exceeded. Voices share entries by reference, so
+ *  eviction never pulls data out from under a playing voice */
+class AudioSampleCache {
+  struct Entry {
+    std::vector<int16_t> m_pcm;
+    AudioSampleInfo m_info;
+    uint64_t m_key;
+  };
+  using LRUList = std::list<std::shared_ptr<const Entry>>;
+
+  std::mutex m_lock;
+  size_t m_budget = 16 * 1024 * 1024;
+  size_t m_usage = 0;
+  LRUList m_lru;
+  std::unordered_map<uint64_t, LRUList::iterator> m_index;
+
+  static size_t _entryBytes(const Entry& entry) { return sizeof(Entry) + entry.m_pcm.size() * sizeof(int16_t); }
+  void _evict();
+
+public:
+  /** Set memory budget in bytes; 0 disables caching */
+  void setBudget(size_t bytes);
+
+  /** Drop all entries (device rate changed) */
+  void clear();
+
+  /** Return info describing `info` resampled to deviceRate, resampling and caching on a miss.
+   *  The returned info keeps the cached data alive; an empty m_pcm is returned when
+   *  caching is disabled or resampling fails */
+  AudioSampleInfo lookup(const AudioSampleInfo& info, double deviceRate);
+};
+
+} // namespace boo
@@ -0,0 +1,181 @@
+#include "lib/audiodev/AudioSampleDecoder.hpp"
+#include "lib/audiodev/AudioMatrix.hpp"
+
+#include <algorithm>
+
+#undef min
+#undef max
+
+namespace boo {
+namespace {
+constexpr int16_t IMAStepTable[89] = {
+    7,     8,     9,     10,    11,    12,    13,    14,    16,    17,    19,    21,    23,    25,    28,
+    31,    34,    37,    41,    45,    50,    55,    60,    66,    73,    80,    88,    97,    107,   118,
+    130,   143,   157,   173,   190,   209,   230,   253,   279,   307,   337,   371,   408,   449,   494,
+    544,   598,   658,   724,   796,   876,   963,   1060,  1166,  1282,  1411,  1552,  1707,  1878,  2066,
+    2272,  2499,  2749,  3024,  3327,  3660,  4026,  4428,  4871,  5358,  5894,  6484,  7132,  7845,  8630,
+    9493,  10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767};
+
+constexpr int8_t IMAIndexTable[16] = {-1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8};
+
+int16_t IMAExpand(int32_t& pred, int32_t& index, uint8_t nibble) {
+  const int32_t step = IMAStepTable[index];
+  int32_t diff = step >> 3;
+  if (nibble & 4)
+    diff += step;
+  if (nibble & 2)
+    diff += step >> 1;
+  if (nibble & 1)
+    diff += step >> 2;
+  pred = std::clamp(nibble & 8 ? pred - diff : pred + diff, -32768, 32767);
+  index = std::clamp(index + IMAIndexTable[nibble], 0, 88);
+  return int16_t(pred);
+}
+
+constexpr int32_t DSPNibbles[16] = {0, 1, 2, 3, 4, 5, 6, 7, -8, -7, -6, -5, -4, -3, -2, -1};
+} // Anonymous namespace
+
+AudioSampleDecoder::AudioSampleDecoder(const AudioSampleInfo& info) : m_info(info) {
+  const unsigned chans = std::clamp(m_info.m_channels, 1u, MaxChannels);
+  m_info.m_channels = chans;
+  if (m_info.m_format == AudioSampleFormat::IMAADPCM)
+    m_blockFrames = (m_info.m_blockBytes - 4 * chans) * 2 / chans + 1;
+  else
+    m_blockFrames = DSPFrameSamples * DSPFramesPerBlock;
+}
+
+void AudioSampleDecoder::_decodeIMA(int16_t* out, size_t frames) const {
+  /* WAV block layout: per-channel {int16 sample, uint8 index, uint8 pad} header,
+   * then 4-byte runs of 8 nibbles, alternating channels */
+  const unsigned chans = m_info.m_channels;
+  const uint8_t* block = m_info.m_adpcm + m_nextFrame / m_blockFrames * m_info.m_blockBytes;
+  const uint8_t* data = block + 4 * chans;
+
+  int32_t pred[MaxChannels], index[MaxChannels];
+  for (unsigned c = 0; c < chans; ++c) {
+    pred[c] = int16_t(block[c * 4] | block[c * 4 + 1] << 8);
+    index[c] = std::min(int32_t(block[c * 4 + 2]), 88);
+    out[c] = int16_t(pred[c]);
+  }
+
+  for (size_t f = 1; f < frames; ++f) {
+    const size_t n = f - 1;
+    const uint8_t* run = data + (n / 8) * 4 * chans + (n % 8) / 2;
+    for (unsigned c = 0; c < chans; ++c) {
+      const uint8_t byte = run[c * 4];
+      out[f * chans + c] = IMAExpand(pred[c], index[c], (n & 1) ? byte >> 4 : byte & 0xf);
+    }
+  }
+}
+
+void AudioSampleDecoder::_decodeDSP(int16_t* out, size_t frames) {
+  /* One stream of 8-byte frames per channel, m_blockBytes apart; each frame is a
+   * {predictor:4, shift:4} header followed by 14 nibbles, high nibble first.
+   * The second-order predictor runs with channels in SIMD lanes */
+  const unsigned chans = m_info.m_channels;
+  size_t pos = m_nextFrame;
+  const size_t end = pos + frames;
+
+  while (pos < end) {
+    const size_t dspFrame = pos / DSPFrameSamples;
+    if (!m_loopSnapValid && m_info.isLooped() && dspFrame == m_info.m_loopStart / DSPFrameSamples) {
+      m_loopSnapValid = true;
+      m_loopSnapFrame = dspFrame * DSPFrameSamples;
+      std::copy(std::begin(m_hist), std::end(m_hist), std::begin(m_loopSnapHist));
+    }
+
+    const uint8_t* frame[MaxChannels];
+    alignas(16) int32_t coefs[4] = {};
+    int32_t shift[MaxChannels];
+    for (unsigned c = 0; c < chans; ++c) {
+      frame[c] = m_info.m_adpcm + c * m_info.m_blockBytes + dspFrame * DSPFrameBytes;
+      const uint8_t ps = frame[c][0];
+      const int16_t* cf = m_info.m_dspCoefs + c * 16 + ((ps >> 4) & 7) * 2;
+      coefs[c] = int32_t(uint16_t(cf[0]) | uint32_t(uint16_t(cf[1])) << 16);
+      shift[c] = ps & 0xf;
+    }
+
+    const size_t count = std::min(DSPFrameSamples, end - pos);
+#if __SSE__
+    const __m128i coefVec = _mm_load_si128(reinterpret_cast<const __m128i*>(coefs));
+    alignas(16) int32_t histLanes[4] = {};
+    std::copy(m_hist, m_hist + chans, histLanes);
+    __m128i hist = _mm_load_si128(reinterpret_cast<const __m128i*>(histLanes));
+    for (size_t n = 0; n < count; ++n) {
+      alignas(16) int32_t deltas[4] = {};
+      for (unsigned c = 0; c < chans; ++c) {
+        const uint8_t byte = frame[c][1 + n / 2];
+        deltas[c] = (DSPNibbles[(n & 1) ? byte & 0xf : byte >> 4] << shift[c]) << 11;
+      }
+      __m128i sum = _mm_add_epi32(_mm_madd_epi16(hist, coefVec),
+                                  _mm_add_epi32(_mm_load_si128(reinterpret_cast<const __m128i*>(deltas)),
+                                                _mm_set1_epi32(1024)));
+      __m128i packed = _mm_packs_epi32(_mm_srai_epi32(sum, 11), _mm_setzero_si128());
+      hist = _mm_or_si128(_mm_unpacklo_epi16(packed, _mm_setzero_si128()), _mm_slli_epi32(hist, 16));
+      if (out) {
+        alignas(16) int16_t samples[8];
+        _mm_store_si128(reinterpret_cast<__m128i*>(samples), packed);
+        for (unsigned c = 0; c < chans; ++c)
+          out[(pos - m_nextFrame + n) * chans + c] = samples[c];
+      }
+    }
+    _mm_store_si128(reinterpret_cast<__m128i*>(histLanes), hist);
+    std::copy(histLanes, histLanes + chans, m_hist);
+#else
+    for (unsigned c = 0; c < chans; ++c) {
+      const int32_t coef1 = int16_t(coefs[c] & 0xffff);
+      const int32_t coef2 = int16_t(coefs[c] >> 16);
+      int32_t hist1 = int16_t(m_hist[c] & 0xffff);
+      int32_t hist2 = int16_t(m_hist[c] >> 16);
+      for (size_t n = 0; n < count; ++n) {
+        const uint8_t byte = frame[c][1 + n / 2];
+        const int32_t delta = (DSPNibbles[(n & 1) ? byte & 0xf : byte >> 4] << shift[c]) << 11;
+        const int32_t sample = std::clamp((delta + 1024 + coef1 * hist1 + coef2 * hist2) >> 11, -32768, 32767);
+        hist2 = hist1;
+        hist1 = sample;
+        if (out)
+          out[(pos - m_nextFrame + n) * chans + c] = int16_t(sample);
+      }
+      m_hist[c] = int32_t(uint16_t(hist1) | uint32_t(uint16_t(hist2)) << 16);
+    }
+#endif
+    pos += count;
+  }
+}
+
+void AudioSampleDecoder::seek(size_t frame) {
+  if (m_info.m_format == AudioSampleFormat::IMAADPCM) {
+    m_nextFrame = frame / m_blockFrames * m_blockFrames;
+    return;
+  }
+
+  /* DSP frames depend on predictor history; rewind to the loop snapshot or start, then run forward */
+  const size_t aligned = frame / DSPFrameSamples * DSPFrameSamples;
+  if (aligned < m_nextFrame) {
+    if (m_loopSnapValid && m_loopSnapFrame <= aligned) {
+      m_nextFrame = m_loopSnapFrame;
+      std::copy(std::begin(m_loopSnapHist), std::end(m_loopSnapHist), std::begin(m_hist));
+    } else {
+      m_nextFrame = 0;
+      std::fill(std::begin(m_hist), std::end(m_hist), 0);
+    }
+  }
+  if (aligned > m_nextFrame) {
+    _decodeDSP(nullptr, aligned - m_nextFrame);
+    m_nextFrame = aligned;
+  }
+}
+
+size_t AudioSampleDecoder::decodeBlock(int16_t* out) {
+  if (m_nextFrame >= m_info.m_frames)
+    return 0;
+  const size_t frames = std::min(m_blockFrames, m_info.m_frames - m_nextFrame);
+  if (m_info.m_format == AudioSampleFormat::IMAADPCM)
+    _decodeIMA(out, frames);
+  else
+    _decodeDSP(out, frames);
+  m_nextFrame += frames;
+  return frames;
+}
+
+} // namespace boo
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "lib/audiodev/AudioSample.hpp"
+
+namespace boo {
+
+/** Incremental ADPCM decoder for engine-owned sample voices.
+ *  Expands one block at a time (an IMA block, or a run of DSP frames) so only
+ *  the region a voice is actually playing is ever held as PCM */
+class AudioSampleDecoder {
+public:
+  static constexpr unsigned MaxChannels = 2;
+  static constexpr size_t DSPFrameSamples = 14;
+  static constexpr size_t DSPFrameBytes = 8;
+  static constexpr size_t DSPFramesPerBlock = 8;
+
+private:
+  AudioSampleInfo m_info;
+  size_t m_blockFrames = 0;
+  size_t m_nextFrame = 0;
+
+  /* DSP predictor history, one lane per channel packed as (hist1 | hist2 << 16) */
+  int32_t m_hist[MaxChannels] = {};
+
+  /* DSP history at the frame holding the loop start; captured on first pass */
+  bool m_loopSnapValid = false;
+  size_t m_loopSnapFrame = 0;
+  int32_t m_loopSnapHist[MaxChannels] = {};
+
+  void _decodeIMA(int16_t* out, size_t frames) const;
+  void _decodeDSP(int16_t* out, size_t frames);
+
+public:
+  explicit AudioSampleDecoder(const AudioSampleInfo& info);
+
+  /** Largest number of frames a single decodeBlock() call produces */
+  size_t blockFrames() const { return m_blockFrames; }
+
+  /** Index of the first frame the next decodeBlock() call produces */
+  size_t nextFrame() const { return m_nextFrame; }
+
+  /** Position decoder at the block boundary at or before frame */
+  void seek(size_t frame);
+
+  /** Decode the next block as interleaved PCM; returns frames written (0 at end of sample) */
+  size_t decodeBlock(int16_t* out);
+};
+
+} // namespace boo
@@ -1,17 +1,22 @@
 #include "AudioVoice.hpp"
 #include "AudioVoiceEngine.hpp"
 #include "logvisor/logvisor.hpp"
+#include <algorithm>
 #include <cmath>
+#include <cstring>
 
 namespace boo {
 static logvisor::Module Log("boo::AudioVoice");
 
-static AudioMatrixMono DefaultMonoMtx;
-static AudioMatrixStereo DefaultStereoMtx;
-
 AudioVoice::AudioVoice(BaseAudioVoiceEngine& root, IAudioVoiceCallback* cb, bool dynamicRate)
 : ListNode<AudioVoice, BaseAudioVoiceEngine*, IAudioVoice>(&root), m_cb(cb), m_dynamicRate(dynamicRate) {}
 
+AudioVoice::AudioVoice(BaseAudioVoiceEngine& root, const AudioSampleInfo& sample)
+: ListNode<AudioVoice, BaseAudioVoiceEngine*, IAudioVoice>(&root)
+, m_cb(nullptr)
+, m_sample(std::make_unique<AudioSamplePlayback>(sample))
+, m_dynamicRate(true) {}
+
 AudioVoice::~AudioVoice() { soxr_delete(m_src); }
 
 AudioVoice*& AudioVoice::_getHeadPtr(BaseAudioVoiceEngine* head) { return head->m_voiceHead; }
@@ -20,7 +25,13 @@ std::unique_lock<std::recursive_mutex> AudioVoice::_getHeadLock(BaseAudioVoiceEn
 }
 
 void AudioVoice::_setPitchRatio(double ratio, bool slew) {
-  if (m_dynamicRate) {
+  if (m_sample) {
+    m_sampleRatio = ratio * m_sampleRateIn / m_sampleRateOut;
+    m_sample->setStep(m_sampleRatio, slew ? m_head->m_5msFrames : 0);
+  } else if (m_fastSrc) {
+    m_sampleRatio = (m_dynamicRate ? ratio : 1.0) * m_sampleRateIn / m_sampleRateOut;
+    m_fastSrc->setRatio(m_sampleRatio, slew ? m_head->m_5msFrames : 0);
+  } else if (m_dynamicRate) {
     m_sampleRatio = ratio * m_sampleRateIn / m_sampleRateOut;
     soxr_error_t err = soxr_set_io_ratio(m_src, m_sampleRatio, slew ? m_head->m_5msFrames : 0);
     if (err) {
@@ -32,11 +43,24 @@ void AudioVoice::_setPitchRatio(double ratio, bool slew) {
   m_setPitchRatio = false;
 }
 
+void AudioVoice::_resetSampleSourceRate(double sampleRate) {
+  m_sampleRateIn = sampleRate;
+  m_sampleRateOut = m_head->mixInfo().m_sampleRate;
+  m_sampleRatio = m_sampleRateIn / m_sampleRateOut;
+  _setPitchRatio(m_pitchRatio, false);
+  m_resetSampleRate = false;
+}
+
 void AudioVoice::_midUpdate() {
   if (m_resetSampleRate)
     _resetSampleRate(m_deferredSampleRate);
   if (m_setPitchRatio)
     _setPitchRatio(m_pitchRatio, m_slew);
+  if (m_setFilter || (m_filter.isActive() && m_filterSampleRate != m_sampleRateOut)) {
+    m_filter.setParameters(m_filterType, m_filterCutoff, m_filterQ, m_sampleRateOut, m_setFilter && m_filterSlew);
+    m_filterSampleRate = m_sampleRateOut;
+    m_setFilter = false;
+  }
 }
 
 void AudioVoice::setPitchRatio(double ratio, bool slew) {
@@ -50,16 +74,99 @@ void AudioVoice::resetSampleRate(double sampleRate) {
   m_deferredSampleRate = sampleRate;
 }
 
-void AudioVoice::start() { m_running = true; }
+void AudioVoice::setFilter(AudioFilterType type, double cutoff, double q, bool slew) {
+  m_filterType = type;
+  m_filterCutoff = cutoff;
+  m_filterQ = q;
+  m_filterSlew = slew;
+  m_setFilter = true;
+}
+
+void AudioVoice::start() {
+  if (m_sample && m_sample->isDone())
+    m_sample->rewind();
+  m_running = true;
+}
 
 void AudioVoice::stop() { m_running = false; }
 
-AudioVoiceMono::AudioVoiceMono(BaseAudioVoiceEngine& root, IAudioVoiceCallback* cb, double sampleRate, bool dynamicRate)
+void AudioVoice::_scheduleEvent(const AudioVoiceEvent& ev) {
+  auto it = std::upper_bound(m_events.begin(), m_events.end(), ev.m_frame,
+                             [](uint64_t frame, const AudioVoiceEvent& other) { return frame < other.m_frame; });
+  m_events.insert(it, ev);
+}
+
+void AudioVoice::_applyEvents(uint64_t frame) {
+  auto it = m_events.begin();
+  for (; it != m_events.end() && it->m_frame <= frame; ++it) {
+    switch (it->m_type) {
+    case AudioVoiceEvent::Type::Start:
+      start();
+      break;
+    case AudioVoiceEvent::Type::Stop:
+      stop();
+      break;
+    case AudioVoiceEvent::Type::PitchRatio:
+      setPitchRatio(it->m_ratio, it->m_slew);
+      break;
+    case AudioVoiceEvent::Type::MonoLevels: {
+      float coefs[8];
+      for (int i = 0; i < 8; ++i)
+        coefs[i] = it->m_coefs[i][0];
+      setMonoChannelLevels(it->m_submix, coefs, it->m_slew);
+      break;
+    }
+    case AudioVoiceEvent::Type::StereoLevels:
+      setStereoChannelLevels(it->m_submix, it->m_coefs, it->m_slew);
+      break;
+    }
+  }
+  m_events.erase(m_events.begin(), it);
+}
+
+void AudioVoice::startAt(uint64_t frame) { _scheduleEvent({frame, AudioVoiceEvent::Type::Start}); }
+
+void AudioVoice::stopAt(uint64_t frame) { _scheduleEvent({frame, AudioVoiceEvent::Type::Stop}); }
+
+void AudioVoice::setPitchRatioAt(uint64_t frame, double ratio, bool slew) {
+  AudioVoiceEvent ev{frame, AudioVoiceEvent::Type::PitchRatio, slew};
+  ev.m_ratio = ratio;
+  _scheduleEvent(ev);
+}
+
+void AudioVoice::setMonoChannelLevelsAt(uint64_t frame, IAudioSubmix* submix, const float coefs[8], bool slew) {
+  AudioVoiceEvent ev{frame, AudioVoiceEvent::Type::MonoLevels, slew};
+  ev.m_submix = submix;
+  for (int i = 0; i < 8; ++i)
+    ev.m_coefs[i][0] = coefs[i];
+  _scheduleEvent(ev);
+}
+
+void AudioVoice::setStereoChannelLevelsAt(uint64_t frame, IAudioSubmix* submix, const float coefs[8][2], bool slew) {
+  AudioVoiceEvent ev{frame, AudioVoiceEvent::Type::StereoLevels, slew};
+  ev.m_submix = submix;
+  std::memcpy(ev.m_coefs, coefs, sizeof(ev.m_coefs));
+  _scheduleEvent(ev);
+}
+
+AudioVoiceMono::AudioVoiceMono(BaseAudioVoiceEngine& root, IAudioVoiceCallback* cb, double sampleRate, bool dynamicRate,
+                               AudioResamplerQuality quality)
 : AudioVoice(root, cb, dynamicRate) {
+  if (quality == AudioResamplerQuality::Fast)
+    m_fastSrc = std::make_unique<AudioStreamResampler>(1, AudioStreamResampler::InputFn(SRCCallback), this);
   _resetSampleRate(sampleRate);
 }
 
+AudioVoiceMono::AudioVoiceMono(BaseAudioVoiceEngine& root, const AudioSampleInfo& sample) : AudioVoice(root, sample) {
+  _resetSampleRate(sample.m_sampleRate);
+}
+
 void AudioVoiceMono::_resetSampleRate(double sampleRate) {
+  if (m_sample || m_fastSrc) {
+    _resetSampleSourceRate(sampleRate);
+    return;
+  }
+
   soxr_delete(m_src);
 
   double rateOut = m_head->mixInfo().m_sampleRate;
@@ -103,7 +210,7 @@ bool AudioVoiceMono::isSilent() const {
         return false;
     return true;
   } else {
-    return DefaultMonoMtx.isSilent();
+    return m_head->m_defaultMonoMtx.isSilent();
   }
 }
 
@@ -118,32 +225,76 @@ size_t AudioVoiceMono::_pumpAndMix(size_t frames) {
     scratchPost.resize(frames + 2);
 
   double dt = frames / m_sampleRateOut;
-  m_cb->preSupplyAudio(*this, dt);
+  if (m_cb)
+    m_cb->preSupplyAudio(*this, dt);
   _midUpdate();
 
   if (isSilent()) {
+    if (m_sample) {
+      m_sample->skip(frames);
+      m_running = !m_sample->isDone();
+      return 0;
+    }
+    if (m_fastSrc) {
+      m_fastSrc->skip(frames);
+      return 0;
+    }
     int16_t* dummy;
     SRCCallback(this, &dummy, size_t(std::ceil(frames * m_sampleRatio)));
     return 0;
   }
 
-  size_t oDone = soxr_output(m_src, scratchPre.data(), frames);
+  size_t oDone;
+  if (m_sample) {
+    oDone = m_sample->render(scratchPre.data(), frames);
+    m_running = !m_sample->isDone();
+  } else if (m_fastSrc) {
+    oDone = m_fastSrc->output(scratchPre.data(), frames);
+  } else {
+    oDone = soxr_output(m_src, scratchPre.data(), frames);
+  }
 
   if (oDone) {
-    if (m_sendMatrices.size()) {
-      for (auto& mtx : m_sendMatrices) {
-        AudioSubmix& smx = *reinterpret_cast<AudioSubmix*>(mtx.first);
-        m_cb->routeAudio(oDone, 1, dt, smx.m_busId, scratchPre.data(), scratchPost.data());
-        mtx.second.mixMonoSampleData(m_head->clientMixInfo(), scratchPost.data(), smx._getMergeBuf<T>(oDone), oDone);
+    if (m_filter.isActive())
+      m_head->m_filterBank.gather(*this, m_filter, 1, scratchPre.data(), oDone, frames);
+    else
+      _mix<T>(oDone, dt);
+  }
+
+  return oDone;
+}
+
+template <typename T>
+void AudioVoiceMono::_mix(size_t frames, double dt) {
+  auto& scratchPre = m_head->_getScratchPre<T>();
+  auto& scratchPost = m_head->_getScratchPost<T>();
+  if (m_sendMatrices.size()) {
+    for (auto& mtx : m_sendMatrices) {
+      AudioSubmix& smx = *reinterpret_cast<AudioSubmix*>(mtx.first);
+      T* mixIn = scratchPre.data();
+      if (m_cb) {
+        m_cb->routeAudio(frames, 1, dt, smx.m_busId, scratchPre.data(), scratchPost.data());
+        mixIn = scratchPost.data();
       }
-    } else {
-      AudioSubmix& smx = *m_head->m_mainSubmix;
-      m_cb->routeAudio(oDone, 1, dt, m_head->m_mainSubmix->m_busId, scratchPre.data(), scratchPost.data());
-      DefaultMonoMtx.mixMonoSampleData(m_head->clientMixInfo(), scratchPost.data(), smx._getMergeBuf<T>(oDone), oDone);
+      mtx.second.mixMonoSampleData(m_head->clientMixInfo(), mixIn, smx._getMergeBuf<T>(frames), frames);
+    }
+  } else {
+    AudioSubmix& smx = *m_head->m_mainSubmix;
+    T* mixIn = scratchPre.data();
+    if (m_cb) {
+      m_cb->routeAudio(frames, 1, dt, m_head->m_mainSubmix->m_busId, scratchPre.data(), scratchPost.data());
+      mixIn = scratchPost.data();
     }
+    m_head->m_defaultMonoMtx.mixMonoSampleData(m_head->clientMixInfo(), mixIn, smx._getMergeBuf<T>(frames), frames);
   }
+}
 
-  return oDone;
+template <typename T>
+void AudioVoiceMono::_mixFiltered(size_t slot, size_t frames) {
+  auto& scratchPre = m_head->_getScratchPre<T>();
+  size_t oDone = m_head->m_filterBank.scatter(slot, scratchPre.data());
+  if (oDone)
+    _mix<T>(oDone, frames / m_sampleRateOut);
 }
 
 void AudioVoiceMono::resetChannelLevels() {
@@ -175,12 +326,24 @@ void AudioVoiceMono::setStereoChannelLevels(IAudioSubmix* submix, const float co
 }
 
 AudioVoiceStereo::AudioVoiceStereo(BaseAudioVoiceEngine& root, IAudioVoiceCallback* cb, double sampleRate,
-                                   bool dynamicRate)
+                                   bool dynamicRate, AudioResamplerQuality quality)
 : AudioVoice(root, cb, dynamicRate) {
+  if (quality == AudioResamplerQuality::Fast)
+    m_fastSrc = std::make_unique<AudioStreamResampler>(2, AudioStreamResampler::InputFn(SRCCallback), this);
   _resetSampleRate(sampleRate);
 }
 
+AudioVoiceStereo::AudioVoiceStereo(BaseAudioVoiceEngine& root, const AudioSampleInfo& sample)
+: AudioVoice(root, sample) {
+  _resetSampleRate(sample.m_sampleRate);
+}
+
 void AudioVoiceStereo::_resetSampleRate(double sampleRate) {
+  if (m_sample || m_fastSrc) {
+    _resetSampleSourceRate(sampleRate);
+    return;
+  }
+
   soxr_delete(m_src);
 
   double rateOut = m_head->mixInfo().m_sampleRate;
@@ -225,7 +388,7 @@ bool AudioVoiceStereo::isSilent() const {
         return false;
     return true;
   } else {
-    return DefaultStereoMtx.isSilent();
+    return m_head->m_defaultStereoMtx.isSilent();
   }
 }
 
@@ -242,33 +405,76 @@ size_t AudioVoiceStereo::_pumpAndMix(size_t frames) {
     scratchPost.resize(samples + 4);
 
   double dt = frames / m_sampleRateOut;
-  m_cb->preSupplyAudio(*this, dt);
+  if (m_cb)
+    m_cb->preSupplyAudio(*this, dt);
   _midUpdate();
 
   if (isSilent()) {
+    if (m_sample) {
+      m_sample->skip(frames);
+      m_running = !m_sample->isDone();
+      return 0;
+    }
+    if (m_fastSrc) {
+      m_fastSrc->skip(frames);
+      return 0;
+    }
     int16_t* dummy;
     SRCCallback(this, &dummy, size_t(std::ceil(frames * m_sampleRatio)));
     return 0;
   }
 
-  size_t oDone = soxr_output(m_src, scratchPre.data(), frames);
+  size_t oDone;
+  if (m_sample) {
+    oDone = m_sample->render(scratchPre.data(), frames);
+    m_running = !m_sample->isDone();
+  } else if (m_fastSrc) {
+    oDone = m_fastSrc->output(scratchPre.data(), frames);
+  } else {
+    oDone = soxr_output(m_src, scratchPre.data(), frames);
+  }
 
   if (oDone) {
-    if (m_sendMatrices.size()) {
-      for (auto& mtx : m_sendMatrices) {
-        AudioSubmix& smx = *reinterpret_cast<AudioSubmix*>(mtx.first);
-        m_cb->routeAudio(oDone, 2, dt, smx.m_busId, scratchPre.data(), scratchPost.data());
-        mtx.second.mixStereoSampleData(m_head->clientMixInfo(), scratchPost.data(), smx._getMergeBuf<T>(oDone), oDone);
+    if (m_filter.isActive())
+      m_head->m_filterBank.gather(*this, m_filter, 2, scratchPre.data(), oDone, frames);
+    else
+      _mix<T>(oDone, dt);
+  }
+
+  return oDone;
+}
+
+template <typename T>
+void AudioVoiceStereo::_mix(size_t frames, double dt) {
+  auto& scratchPre = m_head->_getScratchPre<T>();
+  auto& scratchPost = m_head->_getScratchPost<T>();
+  if (m_sendMatrices.size()) {
+    for (auto& mtx : m_sendMatrices) {
+      AudioSubmix& smx = *reinterpret_cast<AudioSubmix*>(mtx.first);
+      T* mixIn = scratchPre.data();
+      if (m_cb) {
+        m_cb->routeAudio(frames, 2, dt, smx.m_busId, scratchPre.data(), scratchPost.data());
+        mixIn = scratchPost.data();
       }
-    } else {
-      AudioSubmix& smx = *m_head->m_mainSubmix;
-      m_cb->routeAudio(oDone, 2, dt, m_head->m_mainSubmix->m_busId, scratchPre.data(), scratchPost.data());
-      DefaultStereoMtx.mixStereoSampleData(m_head->clientMixInfo(), scratchPost.data(), smx._getMergeBuf<T>(oDone),
-                                           oDone);
+      mtx.second.mixStereoSampleData(m_head->clientMixInfo(), mixIn, smx._getMergeBuf<T>(frames), frames);
+    }
+  } else {
+    AudioSubmix& smx = *m_head->m_mainSubmix;
+    T* mixIn = scratchPre.data();
+    if (m_cb) {
+      m_cb->routeAudio(frames, 2, dt, m_head->m_mainSubmix->m_busId, scratchPre.data(), scratchPost.data());
+      mixIn = scratchPost.data();
     }
+    m_head->m_defaultStereoMtx.mixStereoSampleData(m_head->clientMixInfo(), mixIn, smx._getMergeBuf<T>(frames), frames);
   }
+}
 
-  return oDone;
+template <typename T>
+void AudioVoiceStereo::_mixFiltered(size_t slot, size_t frames) {
+  auto& scratchPre = m_head->_getScratchPre<T>();
+  size_t oDone = m_head->m_filterBank.scatter(slot, scratchPre.data());
+  if (oDone)
+    _mix<T>(oDone, frames / m_sampleRateOut);
 }
 
 void AudioVoiceStereo::resetChannelLevels() {
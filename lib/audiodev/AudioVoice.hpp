@@ -1,10 +1,15 @@
 #pragma once
 
+#include <memory>
 #include <mutex>
 #include <unordered_map>
+#include <vector>
 
 #include "boo/audiodev/IAudioVoice.hpp"
+#include "lib/audiodev/AudioFilterBank.hpp"
 #include "lib/audiodev/AudioMatrix.hpp"
+#include "lib/audiodev/AudioResampler.hpp"
+#include "lib/audiodev/AudioSample.hpp"
 #include "lib/audiodev/AudioVoiceEngine.hpp"
 #include "lib/audiodev/Common.hpp"
 
@@ -19,6 +24,17 @@ class BaseAudioVoiceEngine;
 struct AudioVoiceEngineMixInfo;
 struct IAudioSubmix;
 
+/** Voice parameter change scheduled for an absolute engine frame */
+struct AudioVoiceEvent {
+  enum class Type { Start, Stop, PitchRatio, MonoLevels, StereoLevels };
+  uint64_t m_frame;
+  Type m_type;
+  bool m_slew = false;
+  double m_ratio = 1.0;
+  IAudioSubmix* m_submix = nullptr;
+  float m_coefs[8][2] = {};
+};
+
 class AudioVoice : public ListNode<AudioVoice, BaseAudioVoiceEngine*, IAudioVoice> {
   friend class BaseAudioVoiceEngine;
   friend class AudioSubmix;
@@ -31,8 +47,12 @@ protected:
   /* Callback (audio source) */
   IAudioVoiceCallback* m_cb;
 
-  /* Sample-rate converter */
+  /* Engine-owned sample source (replaces callback and soxr when set) */
+  std::unique_ptr<AudioSamplePlayback> m_sample;
+
+  /* Sample-rate converter (soxr, or the Hermite stream resampler for AudioResamplerQuality::Fast) */
   soxr_t m_src = nullptr;
+  std::unique_ptr<AudioStreamResampler> m_fastSrc;
   double m_sampleRateIn;
   double m_sampleRateOut;
   bool m_dynamicRate;
@@ -44,6 +64,7 @@ protected:
   bool m_resetSampleRate = false;
   double m_deferredSampleRate;
   virtual void _resetSampleRate(double sampleRate) = 0;
+  void _resetSampleSourceRate(double sampleRate);
 
   /* Deferred pitch ratio set */
   bool m_setPitchRatio = false;
@@ -52,6 +73,20 @@ protected:
   bool m_slew = false;
   void _setPitchRatio(double ratio, bool slew);
 
+  /* Built-in filter stage, run by the engine's AudioFilterBank */
+  bool m_setFilter = false;
+  AudioFilterType m_filterType = AudioFilterType::None;
+  double m_filterCutoff = 0.0;
+  double m_filterQ = 0.0;
+  bool m_filterSlew = false;
+  double m_filterSampleRate = 0.0;
+  AudioVoiceFilter m_filter;
+
+  /* Timestamped events, ordered by frame; applied by the engine at sub-block boundaries */
+  std::vector<AudioVoiceEvent> m_events;
+  void _scheduleEvent(const AudioVoiceEvent& ev);
+  void _applyEvents(uint64_t frame);
+
   /* Mid-pump update */
   void _midUpdate();
 
@@ -61,7 +96,14 @@ protected:
   template <typename T>
   size_t pumpAndMix(size_t frames);
 
+  virtual void mixFiltered16(size_t slot, size_t frames) = 0;
+  virtual void mixFiltered32(size_t slot, size_t frames) = 0;
+  virtual void mixFilteredFlt(size_t slot, size_t frames) = 0;
+  template <typename T>
+  void mixFiltered(size_t slot, size_t frames);
+
   AudioVoice(BaseAudioVoiceEngine& root, IAudioVoiceCallback* cb, bool dynamicRate);
+  AudioVoice(BaseAudioVoiceEngine& root, const AudioSampleInfo& sample);
 
 public:
   static AudioVoice*& _getHeadPtr(BaseAudioVoiceEngine* head);
@@ -70,8 +112,16 @@ public:
   ~AudioVoice() override;
   void resetSampleRate(double sampleRate) override;
   void setPitchRatio(double ratio, bool slew) override;
+  void setFilter(AudioFilterType type, double cutoff, double q, bool slew) override;
   void start() override;
   void stop() override;
+  bool isRunning() const override { return m_running; }
+  void startAt(uint64_t frame) override;
+  void stopAt(uint64_t frame) override;
+  void setPitchRatioAt(uint64_t frame, double ratio, bool slew) override;
+  void setMonoChannelLevelsAt(uint64_t frame, IAudioSubmix* submix, const float coefs[8], bool slew) override;
+  void setStereoChannelLevelsAt(uint64_t frame, IAudioSubmix* submix, const float coefs[8][2], bool slew) override;
+  void clearScheduledEvents() override { m_events.clear(); }
   double getSampleRateIn() const { return m_sampleRateIn; }
   double getSampleRateOut() const { return m_sampleRateOut; }
 };
@@ -89,6 +139,19 @@ inline size_t AudioVoice::pumpAndMix<float>(size_t frames) {
   return pumpAndMixFlt(frames);
 }
 
+template <>
+inline void AudioVoice::mixFiltered<int16_t>(size_t slot, size_t frames) {
+  mixFiltered16(slot, frames);
+}
+template <>
+inline void AudioVoice::mixFiltered<int32_t>(size_t slot, size_t frames) {
+  mixFiltered32(slot, frames);
+}
+template <>
+inline void AudioVoice::mixFiltered<float>(size_t slot, size_t frames) {
+  mixFilteredFlt(slot, frames);
+}
+
 class AudioVoiceMono : public AudioVoice {
   std::unordered_map<IAudioSubmix*, AudioMatrixMono> m_sendMatrices;
   bool m_silentOut = false;
@@ -104,8 +167,18 @@ class AudioVoiceMono : public AudioVoice {
   size_t pumpAndMix32(size_t frames) override { return _pumpAndMix<int32_t>(frames); }
   size_t pumpAndMixFlt(size_t frames) override { return _pumpAndMix<float>(frames); }
 
+  template <typename T>
+  void _mix(size_t frames, double dt);
+  template <typename T>
+  void _mixFiltered(size_t slot, size_t frames);
+  void mixFiltered16(size_t slot, size_t frames) override { _mixFiltered<int16_t>(slot, frames); }
+  void mixFiltered32(size_t slot, size_t frames) override { _mixFiltered<int32_t>(slot, frames); }
+  void mixFilteredFlt(size_t slot, size_t frames) override { _mixFiltered<float>(slot, frames); }
+
 public:
-  AudioVoiceMono(BaseAudioVoiceEngine& root, IAudioVoiceCallback* cb, double sampleRate, bool dynamicRate);
+  AudioVoiceMono(BaseAudioVoiceEngine& root, IAudioVoiceCallback* cb, double sampleRate, bool dynamicRate,
+                 AudioResamplerQuality quality);
+  AudioVoiceMono(BaseAudioVoiceEngine& root, const AudioSampleInfo& sample);
   void resetChannelLevels() override;
   void setMonoChannelLevels(IAudioSubmix* submix, const float coefs[8], bool slew) override;
   void setStereoChannelLevels(IAudioSubmix* submix, const float coefs[8][2], bool slew) override;
@@ -126,8 +199,18 @@ class AudioVoiceStereo : public AudioVoice {
   size_t pumpAndMix32(size_t frames) override { return _pumpAndMix<int32_t>(frames); }
   size_t pumpAndMixFlt(size_t frames) override { return _pumpAndMix<float>(frames); }
 
+  template <typename T>
+  void _mix(size_t frames, double dt);
+  template <typename T>
+  void _mixFiltered(size_t slot, size_t frames);
+  void mixFiltered16(size_t slot, size_t frames) override { _mixFiltered<int16_t>(slot, frames); }
+  void mixFiltered32(size_t slot, size_t frames) override { _mixFiltered<int32_t>(slot, frames); }
+  void mixFilteredFlt(size_t slot, size_t frames) override { _mixFiltered<float>(slot, frames); }
+
 public:
-  AudioVoiceStereo(BaseAudioVoiceEngine& root, IAudioVoiceCallback* cb, double sampleRate, bool dynamicRate);
+  AudioVoiceStereo(BaseAudioVoiceEngine& root, IAudioVoiceCallback* cb, double sampleRate, bool dynamicRate,
+                   AudioResamplerQuality quality);
+  AudioVoiceStereo(BaseAudioVoiceEngine& root, const AudioSampleInfo& sample);
   void resetChannelLevels() override;
   void setMonoChannelLevels(IAudioSubmix* submix, const float coefs[8], bool slew) override;
   void setStereoChannelLevels(IAudioSubmix* submix, const float coefs[8][2], bool slew) override;
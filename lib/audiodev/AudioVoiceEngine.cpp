@@ -1,8 +1,12 @@
 #include "lib/audiodev/AudioVoiceEngine.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 
+#undef min
+#undef max
+
 namespace boo {
 
 BaseAudioVoiceEngine::~BaseAudioVoiceEngine() {
@@ -30,19 +34,28 @@ void BaseAudioVoiceEngine::_pumpAndMixVoices(size_t frames, T* dataOut) {
     m_submixesDirty = false;
   }
 
+  m_midiScheduler.beginBlock(m_mixPosition, m_mixInfo.m_sampleRate);
+
   size_t remFrames = frames;
+  size_t intervalRemFrames = 0;
   while (remFrames) {
-    size_t thisFrames;
-    if (remFrames < m_5msFrames) {
-      thisFrames = remFrames;
-      if (m_engineCallback)
-        m_engineCallback->on5MsInterval(*this, thisFrames / double(m_5msFrames) * 5.0 / 1000.0);
-    } else {
-      thisFrames = m_5msFrames;
-      if (m_engineCallback)
-        m_engineCallback->on5MsInterval(*this, 5.0 / 1000.0);
+    if (!intervalRemFrames) {
+      if (remFrames < m_5msFrames) {
+        intervalRemFrames = remFrames;
+        if (m_engineCallback)
+          m_engineCallback->on5MsInterval(*this, intervalRemFrames / double(m_5msFrames) * 5.0 / 1000.0);
+      } else {
+        intervalRemFrames = m_5msFrames;
+        if (m_engineCallback)
+          m_engineCallback->on5MsInterval(*this, 5.0 / 1000.0);
+      }
     }
 
+    /* Interval is split into sub-blocks at MIDI and voice event timestamps;
+     * MIDI goes first so its handlers may start voices on this very frame */
+    const size_t thisFrames = _applyVoiceEvents(m_midiScheduler.deliver(m_mixPosition, intervalRemFrames));
+    intervalRemFrames -= thisFrames;
+
     if (m_ltRtProcessing)
       std::fill(_getLtRtIn<T>().begin(), _getLtRtIn<T>().end(), 0.f);
 
@@ -54,10 +67,18 @@ void BaseAudioVoiceEngine::_pumpAndMixVoices(size_t frames, T* dataOut) {
         if (vox.m_running)
           vox.pumpAndMix<T>(thisFrames);
 
+    if (m_filterBank.slotCount()) {
+      m_filterBank.process();
+      for (size_t i = 0; i < m_filterBank.slotCount(); ++i)
+        m_filterBank.voice(i).mixFiltered<T>(i, thisFrames);
+      m_filterBank.clear();
+    }
+
     for (auto it = m_linearizedSubmixes.rbegin(); it != m_linearizedSubmixes.rend(); ++it)
       (*it)->_pumpAndMix<T>(thisFrames);
 
     remFrames -= thisFrames;
+    m_mixPosition += thisFrames;
     if (!dataOut)
       continue;
 
@@ -81,7 +102,22 @@ template void BaseAudioVoiceEngine::_pumpAndMixVoices<int16_t>(size_t frames, in
 template void BaseAudioVoiceEngine::_pumpAndMixVoices<int32_t>(size_t frames, int32_t* dataOut);
 template void BaseAudioVoiceEngine::_pumpAndMixVoices<float>(size_t frames, float* dataOut);
 
+size_t BaseAudioVoiceEngine::_applyVoiceEvents(size_t frames) {
+  if (!m_voiceHead)
+    return frames;
+  for (AudioVoice& vox : *m_voiceHead) {
+    if (vox.m_events.empty())
+      continue;
+    vox._applyEvents(m_mixPosition);
+    if (!vox.m_events.empty())
+      frames = size_t(std::min(uint64_t(frames), vox.m_events.front().m_frame - m_mixPosition));
+  }
+  return frames;
+}
+
 void BaseAudioVoiceEngine::_resetSampleRate() {
+  m_sampleCache.clear();
+  m_midiScheduler.resetClock();
   if (m_voiceHead)
     for (boo::AudioVoice& vox : *m_voiceHead)
       vox._resetSampleRate(vox.m_sampleRateIn);
@@ -91,13 +127,81 @@ void BaseAudioVoiceEngine::_resetSampleRate() {
 }
 
 ObjToken<IAudioVoice> BaseAudioVoiceEngine::allocateNewMonoVoice(double sampleRate, IAudioVoiceCallback* cb,
-                                                                 bool dynamicPitch) {
-  return {new AudioVoiceMono(*this, cb, sampleRate, dynamicPitch)};
+                                                                 bool dynamicPitch, AudioResamplerQuality quality) {
+  return {new AudioVoiceMono(*this, cb, sampleRate, dynamicPitch, quality)};
 }
 
 ObjToken<IAudioVoice> BaseAudioVoiceEngine::allocateNewStereoVoice(double sampleRate, IAudioVoiceCallback* cb,
-                                                                   bool dynamicPitch) {
-  return {new AudioVoiceStereo(*this, cb, sampleRate, dynamicPitch)};
+                                                                   bool dynamicPitch, AudioResamplerQuality quality) {
+  return {new AudioVoiceStereo(*this, cb, sampleRate, dynamicPitch, quality)};
+}
+
+ObjToken<IAudioVoice> BaseAudioVoiceEngine::_allocateSampleVoice(const AudioSampleInfo& info) {
+  if (!info.m_frames)
+    return {};
+  if (info.m_channels == 1)
+    return {new AudioVoiceMono(*this, info)};
+  if (info.m_channels == 2)
+    return {new AudioVoiceStereo(*this, info)};
+  return {};
+}
+
+ObjToken<IAudioVoice> BaseAudioVoiceEngine::allocateSampleVoice(const int16_t* pcm, size_t frames, unsigned channels,
+                                                                double sampleRate, size_t loopStart, size_t loopEnd,
+                                                                bool cacheResampled) {
+  if (!pcm)
+    return {};
+  AudioSampleInfo info;
+  info.m_pcm = pcm;
+  info.m_frames = frames;
+  info.m_channels = channels;
+  info.m_sampleRate = sampleRate;
+  info.m_loopStart = loopStart;
+  info.m_loopEnd = loopEnd;
+  if (cacheResampled && frames && sampleRate != m_mixInfo.m_sampleRate) {
+    AudioSampleInfo cached = m_sampleCache.lookup(info, m_mixInfo.m_sampleRate);
+    if (cached.m_pcm)
+      return _allocateSampleVoice(cached);
+  }
+  return _allocateSampleVoice(info);
+}
+
+void BaseAudioVoiceEngine::setSampleCacheBudget(size_t bytes) { m_sampleCache.setBudget(bytes); }
+
+ObjToken<IAudioVoice> BaseAudioVoiceEngine::allocateIMASampleVoice(const uint8_t* data, size_t blockAlign,
+                                                                   size_t frames, unsigned channels, double sampleRate,
+                                                                   size_t loopStart, size_t loopEnd) {
+  if (!data || blockAlign <= 4 * channels)
+    return {};
+  AudioSampleInfo info;
+  info.m_format = AudioSampleFormat::IMAADPCM;
+  info.m_adpcm = data;
+  info.m_blockBytes = blockAlign;
+  info.m_frames = frames;
+  info.m_channels = channels;
+  info.m_sampleRate = sampleRate;
+  info.m_loopStart = loopStart;
+  info.m_loopEnd = loopEnd;
+  return _allocateSampleVoice(info);
+}
+
+ObjToken<IAudioVoice> BaseAudioVoiceEngine::allocateDSPSampleVoice(const uint8_t* data, size_t channelStride,
+                                                                   const int16_t* coefs, size_t frames,
+                                                                   unsigned channels, double sampleRate,
+                                                                   size_t loopStart, size_t loopEnd) {
+  if (!data || !coefs)
+    return {};
+  AudioSampleInfo info;
+  info.m_format = AudioSampleFormat::DSPADPCM;
+  info.m_adpcm = data;
+  info.m_blockBytes = channelStride;
+  info.m_dspCoefs = coefs;
+  info.m_frames = frames;
+  info.m_channels = channels;
+  info.m_sampleRate = sampleRate;
+  info.m_loopStart = loopStart;
+  info.m_loopEnd = loopEnd;
+  return _allocateSampleVoice(info);
 }
 
 ObjToken<IAudioSubmix> BaseAudioVoiceEngine::allocateNewSubmix(bool mainOut, IAudioSubmixCallback* cb, int busId) {
@@ -106,6 +210,12 @@ ObjToken<IAudioSubmix> BaseAudioVoiceEngine::allocateNewSubmix(bool mainOut, IAu
 
 void BaseAudioVoiceEngine::setCallbackInterface(IAudioVoiceEngineCallback* cb) { m_engineCallback = cb; }
 
+void BaseAudioVoiceEngine::setMIDIScheduleReader(IMIDIReader* reader, double latency) {
+  m_midiScheduler.setReader(reader, latency);
+}
+
+ReceiveFunctor BaseAudioVoiceEngine::newMIDIScheduleReceiver() { return m_midiScheduler.newReceiver(); }
+
 void BaseAudioVoiceEngine::setVolume(float vol) { m_totalVol = vol; }
 
 bool BaseAudioVoiceEngine::enableLtRt(bool enable) {
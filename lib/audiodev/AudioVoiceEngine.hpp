@@ -9,10 +9,13 @@
 
 #include "boo/BooObject.hpp"
 #include "boo/audiodev/IAudioVoiceEngine.hpp"
+#include "lib/audiodev/AudioFilterBank.hpp"
+#include "lib/audiodev/AudioSampleCache.hpp"
 #include "lib/audiodev/AudioSubmix.hpp"
 #include "lib/audiodev/AudioVoice.hpp"
 #include "lib/audiodev/Common.hpp"
 #include "lib/audiodev/LtRtProcessing.hpp"
+#include "lib/audiodev/MIDIScheduler.hpp"
 
 namespace boo {
 
@@ -29,6 +32,7 @@ protected:
   AudioVoice* m_voiceHead = nullptr;
   AudioSubmix* m_submixHead = nullptr;
   size_t m_5msFrames = 0;
+  uint64_t m_mixPosition = 0;
   IAudioVoiceEngineCallback* m_engineCallback = nullptr;
 
   /* Shared scratch buffers for accumulating audio data for resampling */
@@ -52,6 +56,20 @@ protected:
   template <typename T>
   std::vector<T>& _getLtRtIn();
 
+  /* Voices with an active built-in filter, processed together each 5ms interval */
+  AudioFilterBank m_filterBank;
+
+  /* Static samples pre-resampled to the device rate */
+  AudioSampleCache m_sampleCache;
+
+  /* Matrices used by voices without a per-submix send; held per-engine since mixing
+   * advances their slew state and engines may be pumped from independent threads */
+  AudioMatrixMono m_defaultMonoMtx;
+  AudioMatrixStereo m_defaultStereoMtx;
+
+  /* Incoming MIDI queued for delivery at its frame */
+  MIDIScheduler m_midiScheduler;
+
   std::unique_ptr<AudioSubmix> m_mainSubmix;
   std::list<AudioSubmix*> m_linearizedSubmixes;
   bool m_submixesDirty = true;
@@ -59,21 +77,43 @@ protected:
   template <typename T>
   void _pumpAndMixVoices(size_t frames, T* dataOut);
 
+  /* Apply voice events due at m_mixPosition; returns frames until the next one (at most `frames`) */
+  size_t _applyVoiceEvents(size_t frames);
+
   void _resetSampleRate();
 
+  ObjToken<IAudioVoice> _allocateSampleVoice(const AudioSampleInfo& info);
+
 public:
   BaseAudioVoiceEngine() : m_mainSubmix(std::make_unique<AudioSubmix>(*this, nullptr, -1, false)) {}
   ~BaseAudioVoiceEngine() override;
-  ObjToken<IAudioVoice> allocateNewMonoVoice(double sampleRate, IAudioVoiceCallback* cb,
-                                             bool dynamicPitch = false) override;
+  ObjToken<IAudioVoice> allocateNewMonoVoice(double sampleRate, IAudioVoiceCallback* cb, bool dynamicPitch = false,
+                                             AudioResamplerQuality quality = AudioResamplerQuality::High) override;
 
-  ObjToken<IAudioVoice> allocateNewStereoVoice(double sampleRate, IAudioVoiceCallback* cb,
-                                               bool dynamicPitch = false) override;
+  ObjToken<IAudioVoice> allocateNewStereoVoice(double sampleRate, IAudioVoiceCallback* cb, bool dynamicPitch = false,
+                                               AudioResamplerQuality quality = AudioResamplerQuality::High) override;
+
+  ObjToken<IAudioVoice> allocateSampleVoice(const int16_t* pcm, size_t frames, unsigned channels, double sampleRate,
+                                            size_t loopStart = 0, size_t loopEnd = 0,
+                                            bool cacheResampled = false) override;
+
+  ObjToken<IAudioVoice> allocateIMASampleVoice(const uint8_t* data, size_t blockAlign, size_t frames,
+                                               unsigned channels, double sampleRate, size_t loopStart = 0,
+                                               size_t loopEnd = 0) override;
+
+  ObjToken<IAudioVoice> allocateDSPSampleVoice(const uint8_t* data, size_t channelStride, const int16_t* coefs,
+                                               size_t frames, unsigned channels, double sampleRate,
+                                               size_t loopStart = 0, size_t loopEnd = 0) override;
+
+  void setSampleCacheBudget(size_t bytes) override;
 
   ObjToken<IAudioSubmix> allocateNewSubmix(bool mainOut, IAudioSubmixCallback* cb, int busId) override;
 
   void setCallbackInterface(IAudioVoiceEngineCallback* cb) override;
 
+  void setMIDIScheduleReader(IMIDIReader* reader, double latency = 0.01) override;
+  ReceiveFunctor newMIDIScheduleReceiver() override;
+
   void setVolume(float vol) override;
   bool enableLtRt(bool enable) override;
   const AudioVoiceEngineMixInfo& mixInfo() const;
@@ -81,6 +121,7 @@ public:
   AudioChannelSet getAvailableSet() override { return clientMixInfo().m_channels; }
   void pumpAndMixVoices() override {}
   size_t get5MsFrames() const override { return m_5msFrames; }
+  uint64_t getMixPosition() const override { return m_mixPosition; }
 };
 
 template <>
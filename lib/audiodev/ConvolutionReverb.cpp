@@ -0,0 +1,446 @@
+#include "boo/audiodev/ConvolutionReverb.hpp"
+#include "boo/audiodev/IAudioVoice.hpp"
+#include "lib/audiodev/AudioFFT.h"
+#include "lib/audiodev/AudioMatrix.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <logvisor/logvisor.hpp>
+#include <soxr.h>
+
+#undef min
+#undef max
+
+namespace boo {
+static logvisor::Module Log("boo::ConvolutionReverb");
+
+namespace {
+struct alignas(16) FloatQuad {
+  float f[4];
+};
+
+/* pffft requires 16-byte aligned buffers */
+class AlignedBuffer {
+  std::vector<FloatQuad> m_quads;
+
+public:
+  void resize(size_t count) { m_quads.assign((count + 3) / 4, FloatQuad{}); }
+  float* data() { return reinterpret_cast<float*>(m_quads.data()); }
+  const float* data() const { return reinterpret_cast<const float*>(m_quads.data()); }
+};
+
+template <typename T>
+T StoreConvolved(float v);
+template <>
+int16_t StoreConvolved<int16_t>(float v) {
+  return Clamp16(v);
+}
+template <>
+int32_t StoreConvolved<int32_t>(float v) {
+  return Clamp32(v);
+}
+template <>
+float StoreConvolved<float>(float v) {
+  return v;
+}
+} // Anonymous namespace
+
+struct ConvolutionReverb::Impl {
+  struct Channel {
+    AlignedBuffer m_input;  /* Previous block | current block */
+    AlignedBuffer m_fdl;    /* Frequency-domain delay line; ring of input spectra */
+    AlignedBuffer m_accum;
+    AlignedBuffer m_tail;   /* Partitions 1..P-1 for the coming block, written by worker */
+    AlignedBuffer m_output; /* [B, 2B) holds the block currently being played out */
+  };
+
+  /* Everything the mixing thread needs for one impulse response at one rate and channel count.
+   * Built on the loader thread and swapped in whole, so mixing never waits on a rebuild */
+  struct Kernel {
+    double m_rate;
+    unsigned m_irChannels;
+    size_t m_partitions;
+    std::vector<AlignedBuffer> m_irSpectra; /* Per IR channel: m_partitions spectra of m_fftSize */
+    std::vector<Channel> m_channels;
+  };
+
+  size_t m_blockFrames;
+  size_t m_fftSize;
+  float m_scale;
+  void* m_fft;
+  bool m_tailThread;
+  std::atomic<float> m_dry = 0.f;
+  std::atomic<float> m_wet = 1.f;
+  std::atomic_bool m_ready = false;
+
+  /* Loader state. The mixing thread only ever try_locks m_lock */
+  std::mutex m_lock;
+  std::condition_variable m_loaderCv;
+  std::shared_ptr<const std::vector<float>> m_irSource;
+  size_t m_irFrames = 0;
+  unsigned m_irChannels = 0;
+  double m_irRate = 0.0;
+  uint64_t m_irSerial = 0;
+  double m_buildRate = 0.0;
+  unsigned m_buildChannels = 0;
+  bool m_buildRequested = false;
+  bool m_loaderRunning = true;
+  std::unique_ptr<Kernel> m_pending; /* Newest build, waiting for the mixing thread */
+  std::unique_ptr<Kernel> m_retired; /* Replaced kernel, freed by the loader */
+  std::atomic_bool m_pendingReady = false;
+  std::thread m_loader;
+
+  /* Mixing thread */
+  std::unique_ptr<Kernel> m_kernel;
+  double m_requestedRate = 0.0;
+  unsigned m_requestedChannels = 0;
+  size_t m_fdlPos = 0;
+  size_t m_fill = 0;
+  AlignedBuffer m_work;
+
+  /* Tail worker */
+  std::thread m_worker;
+  std::mutex m_workLock;
+  std::condition_variable m_workCv;
+  bool m_workPending = false;
+  bool m_workerRunning = true;
+
+  Impl(size_t partitionFrames, bool tailThread) : m_tailThread(tailThread) {
+    m_blockFrames = 32;
+    while (m_blockFrames < partitionFrames)
+      m_blockFrames *= 2;
+    m_fftSize = m_blockFrames * 2;
+    m_scale = 1.f / float(m_fftSize);
+    m_fft = boo_fft_new_setup(int(m_fftSize));
+    m_work.resize(m_fftSize);
+    m_loader = std::thread(&Impl::_loaderProc, this);
+    if (m_tailThread)
+      m_worker = std::thread(&Impl::_workerProc, this);
+  }
+
+  ~Impl() {
+    if (m_worker.joinable()) {
+      {
+        std::unique_lock wl(m_workLock);
+        m_workerRunning = false;
+      }
+      m_workCv.notify_all();
+      m_worker.join();
+    }
+    {
+      std::unique_lock lk(m_lock);
+      m_loaderRunning = false;
+    }
+    m_loaderCv.notify_all();
+    m_loader.join();
+    boo_fft_destroy_setup(m_fft);
+  }
+
+  void _accumulate(const Channel& ch, const float* ir, size_t firstPart, size_t endPart, size_t newestSlot,
+                   float* acc) const {
+    const size_t n = m_fftSize;
+    const size_t partitions = m_kernel->m_partitions;
+    for (size_t p = firstPart; p < endPart; ++p) {
+      const size_t slot = (newestSlot + partitions - p) % partitions;
+      boo_fft_zconvolve_accumulate(m_fft, ch.m_fdl.data() + slot * n, ir + p * n, acc, m_scale);
+    }
+  }
+
+  void _workerProc() {
+    logvisor::RegisterThreadName("Boo Convolution Tail");
+    std::unique_lock wl(m_workLock);
+    for (;;) {
+      m_workCv.wait(wl, [this]() { return m_workPending || !m_workerRunning; });
+      if (!m_workerRunning)
+        return;
+      wl.unlock();
+
+      Kernel& k = *m_kernel;
+      const size_t next = (m_fdlPos + 1) % k.m_partitions;
+      for (size_t c = 0; c < k.m_channels.size(); ++c) {
+        Channel& ch = k.m_channels[c];
+        float* tail = ch.m_tail.data();
+        std::fill(tail, tail + m_fftSize, 0.f);
+        _accumulate(ch, k.m_irSpectra[c % k.m_irChannels].data(), 1, k.m_partitions, next, tail);
+      }
+
+      wl.lock();
+      m_workPending = false;
+      m_workCv.notify_all();
+    }
+  }
+
+  void _waitWorker() {
+    if (!m_tailThread)
+      return;
+    std::unique_lock wl(m_workLock);
+    m_workCv.wait(wl, [this]() { return !m_workPending; });
+  }
+
+  void _kickWorker() {
+    {
+      std::unique_lock wl(m_workLock);
+      m_workPending = true;
+    }
+    m_workCv.notify_all();
+  }
+
+  std::unique_ptr<Kernel> _build(const std::vector<float>& source, size_t irFrames, unsigned irChannels, double irRate,
+                                 double rate, unsigned channels) const {
+    const float* ir = source.data();
+    std::vector<float> resampled;
+    if (rate > 0.0 && irRate > 0.0 && rate != irRate) {
+      resampled.resize((size_t(double(irFrames) * rate / irRate) + 1) * irChannels);
+      soxr_io_spec_t ioSpec = soxr_io_spec(SOXR_FLOAT32_I, SOXR_FLOAT32_I);
+      soxr_quality_spec_t qSpec = soxr_quality_spec(SOXR_20_BITQ, 0);
+      const size_t inFrames = irFrames;
+      soxr_error_t err = soxr_oneshot(irRate, rate, irChannels, source.data(), inFrames, nullptr, resampled.data(),
+                                      resampled.size() / irChannels, &irFrames, &ioSpec, &qSpec, nullptr);
+      if (err) {
+        Log.report(logvisor::Error, FMT_STRING("unable to resample impulse response: {}"), soxr_strerror(err));
+        return {};
+      }
+      ir = resampled.data();
+    }
+
+    const size_t b = m_blockFrames;
+    const size_t n = m_fftSize;
+    auto kernel = std::make_unique<Kernel>();
+    kernel->m_rate = rate;
+    kernel->m_irChannels = irChannels;
+    kernel->m_partitions = std::max(size_t(1), (irFrames + b - 1) / b);
+    kernel->m_irSpectra.resize(irChannels);
+
+    AlignedBuffer time;
+    time.resize(n);
+    AlignedBuffer work;
+    work.resize(n);
+    for (unsigned c = 0; c < irChannels; ++c) {
+      AlignedBuffer& spectra = kernel->m_irSpectra[c];
+      spectra.resize(kernel->m_partitions * n);
+      for (size_t p = 0; p < kernel->m_partitions; ++p) {
+        std::fill(time.data(), time.data() + n, 0.f);
+        const size_t count = std::min(b, irFrames - std::min(irFrames, p * b));
+        for (size_t i = 0; i < count; ++i)
+          time.data()[i] = ir[(p * b + i) * irChannels + c];
+        boo_fft_forward(m_fft, time.data(), spectra.data() + p * n, work.data());
+      }
+    }
+
+    kernel->m_channels.resize(channels);
+    for (Channel& ch : kernel->m_channels) {
+      ch.m_input.resize(n);
+      ch.m_fdl.resize(kernel->m_partitions * n);
+      ch.m_accum.resize(n);
+      ch.m_tail.resize(n);
+      ch.m_output.resize(n);
+    }
+    return kernel;
+  }
+
+  void _loaderProc() {
+    logvisor::RegisterThreadName("Boo Convolution Loader");
+    std::unique_lock lk(m_lock);
+    for (;;) {
+      m_loaderCv.wait(lk, [this]() { return m_buildRequested || m_retired || !m_loaderRunning; });
+      if (!m_loaderRunning)
+        return;
+
+      /* Nothing is built until the mixing thread has reported its format */
+      std::unique_ptr<Kernel> garbage = std::move(m_retired);
+      if (!m_buildRequested || !m_irSource || !m_buildChannels) {
+        m_buildRequested = false;
+        lk.unlock();
+        garbage.reset();
+        lk.lock();
+        continue;
+      }
+
+      m_buildRequested = false;
+      const auto source = m_irSource;
+      const size_t irFrames = m_irFrames;
+      const unsigned irChannels = m_irChannels;
+      const double irRate = m_irRate;
+      const uint64_t serial = m_irSerial;
+      const double rate = m_buildRate;
+      const unsigned channels = m_buildChannels;
+      lk.unlock();
+      garbage.reset();
+      std::unique_ptr<Kernel> kernel = _build(*source, irFrames, irChannels, irRate, rate, channels);
+      lk.lock();
+
+      /* Publish unless the IR or the mixing thread's format changed meanwhile (which requested another build) */
+      if (kernel && serial == m_irSerial && rate == m_buildRate && channels == m_buildChannels) {
+        std::swap(m_pending, kernel);
+        m_pendingReady = true;
+      }
+      lk.unlock();
+      kernel.reset();
+      lk.lock();
+    }
+  }
+
+  /* Mixing thread: ask for a kernel matching the submix and take a finished one, without blocking */
+  void _sync(double sampleRate, unsigned chans) {
+    std::unique_lock lk(m_lock, std::try_to_lock);
+    if (!lk)
+      return;
+
+    m_requestedRate = sampleRate;
+    m_requestedChannels = chans;
+    if (m_buildRate != sampleRate || m_buildChannels != chans) {
+      m_buildRate = sampleRate;
+      m_buildChannels = chans;
+      m_buildRequested = true;
+    }
+
+    /* A build for another format stays pending until the loader replaces it */
+    if (m_pending && !m_retired && m_pending->m_rate == sampleRate && m_pending->m_channels.size() == chans) {
+      _waitWorker();
+      m_retired = std::move(m_kernel);
+      m_kernel = std::move(m_pending);
+      m_pendingReady = false;
+      m_fdlPos = 0;
+      m_fill = 0;
+    }
+
+    if (m_buildRequested || m_retired)
+      m_loaderCv.notify_one();
+  }
+
+  void _processBlock() {
+    Kernel& k = *m_kernel;
+    const size_t b = m_blockFrames;
+    const size_t n = m_fftSize;
+    _waitWorker();
+
+    m_fdlPos = (m_fdlPos + 1) % k.m_partitions;
+    for (size_t c = 0; c < k.m_channels.size(); ++c) {
+      Channel& ch = k.m_channels[c];
+      float* acc = ch.m_accum.data();
+      boo_fft_forward(m_fft, ch.m_input.data(), ch.m_fdl.data() + m_fdlPos * n, m_work.data());
+      std::memmove(ch.m_input.data(), ch.m_input.data() + b, b * sizeof(float));
+
+      size_t headEnd = k.m_partitions;
+      if (m_tailThread) {
+        std::copy(ch.m_tail.data(), ch.m_tail.data() + n, acc);
+        headEnd = 1;
+      } else {
+        std::fill(acc, acc + n, 0.f);
+      }
+      _accumulate(ch, k.m_irSpectra[c % k.m_irChannels].data(), 0, headEnd, m_fdlPos, acc);
+      boo_fft_backward(m_fft, acc, ch.m_output.data(), m_work.data());
+    }
+
+    if (m_tailThread && k.m_partitions > 1)
+      _kickWorker();
+  }
+
+  template <typename T>
+  void apply(T* audio, size_t frames, const ChannelMap& chanMap, double sampleRate) {
+    const unsigned chans = chanMap.m_channelCount;
+    if (m_pendingReady || sampleRate != m_requestedRate || chans != m_requestedChannels)
+      _sync(sampleRate, chans);
+
+    /* Until a kernel for this channel count arrives the submix passes through dry.
+     * After a rate change the previous kernel keeps playing until its replacement is built */
+    if (!m_kernel || m_kernel->m_channels.size() != chans)
+      return;
+
+    const float dry = m_dry;
+    const float wet = m_wet;
+    const size_t b = m_blockFrames;
+    size_t done = 0;
+    while (done < frames) {
+      const size_t count = std::min(frames - done, b - m_fill);
+      for (unsigned c = 0; c < chans; ++c) {
+        Channel& ch = m_kernel->m_channels[c];
+        float* in = ch.m_input.data() + b + m_fill;
+        const float* out = ch.m_output.data() + b + m_fill;
+        T* s = audio + done * chans + c;
+        for (size_t i = 0; i < count; ++i, s += chans) {
+          const float x = float(*s);
+          in[i] = x;
+          *s = StoreConvolved<T>(x * dry + out[i] * wet);
+        }
+      }
+      m_fill += count;
+      done += count;
+      if (m_fill == b) {
+        _processBlock();
+        m_fill = 0;
+      }
+    }
+  }
+};
+
+ConvolutionReverb::ConvolutionReverb(size_t partitionFrames, bool tailThread)
+: m_impl(std::make_unique<Impl>(partitionFrames, tailThread)) {}
+
+ConvolutionReverb::~ConvolutionReverb() = default;
+
+void ConvolutionReverb::loadImpulse(const float* ir, size_t frames, unsigned channels, double sampleRate) {
+  /* The loader divides by channels and resamples by sampleRate; keep the current impulse instead */
+  if (!ir || !frames || !channels || !(sampleRate > 0.0)) {
+    Log.report(logvisor::Error, FMT_STRING("ignoring empty impulse response ({} frames, {} channels, {} Hz)"), frames,
+               channels, sampleRate);
+    return;
+  }
+  auto source = std::make_shared<const std::vector<float>>(ir, ir + frames * channels);
+  Impl& impl = *m_impl;
+  {
+    std::unique_lock lk(impl.m_lock);
+    impl.m_irSource = std::move(source);
+    impl.m_irFrames = frames;
+    impl.m_irChannels = channels;
+    impl.m_irRate = sampleRate;
+    ++impl.m_irSerial;
+    impl.m_buildRequested = true;
+  }
+  impl.m_loaderCv.notify_one();
+  impl.m_ready = true;
+}
+
+void ConvolutionReverb::loadImpulse(const int16_t* ir, size_t frames, unsigned channels, double sampleRate) {
+  if (!ir) {
+    loadImpulse(static_cast<const float*>(nullptr), frames, channels, sampleRate);
+    return;
+  }
+  std::vector<float> converted(frames * channels);
+  for (size_t i = 0; i < converted.size(); ++i)
+    converted[i] = ir[i] / 32768.f;
+  loadImpulse(converted.data(), frames, channels, sampleRate);
+}
+
+void ConvolutionReverb::setMix(float dry, float wet) {
+  m_impl->m_dry = dry;
+  m_impl->m_wet = wet;
+}
+
+bool ConvolutionReverb::canApplyEffect() const { return m_impl->m_ready; }
+
+void ConvolutionReverb::applyEffect(int16_t* audio, size_t frameCount, const ChannelMap& chanMap,
+                                    double sampleRate) const {
+  m_impl->apply(audio, frameCount, chanMap, sampleRate);
+}
+
+void ConvolutionReverb::applyEffect(int32_t* audio, size_t frameCount, const ChannelMap& chanMap,
+                                    double sampleRate) const {
+  m_impl->apply(audio, frameCount, chanMap, sampleRate);
+}
+
+void ConvolutionReverb::applyEffect(float* audio, size_t frameCount, const ChannelMap& chanMap,
+                                    double sampleRate) const {
+  m_impl->apply(audio, frameCount, chanMap, sampleRate);
+}
+
+/* applyEffect sees the new rate and requests a rebuild itself */
+void ConvolutionReverb::resetOutputSampleRate(double sampleRate) {}
+
+} // namespace boo
@@ -1,8 +1,16 @@
 #pragma once
 
-#include <csignal>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <mutex>
 #include <thread>
 #include <unordered_map>
+#include <vector>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
 
 #include "lib/audiodev/AudioVoiceEngine.hpp"
 
@@ -14,6 +22,181 @@ extern logvisor::Module ALSALog;
 
 static inline double TimespecToDouble(struct timespec& ts) { return ts.tv_sec + ts.tv_nsec / 1.0e9; }
 
+/** One thread servicing every open rawmidi input through epoll.
+ *  Packets are timestamped with CLOCK_MONOTONIC on wakeup. Ports register on construction and
+ *  unregister before closing their handle; once remove() returns the thread no longer touches
+ *  the port. The thread starts with the first port and is woken and joined once the last one closes.
+ *  Each thread owns its epoll instance, so a thread still winding down never services newer ports */
+class LinuxMidiReactor {
+  struct Port {
+    snd_rawmidi_t* m_midi;
+    IMIDIReceiver* m_receiver;
+    std::vector<pollfd> m_pfds;
+  };
+
+  std::recursive_mutex m_lock;
+  std::unordered_map<uint64_t, Port> m_ports;
+  uint64_t m_nextId = 1; /* 0 tags the wakeup eventfd */
+  std::thread m_thread;
+  int m_epoll = -1;
+  int m_wakeFd = -1;
+
+  void _unwatch(Port& port) {
+    for (const pollfd& pfd : port.m_pfds)
+      epoll_ctl(m_epoll, EPOLL_CTL_DEL, pfd.fd, nullptr);
+    port.m_pfds.clear();
+  }
+
+  void _service(uint64_t id, uint8_t* buf, size_t bufLen, double time) {
+    auto search = m_ports.find(id);
+    if (search == m_ports.end() || search->second.m_pfds.empty())
+      return;
+    Port& port = search->second;
+
+    unsigned short revents = 0;
+    poll(port.m_pfds.data(), port.m_pfds.size(), 0);
+    snd_rawmidi_poll_descriptors_revents(port.m_midi, port.m_pfds.data(), port.m_pfds.size(), &revents);
+    if (revents & (POLLERR | POLLHUP)) {
+      ALSALog.report(logvisor::Error, FMT_STRING("MIDI connection lost"));
+      _unwatch(port);
+      return;
+    }
+    if (!(revents & POLLIN))
+      return;
+
+    /* Receivers may close ports (including this one) from their callback */
+    snd_rawmidi_t* midi = port.m_midi;
+    IMIDIReceiver* receiver = port.m_receiver;
+    while (true) {
+      ssize_t rdBytes = snd_rawmidi_read(midi, buf, bufLen);
+      if (rdBytes <= 0) {
+        if (rdBytes < 0 && rdBytes != -EAGAIN && rdBytes != -EINTR) {
+          ALSALog.report(logvisor::Error, FMT_STRING("MIDI connection lost"));
+          if ((search = m_ports.find(id)) != m_ports.end())
+            _unwatch(search->second);
+        }
+        return;
+      }
+      receiver->_receive(buf, size_t(rdBytes), time);
+      if (!m_ports.count(id))
+        return;
+    }
+  }
+
+  void _run(int epoll, int wakeFd) {
+    logvisor::RegisterThreadName("Boo MIDI");
+    uint8_t buf[512];
+    epoll_event events[16];
+    while (true) {
+      int count = epoll_wait(epoll, events, 16, -1);
+      if (count < 0 && errno != EINTR) {
+        ALSALog.report(logvisor::Error, FMT_STRING("MIDI epoll_wait failed: {}"), strerror(errno));
+        return;
+      }
+
+      struct timespec ts;
+      clock_gettime(CLOCK_MONOTONIC, &ts);
+      const double time = TimespecToDouble(ts);
+
+      std::unique_lock lk(m_lock);
+      if (epoll != m_epoll)
+        return;
+      for (int i = 0; i < count; ++i) {
+        if (events[i].data.u64 == 0) {
+          uint64_t val;
+          [[maybe_unused]] ssize_t ret = read(wakeFd, &val, sizeof(val));
+          continue;
+        }
+        _service(events[i].data.u64, buf, sizeof(buf), time);
+      }
+    }
+  }
+
+  bool _start() {
+    m_epoll = epoll_create1(EPOLL_CLOEXEC);
+    m_wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.u64 = 0;
+    if (m_epoll < 0 || m_wakeFd < 0 || epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_wakeFd, &ev) < 0) {
+      ALSALog.report(logvisor::Error, FMT_STRING("unable to create MIDI epoll instance: {}"), strerror(errno));
+      if (m_epoll >= 0)
+        close(m_epoll);
+      if (m_wakeFd >= 0)
+        close(m_wakeFd);
+      m_epoll = m_wakeFd = -1;
+      return false;
+    }
+    m_thread = std::thread(&LinuxMidiReactor::_run, this, m_epoll, m_wakeFd);
+    return true;
+  }
+
+  void _stop(std::unique_lock<std::recursive_mutex>& lk) {
+    const int epoll = m_epoll;
+    const int wakeFd = m_wakeFd;
+    m_epoll = m_wakeFd = -1;
+    const uint64_t val = 1;
+    [[maybe_unused]] ssize_t ret = write(wakeFd, &val, sizeof(val));
+    std::thread thread = std::move(m_thread);
+    lk.unlock();
+    thread.join();
+    close(epoll);
+    close(wakeFd);
+    lk.lock();
+  }
+
+public:
+  static LinuxMidiReactor& Get() {
+    static LinuxMidiReactor reactor;
+    return reactor;
+  }
+
+  ~LinuxMidiReactor() {
+    std::unique_lock lk(m_lock);
+    if (m_thread.joinable())
+      _stop(lk);
+  }
+
+  /** Switch an input handle to non-blocking reads and start delivering it to receiver */
+  bool add(snd_rawmidi_t* midi, IMIDIReceiver* receiver) {
+    std::unique_lock lk(m_lock);
+    if (m_epoll < 0 && !_start())
+      return false;
+
+    snd_rawmidi_nonblock(midi, 1);
+    Port port{midi, receiver, std::vector<pollfd>(size_t(std::max(0, snd_rawmidi_poll_descriptors_count(midi))))};
+    snd_rawmidi_poll_descriptors(midi, port.m_pfds.data(), port.m_pfds.size());
+
+    const uint64_t id = m_nextId++;
+    for (const pollfd& pfd : port.m_pfds) {
+      epoll_event ev{};
+      ev.events = EPOLLIN | EPOLLERR | EPOLLHUP;
+      ev.data.u64 = id;
+      if (epoll_ctl(m_epoll, EPOLL_CTL_ADD, pfd.fd, &ev) < 0) {
+        ALSALog.report(logvisor::Error, FMT_STRING("unable to watch MIDI descriptor: {}"), strerror(errno));
+        _unwatch(port);
+        return false;
+      }
+    }
+    m_ports.emplace(id, std::move(port));
+    return true;
+  }
+
+  void remove(snd_rawmidi_t* midi) {
+    std::unique_lock lk(m_lock);
+    for (auto it = m_ports.begin(); it != m_ports.end(); ++it) {
+      if (it->second.m_midi == midi) {
+        _unwatch(it->second);
+        m_ports.erase(it);
+        break;
+      }
+    }
+    /* A port closed from within a receive callback leaves the idle thread for reuse */
+    if (m_ports.empty() && m_thread.joinable() && m_thread.get_id() != std::this_thread::get_id())
+      _stop(lk);
+  }
+};
+
 struct LinuxMidi : BaseAudioVoiceEngine {
   std::unordered_map<std::string, IMIDIPort*> m_openHandles;
   void _addOpenHandle(const char* name, IMIDIPort* port) { m_openHandles[name] = port; }
@@ -87,53 +270,18 @@ struct LinuxMidi : BaseAudioVoiceEngine {
 
   bool supportsVirtualMIDIIn() const override { return true; }
 
-  static void MIDIFreeProc(void* midiStatus) { snd_rawmidi_status_free((snd_rawmidi_status_t*)midiStatus); }
-
-  static void MIDIReceiveProc(snd_rawmidi_t* midi, const ReceiveFunctor& receiver) {
-    logvisor::RegisterThreadName("Boo MIDI");
-    snd_rawmidi_status_t* midiStatus;
-    snd_rawmidi_status_malloc(&midiStatus);
-    pthread_cleanup_push(MIDIFreeProc, midiStatus);
-
-    uint8_t buf[512];
-    while (true) {
-      snd_htimestamp_t ts;
-      snd_rawmidi_status(midi, midiStatus);
-      snd_rawmidi_status_get_tstamp(midiStatus, &ts);
-      int rdBytes = snd_rawmidi_read(midi, buf, 512);
-      if (rdBytes < 0) {
-        if (rdBytes != -EINTR) {
-          ALSALog.report(logvisor::Error, FMT_STRING("MIDI connection lost"));
-          break;
-        }
-        continue;
-      }
-
-      int oldtype;
-      pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &oldtype);
-      receiver(std::vector<uint8_t>(std::cbegin(buf), std::cbegin(buf) + rdBytes), TimespecToDouble(ts));
-      pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, &oldtype);
-      pthread_testcancel();
-    }
-
-    pthread_cleanup_pop(1);
-  }
-
   struct MIDIIn : public IMIDIIn {
     snd_rawmidi_t* m_midi;
-    std::thread m_midiThread;
 
     MIDIIn(LinuxMidi* parent, snd_rawmidi_t* midi, bool virt, ReceiveFunctor&& receiver)
-    : IMIDIIn(parent, virt, std::move(receiver))
-    , m_midi(midi)
-    , m_midiThread(std::bind(MIDIReceiveProc, m_midi, m_receiver)) {}
+    : IMIDIIn(parent, virt, std::move(receiver)), m_midi(midi) {
+      LinuxMidiReactor::Get().add(m_midi, this);
+    }
 
     ~MIDIIn() override {
       if (m_parent)
         static_cast<LinuxMidi*>(m_parent)->_removeOpenHandle(this);
-      pthread_cancel(m_midiThread.native_handle());
-      if (m_midiThread.joinable())
-        m_midiThread.join();
+      LinuxMidiReactor::Get().remove(m_midi);
       snd_rawmidi_close(m_midi);
     }
 
@@ -172,20 +320,16 @@ struct LinuxMidi : BaseAudioVoiceEngine {
   struct MIDIInOut : public IMIDIInOut {
     snd_rawmidi_t* m_midiIn;
     snd_rawmidi_t* m_midiOut;
-    std::thread m_midiThread;
 
     MIDIInOut(LinuxMidi* parent, snd_rawmidi_t* midiIn, snd_rawmidi_t* midiOut, bool virt, ReceiveFunctor&& receiver)
-    : IMIDIInOut(parent, virt, std::move(receiver))
-    , m_midiIn(midiIn)
-    , m_midiOut(midiOut)
-    , m_midiThread(std::bind(MIDIReceiveProc, m_midiIn, m_receiver)) {}
+    : IMIDIInOut(parent, virt, std::move(receiver)), m_midiIn(midiIn), m_midiOut(midiOut) {
+      LinuxMidiReactor::Get().add(m_midiIn, this);
+    }
 
     ~MIDIInOut() override {
       if (m_parent)
         static_cast<LinuxMidi*>(m_parent)->_removeOpenHandle(this);
-      pthread_cancel(m_midiThread.native_handle());
-      if (m_midiThread.joinable())
-        m_midiThread.join();
+      LinuxMidiReactor::Get().remove(m_midiIn);
       snd_rawmidi_close(m_midiIn);
       snd_rawmidi_close(m_midiOut);
     }
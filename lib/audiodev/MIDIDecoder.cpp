@@ -6,13 +6,30 @@
 #include "boo/audiodev/IMIDIReader.hpp"
 #include "lib/audiodev/MIDICommon.hpp"
 
-
 namespace boo {
 namespace {
 constexpr uint8_t clamp7(uint8_t val) { return std::clamp(val, uint8_t{0}, uint8_t{127}); }
 
-std::optional<uint32_t> readContinuedValue(std::vector<uint8_t>::const_iterator& it,
-                                           std::vector<uint8_t>::const_iterator end) {
+/* 0xff is a meta event in this stream, not System Reset */
+constexpr bool isRealtime(uint8_t val) { return val >= 0xf8 && val != 0xff; }
+
+void dispatchRealtime(IMIDIReader& out, uint8_t val) {
+  switch (Status(val)) {
+  case Status::Start:
+    out.startSeq();
+    break;
+  case Status::Continue:
+    out.continueSeq();
+    break;
+  case Status::Stop:
+    out.stopSeq();
+    break;
+  default:
+    break;
+  }
+}
+
+std::optional<uint32_t> readContinuedValue(const uint8_t*& it, const uint8_t* end) {
   uint8_t a = *it++;
   uint32_t valOut = a & 0x7f;
 
@@ -38,147 +55,158 @@ std::optional<uint32_t> readContinuedValue(std::vector<uint8_t>::const_iterator&
 }
 } // Anonymous namespace
 
-std::vector<uint8_t>::const_iterator MIDIDecoder::receiveBytes(std::vector<uint8_t>::const_iterator begin,
-                                                               std::vector<uint8_t>::const_iterator end) {
-  auto it = begin;
+const uint8_t* MIDIDecoder::receiveBytes(const uint8_t* begin, const uint8_t* end) {
+  const uint8_t* it = begin;
   while (it != end) {
+    /* Incomplete messages rewind here so the caller can resubmit them with more data */
+    const uint8_t* msgStart = it;
+    const uint8_t prevStatus = m_status;
+    const auto incomplete = [&]() {
+      m_status = prevStatus;
+      return msgStart;
+    };
+
+    /* Real-time messages may interleave anywhere, even between a message's data bytes, and leave running
+     * status intact. Ones inside a message are dispatched when it completes (ahead of it), so a rewound
+     * incomplete message doesn't repeat them */
+    bool interleaved = false;
+    const auto readData = [&](uint8_t& out) {
+      while (it != end) {
+        const uint8_t val = *it++;
+        if (!isRealtime(val)) {
+          out = val;
+          return true;
+        }
+        interleaved = true;
+      }
+      return false;
+    };
+    const auto complete = [&]() {
+      if (interleaved)
+        for (const uint8_t* rt = msgStart + 1; rt != it; ++rt)
+          if (isRealtime(*rt))
+            dispatchRealtime(m_out, *rt);
+    };
+
     uint8_t a = *it++;
     uint8_t b;
+    if (isRealtime(a)) {
+      dispatchRealtime(m_out, a);
+      continue;
+    }
     if (a & 0x80)
       m_status = a;
-    else
+    else if (m_status)
       it--;
+    else
+      continue; /* Data byte without a running status */
 
     if (m_status == 0xff) {
       /* Meta events (ignored for now) */
       if (it == end)
-        return begin;
+        return incomplete();
       a = *it++;
 
+      if (it == end)
+        return incomplete();
       const auto length = readContinuedValue(it, end);
+      if (!length || size_t(end - it) < *length)
+        return incomplete();
       it += *length;
     } else {
       uint8_t chan = m_status & 0xf;
       switch (Status(m_status & 0xf0)) {
       case Status::NoteOff: {
-        if (it == end)
-          return begin;
-        a = *it++;
-        if (it == end)
-          return begin;
-        b = *it++;
+        if (!readData(a) || !readData(b))
+          return incomplete();
+        complete();
         m_out.noteOff(chan, clamp7(a), clamp7(b));
         break;
       }
       case Status::NoteOn: {
-        if (it == end)
-          return begin;
-        a = *it++;
-        if (it == end)
-          return begin;
-        b = *it++;
+        if (!readData(a) || !readData(b))
+          return incomplete();
+        complete();
         m_out.noteOn(chan, clamp7(a), clamp7(b));
         break;
       }
       case Status::NotePressure: {
-        if (it == end)
-          return begin;
-        a = *it++;
-        if (it == end)
-          return begin;
-        b = *it++;
+        if (!readData(a) || !readData(b))
+          return incomplete();
+        complete();
         m_out.notePressure(chan, clamp7(a), clamp7(b));
         break;
       }
       case Status::ControlChange: {
-        if (it == end)
-          return begin;
-        a = *it++;
-        if (it == end)
-          return begin;
-        b = *it++;
+        if (!readData(a) || !readData(b))
+          return incomplete();
+        complete();
         m_out.controlChange(chan, clamp7(a), clamp7(b));
         break;
       }
       case Status::ProgramChange: {
-        if (it == end)
-          return begin;
-        a = *it++;
+        if (!readData(a))
+          return incomplete();
+        complete();
         m_out.programChange(chan, clamp7(a));
         break;
       }
       case Status::ChannelPressure: {
-        if (it == end)
-          return begin;
-        a = *it++;
+        if (!readData(a))
+          return incomplete();
+        complete();
         m_out.channelPressure(chan, clamp7(a));
         break;
       }
       case Status::PitchBend: {
-        if (it == end)
-          return begin;
-        a = *it++;
-        if (it == end)
-          return begin;
-        b = *it++;
+        if (!readData(a) || !readData(b))
+          return incomplete();
+        complete();
         m_out.pitchBend(chan, clamp7(b) * 128 + clamp7(a));
         break;
       }
       case Status::SysEx: {
         switch (Status(m_status & 0xff)) {
         case Status::SysEx: {
+          if (it == end)
+            return incomplete();
           const auto len = readContinuedValue(it, end);
-          if (!len || end - it < *len) {
-            return begin;
-          }
-          m_out.sysex(&*it, *len);
+          if (!len || size_t(end - it) < *len)
+            return incomplete();
+          m_out.sysex(it, *len);
+          it += *len;
           break;
         }
         case Status::TimecodeQuarterFrame: {
-          if (it == end)
-            return begin;
-          a = *it++;
+          if (!readData(a))
+            return incomplete();
+          complete();
           m_out.timeCodeQuarterFrame(a >> 4 & 0x7, a & 0xf);
           break;
         }
         case Status::SongPositionPointer: {
-          if (it == end)
-            return begin;
-          a = *it++;
-          if (it == end)
-            return begin;
-          b = *it++;
+          if (!readData(a) || !readData(b))
+            return incomplete();
+          complete();
           m_out.songPositionPointer(clamp7(b) * 128 + clamp7(a));
           break;
         }
         case Status::SongSelect: {
-          if (it == end)
-            return begin;
-          a = *it++;
+          if (!readData(a))
+            return incomplete();
+          complete();
           m_out.songSelect(clamp7(a));
           break;
         }
         case Status::TuneRequest:
           m_out.tuneRequest();
           break;
-        case Status::Start:
-          m_out.startSeq();
-          break;
-        case Status::Continue:
-          m_out.continueSeq();
-          break;
-        case Status::Stop:
-          m_out.stopSeq();
-          break;
-        case Status::Reset:
-          m_out.reset();
-          break;
         case Status::SysExTerm:
-        case Status::TimingClock:
-        case Status::ActiveSensing:
         default:
           break;
         }
+        /* System common messages cancel running status; stray data bytes after them are skipped */
+        m_status = 0;
         break;
       }
       default:
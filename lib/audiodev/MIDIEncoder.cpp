@@ -1,10 +1,15 @@
 #include "boo/audiodev/MIDIEncoder.hpp"
 
+#include <algorithm>
 #include <array>
+#include <cstring>
 
 #include "boo/audiodev/IMIDIPort.hpp"
 #include "lib/audiodev/MIDICommon.hpp"
 
+#undef min
+#undef max
+
 namespace boo {
 namespace {
 template <typename... Args>
@@ -14,16 +19,50 @@ constexpr auto MakeCommand(Args&&... args) -> std::array<uint8_t, sizeof...(Args
 } // Anonymous namespace
 
 template <class Sender>
-void MIDIEncoder<Sender>::_sendMessage(const uint8_t* data, size_t len) {
-  if (data[0] == m_status)
-    m_sender.send(data + 1, len - 1);
-  else {
-    if (data[0] & 0x80)
-      m_status = data[0];
+void MIDIEncoder<Sender>::_send(const void* data, size_t len) {
+  if (!m_buffered) {
     m_sender.send(data, len);
+    return;
+  }
+
+  /* Keep short messages within one write; longer data (SysEx) is chunked through the buffer */
+  if (m_bufferLen + len > m_buffer.size() && len <= m_buffer.size())
+    flush();
+  auto* bytes = static_cast<const uint8_t*>(data);
+  while (len) {
+    const size_t count = std::min(len, m_buffer.size() - m_bufferLen);
+    std::memcpy(m_buffer.data() + m_bufferLen, bytes, count);
+    m_bufferLen += count;
+    bytes += count;
+    len -= count;
+    if (m_bufferLen == m_buffer.size())
+      flush();
   }
 }
 
+template <class Sender>
+void MIDIEncoder<Sender>::flush() {
+  if (!m_bufferLen)
+    return;
+  m_sender.send(m_buffer.data(), m_bufferLen);
+  m_bufferLen = 0;
+}
+
+template <class Sender>
+void MIDIEncoder<Sender>::_sendMessage(const uint8_t* data, size_t len) {
+  if (data[0] == m_status) {
+    _send(data + 1, len - 1);
+    return;
+  }
+
+  /* System common messages cancel running status; real-time messages leave it intact */
+  if (data[0] < 0xf0)
+    m_status = data[0];
+  else if (data[0] < 0xf8)
+    m_status = 0;
+  _send(data, len);
+}
+
 template <class Sender>
 void MIDIEncoder<Sender>::_sendContinuedValue(uint32_t val) {
   std::array<uint8_t, 3> send{};
@@ -48,7 +87,7 @@ void MIDIEncoder<Sender>::_sendContinuedValue(uint32_t val) {
   send[2] = val & 0x7f;
 
   const size_t sendLength = send.size() - (ptr - send.data());
-  m_sender.send(ptr, sendLength);
+  _send(ptr, sendLength);
 }
 
 template <class Sender>
@@ -140,7 +179,7 @@ void MIDIEncoder<Sender>::sysex(const void* data, size_t len) {
   _sendMessage(sysexCmd);
 
   _sendContinuedValue(len);
-  m_sender.send(data, len);
+  _send(data, len);
 
   constexpr auto sysexTermCmd = MakeCommand(uint8_t(Status::SysExTerm));
   _sendMessage(sysexTermCmd);
@@ -149,7 +188,7 @@ void MIDIEncoder<Sender>::sysex(const void* data, size_t len) {
 template <class Sender>
 void MIDIEncoder<Sender>::timeCodeQuarterFrame(uint8_t message, uint8_t value) {
   const auto cmd =
-      MakeCommand(uint8_t(int(Status::TimecodeQuarterFrame)), uint8_t((message & 0x7 << 4) | (value & 0xf)));
+      MakeCommand(uint8_t(int(Status::TimecodeQuarterFrame)), uint8_t((message & 0x7) << 4 | (value & 0xf)));
   _sendMessage(cmd);
 }
 
@@ -162,7 +201,7 @@ void MIDIEncoder<Sender>::songPositionPointer(uint16_t pointer) {
 
 template <class Sender>
 void MIDIEncoder<Sender>::songSelect(uint8_t song) {
-  const auto cmd = MakeCommand(uint8_t(int(Status::TimecodeQuarterFrame)), uint8_t(song & 0x7f));
+  const auto cmd = MakeCommand(uint8_t(int(Status::SongSelect)), uint8_t(song & 0x7f));
   _sendMessage(cmd);
 }
 
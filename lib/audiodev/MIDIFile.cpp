@@ -0,0 +1,467 @@
+#include "boo/audiodev/MIDIFile.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#include "boo/audiodev/IMIDIReader.hpp"
+#include "lib/audiodev/MIDICommon.hpp"
+
+#include <logvisor/logvisor.hpp>
+
+#if _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN 1
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#undef min
+#undef max
+
+namespace boo {
+static logvisor::Module Log("boo::MIDIFile");
+
+namespace {
+constexpr uint32_t DefaultTempo = 500000; /* 120 BPM */
+
+uint32_t ReadBE32(const uint8_t* p) { return uint32_t(p[0]) << 24 | uint32_t(p[1]) << 16 | uint32_t(p[2]) << 8 | p[3]; }
+uint16_t ReadBE16(const uint8_t* p) { return uint16_t(p[0] << 8 | p[1]); }
+
+bool ReadVLQ(const uint8_t*& it, const uint8_t* end, uint32_t& out) {
+  out = 0;
+  for (int i = 0; i < 4; ++i) {
+    if (it == end)
+      return false;
+    const uint8_t b = *it++;
+    out = out << 7 | (b & 0x7f);
+    if (!(b & 0x80))
+      return true;
+  }
+  return false;
+}
+
+struct TrackEvent {
+  uint64_t m_tick;
+  uint32_t m_payload;
+  uint16_t m_track;
+  uint8_t m_status;
+};
+
+struct TempoChange {
+  uint64_t m_tick;
+  uint32_t m_usPerQuarter;
+};
+
+struct TrackChunk {
+  const uint8_t* m_begin;
+  const uint8_t* m_end;
+  std::vector<TrackEvent> m_events;
+  std::vector<TempoChange> m_tempos;
+  uint64_t m_endTick = 0;
+  bool m_ok = false;
+};
+
+/* Decodes one MTrk chunk; sysex and meta events cancel running status as per the SMF spec */
+bool DecodeTrack(const uint8_t* base, uint16_t track, TrackChunk& chunk) {
+  const uint8_t* it = chunk.m_begin;
+  const uint8_t* end = chunk.m_end;
+  uint64_t tick = 0;
+  uint8_t status = 0;
+  while (it != end) {
+    uint32_t delta;
+    if (!ReadVLQ(it, end, delta) || it == end)
+      return false;
+    tick += delta;
+
+    uint8_t ev = *it;
+    if (ev & 0x80)
+      ++it;
+    else if (status)
+      ev = status;
+    else
+      return false;
+
+    if (ev == 0xff) {
+      uint32_t len;
+      if (it == end)
+        return false;
+      const uint8_t type = *it++;
+      if (!ReadVLQ(it, end, len) || size_t(end - it) < len)
+        return false;
+      if (type == 0x51 && len == 3)
+        chunk.m_tempos.push_back({tick, uint32_t(it[0]) << 16 | uint32_t(it[1]) << 8 | it[2]});
+      it += len;
+      status = 0;
+      if (type == 0x2f)
+        break;
+    } else if (ev == 0xf0 || ev == 0xf7) {
+      const uint32_t offset = uint32_t(it - base);
+      uint32_t len;
+      if (!ReadVLQ(it, end, len) || size_t(end - it) < len)
+        return false;
+      it += len;
+      chunk.m_events.push_back({tick, offset, track, ev});
+      status = 0;
+    } else if (ev < 0xf0) {
+      const size_t dataBytes = (ev & 0xe0) == 0xc0 ? 1 : 2;
+      if (size_t(end - it) < dataBytes)
+        return false;
+      uint32_t payload = it[0] & 0x7f;
+      if (dataBytes == 2)
+        payload |= uint32_t(it[1] & 0x7f) << 8;
+      it += dataBytes;
+      chunk.m_events.push_back({tick, payload, track, ev});
+      status = ev;
+    } else {
+      /* System common/real-time bytes are not valid track events */
+      return false;
+    }
+  }
+  chunk.m_endTick = tick;
+  return true;
+}
+
+/* Piecewise-linear tick to seconds conversion */
+class TempoMap {
+  struct Segment {
+    uint64_t m_tick;
+    double m_seconds;
+    double m_secondsPerTick;
+  };
+  std::vector<Segment> m_segments;
+
+public:
+  TempoMap(uint16_t division, std::vector<TempoChange>& tempos) {
+    if (division & 0x8000) {
+      /* SMPTE timing ignores tempo; 29 denotes 29.97 drop-frame */
+      const int fps = -int8_t(division >> 8);
+      const double rate = fps == 29 ? 29.97 : double(fps);
+      m_segments.push_back({0, 0.0, 1.0 / (rate * (division & 0xff))});
+      return;
+    }
+
+    const double quarterTicks = double(division);
+    std::stable_sort(tempos.begin(), tempos.end(),
+                     [](const TempoChange& a, const TempoChange& b) { return a.m_tick < b.m_tick; });
+    m_segments.push_back({0, 0.0, DefaultTempo / 1.0e6 / quarterTicks});
+    for (const TempoChange& tc : tempos) {
+      const Segment& last = m_segments.back();
+      const double seconds = last.m_seconds + double(tc.m_tick - last.m_tick) * last.m_secondsPerTick;
+      if (tc.m_tick == last.m_tick)
+        m_segments.back().m_secondsPerTick = tc.m_usPerQuarter / 1.0e6 / quarterTicks;
+      else
+        m_segments.push_back({tc.m_tick, seconds, tc.m_usPerQuarter / 1.0e6 / quarterTicks});
+    }
+  }
+
+  /* Ticks must be queried in non-decreasing order through the same cursor */
+  double seconds(uint64_t tick, size_t& cursor) const {
+    while (cursor + 1 < m_segments.size() && m_segments[cursor + 1].m_tick <= tick)
+      ++cursor;
+    const Segment& seg = m_segments[cursor];
+    return seg.m_seconds + double(tick - seg.m_tick) * seg.m_secondsPerTick;
+  }
+};
+} // Anonymous namespace
+
+struct MIDIFile::Mapping {
+#if _WIN32
+  HANDLE m_file = INVALID_HANDLE_VALUE;
+  HANDLE m_map = nullptr;
+  const void* m_view = nullptr;
+
+  ~Mapping() {
+    if (m_view)
+      UnmapViewOfFile(m_view);
+    if (m_map)
+      CloseHandle(m_map);
+    if (m_file != INVALID_HANDLE_VALUE)
+      CloseHandle(m_file);
+  }
+
+  const uint8_t* map(const char* path, size_t& size) {
+    m_file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (m_file == INVALID_HANDLE_VALUE)
+      return nullptr;
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(m_file, &fileSize) || !fileSize.QuadPart)
+      return nullptr;
+    m_map = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!m_map)
+      return nullptr;
+    m_view = MapViewOfFile(m_map, FILE_MAP_READ, 0, 0, 0);
+    size = size_t(fileSize.QuadPart);
+    return static_cast<const uint8_t*>(m_view);
+  }
+#else
+  void* m_addr = MAP_FAILED;
+  size_t m_len = 0;
+
+  ~Mapping() {
+    if (m_addr != MAP_FAILED)
+      munmap(m_addr, m_len);
+  }
+
+  const uint8_t* map(const char* path, size_t& size) {
+    int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+      return nullptr;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+      m_len = size_t(st.st_size);
+      m_addr = mmap(nullptr, m_len, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    ::close(fd);
+    if (m_addr == MAP_FAILED)
+      return nullptr;
+    size = m_len;
+    return static_cast<const uint8_t*>(m_addr);
+  }
+#endif
+};
+
+MIDIFile::ChannelState::ChannelState() { std::fill(std::begin(m_controllers), std::end(m_controllers), 0xff); }
+
+MIDIFile::MIDIFile() = default;
+MIDIFile::~MIDIFile() = default;
+MIDIFile::MIDIFile(MIDIFile&&) noexcept = default;
+MIDIFile& MIDIFile::operator=(MIDIFile&&) noexcept = default;
+
+bool MIDIFile::open(const char* path) {
+  close();
+  auto mapping = std::make_unique<Mapping>();
+  size_t size = 0;
+  const uint8_t* data = mapping->map(path, size);
+  if (!data) {
+    Log.report(logvisor::Error, FMT_STRING("unable to map '{}'"), path);
+    return false;
+  }
+  m_mapping = std::move(mapping);
+  m_data = data;
+  m_size = size;
+  if (!_parse()) {
+    Log.report(logvisor::Error, FMT_STRING("'{}' is not a valid Standard MIDI File"), path);
+    close();
+    return false;
+  }
+  return true;
+}
+
+bool MIDIFile::load(std::span<const uint8_t> data) {
+  close();
+  m_ownedData.assign(data.begin(), data.end());
+  m_data = m_ownedData.data();
+  m_size = m_ownedData.size();
+  if (!_parse()) {
+    Log.report(logvisor::Error, FMT_STRING("data is not a valid Standard MIDI File"));
+    close();
+    return false;
+  }
+  return true;
+}
+
+void MIDIFile::close() {
+  m_mapping.reset();
+  m_ownedData = {};
+  m_data = nullptr;
+  m_size = 0;
+  m_format = 0;
+  m_trackCount = 0;
+  m_events = {};
+  m_checkpoints = {};
+  m_duration = 0.0;
+  m_cursor = 0;
+}
+
+bool MIDIFile::_parse() {
+  if (m_size < 14 || ReadBE32(m_data) != 0x4d546864 /* MThd */)
+    return false;
+  const uint32_t headerLen = ReadBE32(m_data + 4);
+  if (headerLen < 6 || m_size - 8 < headerLen)
+    return false;
+  m_format = ReadBE16(m_data + 8);
+  const uint16_t declaredTracks = ReadBE16(m_data + 10);
+  const uint16_t division = ReadBE16(m_data + 12);
+  if (m_format > 2 || !division || (division & 0x8000 && !(division & 0xff)))
+    return false;
+
+  /* Locate MTrk chunks, skipping unknown chunk types */
+  std::vector<TrackChunk> chunks;
+  chunks.reserve(declaredTracks);
+  const uint8_t* it = m_data + 8 + headerLen;
+  const uint8_t* end = m_data + m_size;
+  while (end - it >= 8 && chunks.size() < declaredTracks) {
+    const uint32_t type = ReadBE32(it);
+    const uint32_t len = ReadBE32(it + 4);
+    it += 8;
+    if (size_t(end - it) < len)
+      return false;
+    if (type == 0x4d54726b /* MTrk */)
+      chunks.push_back({it, it + len});
+    it += len;
+  }
+  m_trackCount = uint16_t(chunks.size());
+
+  /* Tracks are independent byte streams; decode them side by side */
+  const size_t threadCount = std::min(size_t(std::max(1u, std::thread::hardware_concurrency())), chunks.size());
+  std::atomic_size_t nextChunk = 0;
+  auto worker = [&]() {
+    for (size_t i = nextChunk++; i < chunks.size(); i = nextChunk++)
+      chunks[i].m_ok = DecodeTrack(m_data, uint16_t(i), chunks[i]);
+  };
+  std::vector<std::thread> pool;
+  for (size_t t = 1; t < threadCount; ++t)
+    pool.emplace_back(worker);
+  worker();
+  for (std::thread& thr : pool)
+    thr.join();
+
+  size_t eventCount = 0;
+  uint64_t endTick = 0;
+  std::vector<TempoChange> tempos;
+  for (const TrackChunk& chunk : chunks) {
+    if (!chunk.m_ok)
+      return false;
+    eventCount += chunk.m_events.size();
+    endTick = std::max(endTick, chunk.m_endTick);
+    tempos.insert(tempos.end(), chunk.m_tempos.begin(), chunk.m_tempos.end());
+  }
+
+  /* Merge in track order so simultaneous events keep their track priority */
+  std::vector<TrackEvent> merged;
+  merged.reserve(eventCount);
+  for (TrackChunk& chunk : chunks) {
+    merged.insert(merged.end(), chunk.m_events.begin(), chunk.m_events.end());
+    chunk.m_events = {};
+  }
+  std::stable_sort(merged.begin(), merged.end(),
+                   [](const TrackEvent& a, const TrackEvent& b) { return a.m_tick < b.m_tick; });
+
+  const TempoMap tempoMap(division, tempos);
+  size_t tempoCursor = 0;
+  m_events.reserve(merged.size());
+  for (const TrackEvent& ev : merged)
+    m_events.push_back({tempoMap.seconds(ev.m_tick, tempoCursor), ev.m_payload, ev.m_track, ev.m_status});
+  m_duration = tempoMap.seconds(endTick, tempoCursor);
+
+  _buildCheckpoints();
+  return true;
+}
+
+void MIDIFile::_applyState(ChannelState* channels, const Event& ev) {
+  if (ev.m_status >= 0xf0)
+    return;
+  ChannelState& ch = channels[ev.m_status & 0xf];
+  const uint8_t d1 = ev.m_payload & 0x7f;
+  const uint8_t d2 = (ev.m_payload >> 8) & 0x7f;
+  switch (Status(ev.m_status & 0xf0)) {
+  case Status::ControlChange:
+    /* 120-127 are channel mode messages (sound/notes off, controller reset), not state to chase */
+    if (d1 < 120)
+      ch.m_controllers[d1] = d2;
+    break;
+  case Status::ProgramChange:
+    ch.m_program = d1;
+    break;
+  case Status::PitchBend:
+    ch.m_bend = uint16_t(d2 << 7 | d1);
+    break;
+  default:
+    break;
+  }
+}
+
+void MIDIFile::_buildCheckpoints() {
+  ChannelState channels[16];
+  m_checkpoints.reserve((m_events.size() + CheckpointInterval - 1) / CheckpointInterval * 16);
+  for (size_t i = 0; i < m_events.size(); ++i) {
+    if (i % CheckpointInterval == 0)
+      m_checkpoints.insert(m_checkpoints.end(), std::begin(channels), std::end(channels));
+    _applyState(channels, m_events[i]);
+  }
+}
+
+void MIDIFile::_dispatch(const Event& ev, IMIDIReader& out) const {
+  const uint8_t chan = ev.m_status & 0xf;
+  const uint8_t d1 = ev.m_payload & 0x7f;
+  const uint8_t d2 = (ev.m_payload >> 8) & 0x7f;
+  switch (Status(ev.m_status & 0xf0)) {
+  case Status::NoteOff:
+    out.noteOff(chan, d1, d2);
+    break;
+  case Status::NoteOn:
+    out.noteOn(chan, d1, d2);
+    break;
+  case Status::NotePressure:
+    out.notePressure(chan, d1, d2);
+    break;
+  case Status::ControlChange:
+    out.controlChange(chan, d1, d2);
+    break;
+  case Status::ProgramChange:
+    out.programChange(chan, d1);
+    break;
+  case Status::ChannelPressure:
+    out.channelPressure(chan, d1);
+    break;
+  case Status::PitchBend:
+    out.pitchBend(chan, int16_t(d2 * 128 + d1));
+    break;
+  case Status::SysEx: {
+    /* Validated during parsing */
+    const uint8_t* it = m_data + ev.m_payload;
+    uint32_t len;
+    ReadVLQ(it, m_data + m_size, len);
+    out.sysex(it, len);
+    break;
+  }
+  default:
+    break;
+  }
+}
+
+void MIDIFile::seek(double time, IMIDIReader* chase) {
+  auto it = std::lower_bound(m_events.begin(), m_events.end(), time,
+                             [](const Event& ev, double t) { return ev.m_time < t; });
+  m_cursor = size_t(it - m_events.begin());
+  if (!chase || m_events.empty())
+    return;
+
+  const size_t checkpoint = std::min(m_cursor, m_events.size() - 1) / CheckpointInterval;
+  ChannelState channels[16];
+  std::copy_n(m_checkpoints.begin() + checkpoint * 16, 16, channels);
+  for (size_t i = checkpoint * CheckpointInterval; i < m_cursor; ++i)
+    _applyState(channels, m_events[i]);
+
+  /* Bank select only takes effect with the following program change, so it goes first */
+  constexpr uint8_t BankMSB = 0;
+  constexpr uint8_t BankLSB = 32;
+  for (uint8_t c = 0; c < 16; ++c) {
+    const ChannelState& ch = channels[c];
+    for (uint8_t cc : {BankMSB, BankLSB})
+      if (ch.m_controllers[cc] != 0xff)
+        chase->controlChange(c, cc, ch.m_controllers[cc]);
+    if (ch.m_program != 0xff)
+      chase->programChange(c, ch.m_program);
+    for (uint8_t cc = 0; cc < 120; ++cc)
+      if (cc != BankMSB && cc != BankLSB && ch.m_controllers[cc] != 0xff)
+        chase->controlChange(c, cc, ch.m_controllers[cc]);
+    if (ch.m_bend != 0xffff)
+      chase->pitchBend(c, int16_t(ch.m_bend));
+  }
+}
+
+size_t MIDIFile::play(double until, IMIDIReader& out) {
+  const size_t begin = m_cursor;
+  for (; m_cursor < m_events.size() && m_events[m_cursor].m_time < until; ++m_cursor)
+    _dispatch(m_events[m_cursor], out);
+  return m_cursor - begin;
+}
+
+} // namespace boo
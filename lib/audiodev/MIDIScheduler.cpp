@@ -0,0 +1,195 @@
+#include "lib/audiodev/MIDIScheduler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+#include "boo/audiodev/MIDIDecoder.hpp"
+
+#undef min
+#undef max
+
+namespace boo {
+namespace {
+/* Clock error beyond this (an underrun or stalled device) re-anchors instead of slewing */
+constexpr double ResyncThreshold = 0.05;
+constexpr double ClockSmoothing = 0.05;
+
+double SteadyNow() {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/* Data bytes following a status byte; 0xff for SysEx and undefined statuses, whose data is skipped */
+uint8_t DataBytes(uint8_t status) {
+  switch (status & 0xf0) {
+  case 0xc0:
+  case 0xd0:
+    return 1;
+  case 0xf0:
+    break;
+  default:
+    return 2;
+  }
+  switch (status) {
+  case 0xf1:
+  case 0xf3:
+    return 1;
+  case 0xf2:
+    return 2;
+  case 0xf6:
+    return 0;
+  default:
+    return 0xff;
+  }
+}
+
+/* Splits one port's byte stream into messages, tracking its running status */
+class ScheduleReceiveHook final : public IMIDIReceiveHook {
+  MIDIScheduler& m_scheduler;
+  uint8_t m_status = 0;
+  uint8_t m_need = 0;
+  uint8_t m_count = 0;
+  uint8_t m_data[2] = {};
+
+public:
+  explicit ScheduleReceiveHook(MIDIScheduler& scheduler) : m_scheduler(scheduler) {}
+
+  void receive(const uint8_t* data, size_t len, double time) override {
+    for (const uint8_t* end = data + len; data != end; ++data) {
+      const uint8_t b = *data;
+      if (b >= 0xf8) {
+        /* Real-time messages may appear anywhere, even inside other messages */
+        m_scheduler.post(&b, 1, time);
+        continue;
+      }
+      if (b & 0x80) {
+        m_status = b;
+        m_need = DataBytes(b);
+        m_count = 0;
+        if (!m_need) {
+          m_scheduler.post(&b, 1, time);
+          m_status = 0;
+        }
+        continue;
+      }
+      if (!m_status || m_need == 0xff)
+        continue;
+      m_data[m_count++] = b;
+      if (m_count < m_need)
+        continue;
+      const uint8_t msg[3] = {m_status, m_data[0], m_data[1]};
+      m_scheduler.post(msg, 1 + m_need, time);
+      m_count = 0;
+      if (m_status >= 0xf0)
+        m_status = 0;
+    }
+  }
+};
+} // Anonymous namespace
+
+MIDIScheduler::MIDIScheduler() : m_cells(new Cell[Capacity]) {
+  for (size_t i = 0; i < Capacity; ++i)
+    m_cells[i].m_seq.store(i, std::memory_order_relaxed);
+  m_pending.reserve(Capacity);
+}
+
+bool MIDIScheduler::post(const uint8_t* data, size_t len, double time) {
+  size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+  Cell* cell;
+  for (;;) {
+    cell = &m_cells[pos % Capacity];
+    const size_t seq = cell->m_seq.load(std::memory_order_acquire);
+    const auto dif = intptr_t(seq) - intptr_t(pos);
+    if (dif == 0) {
+      if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+        break;
+    } else if (dif < 0) {
+      m_dropped.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    } else {
+      pos = m_enqueuePos.load(std::memory_order_relaxed);
+    }
+  }
+
+  cell->m_msg.m_time = time;
+  cell->m_msg.m_length = uint8_t(std::min(len, sizeof(cell->m_msg.m_data)));
+  std::memcpy(cell->m_msg.m_data, data, cell->m_msg.m_length);
+  cell->m_seq.store(pos + 1, std::memory_order_release);
+  return true;
+}
+
+bool MIDIScheduler::_pop(Message& msg) {
+  Cell& cell = m_cells[m_dequeuePos % Capacity];
+  if (cell.m_seq.load(std::memory_order_acquire) != m_dequeuePos + 1)
+    return false;
+  msg = cell.m_msg;
+  cell.m_seq.store(m_dequeuePos + Capacity, std::memory_order_release);
+  ++m_dequeuePos;
+  return true;
+}
+
+ReceiveFunctor MIDIScheduler::newReceiver() {
+  return MIDIReceiveHookFunctor{std::make_shared<ScheduleReceiveHook>(*this)};
+}
+
+void MIDIScheduler::setReader(IMIDIReader* reader, double latency) {
+  m_latency.store(std::max(latency, 0.0), std::memory_order_relaxed);
+  m_reader.store(reader, std::memory_order_release);
+}
+
+void MIDIScheduler::beginBlock(uint64_t mixPosition, double sampleRate) {
+  const double now = SteadyNow();
+  if (m_clockValid) {
+    const double predicted = m_clockTime + double(mixPosition - m_clockFrame) / sampleRate;
+    const double err = now - predicted;
+    m_clockTime = std::fabs(err) > ResyncThreshold ? now : predicted + err * ClockSmoothing;
+  } else {
+    m_clockTime = now;
+    m_clockValid = true;
+  }
+  m_clockFrame = mixPosition;
+
+  if (m_pendingHead) {
+    m_pending.erase(m_pending.begin(), m_pending.begin() + m_pendingHead);
+    m_pendingHead = 0;
+  }
+
+  /* Timestamps from another clock base degrade to immediate delivery rather than stalling the queue */
+  const bool active = m_reader.load(std::memory_order_acquire) != nullptr;
+  const double latency = m_latency.load(std::memory_order_relaxed);
+  Message msg;
+  while (_pop(msg)) {
+    if (!active)
+      continue;
+    const double delay = std::clamp(msg.m_time + latency - m_clockTime, 0.0, 2.0 * latency);
+    msg.m_frame = mixPosition + uint64_t(std::llround(delay * sampleRate));
+    m_pending.insert(std::upper_bound(m_pending.begin(), m_pending.end(), msg,
+                                      [](const Message& a, const Message& b) { return a.m_frame < b.m_frame; }),
+                     msg);
+  }
+}
+
+size_t MIDIScheduler::deliver(uint64_t mixPosition, size_t frames) {
+  IMIDIReader* reader = m_reader.load(std::memory_order_acquire);
+  if (!reader) {
+    m_pending.clear();
+    m_pendingHead = 0;
+    return frames;
+  }
+
+  MIDIDecoder decoder(*reader);
+  while (m_pendingHead < m_pending.size() && m_pending[m_pendingHead].m_frame <= mixPosition) {
+    const Message& msg = m_pending[m_pendingHead++];
+    decoder.receiveBytes(msg.m_data, msg.m_data + msg.m_length);
+  }
+
+  if (m_pendingHead == m_pending.size()) {
+    m_pending.clear();
+    m_pendingHead = 0;
+    return frames;
+  }
+  return size_t(std::min(uint64_t(frames), m_pending[m_pendingHead].m_frame - mixPosition));
+}
+
+} // namespace boo
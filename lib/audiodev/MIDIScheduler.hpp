@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "boo/audiodev/IMIDIPort.hpp"
+
+namespace boo {
+class IMIDIReader;
+
+/** Aligns incoming MIDI to audio frames for BaseAudioVoiceEngine.
+ *  Receive threads post complete short messages into a bounded lock-free MPSC queue;
+ *  at the start of each pump the engine drains it, converting timestamps (steady_clock seconds)
+ *  to frames via the mix position disciplined against the system clock. Messages are then
+ *  dispatched to the reader on the mixing thread at their frame, splitting the mix there */
+class MIDIScheduler {
+  struct Message {
+    double m_time;
+    uint64_t m_frame;
+    uint8_t m_length;
+    uint8_t m_data[3];
+  };
+
+  static constexpr size_t Capacity = 1024;
+  struct Cell {
+    std::atomic<size_t> m_seq;
+    Message m_msg;
+  };
+  std::unique_ptr<Cell[]> m_cells;
+  alignas(64) std::atomic<size_t> m_enqueuePos{0};
+  alignas(64) size_t m_dequeuePos = 0;
+  std::atomic<size_t> m_dropped{0};
+
+  /* Mixing thread only; sorted by frame, consumed from m_pendingHead */
+  std::vector<Message> m_pending;
+  size_t m_pendingHead = 0;
+
+  std::atomic<IMIDIReader*> m_reader{nullptr};
+  std::atomic<double> m_latency{0.01};
+
+  bool m_clockValid = false;
+  double m_clockTime = 0.0;
+  uint64_t m_clockFrame = 0;
+
+  bool _pop(Message& msg);
+
+public:
+  MIDIScheduler();
+
+  /** Producer side, any thread; data must be one complete message of at most 3 bytes */
+  bool post(const uint8_t* data, size_t len, double time);
+
+  /** ReceiveFunctor that splits a port's byte stream into messages (tracking its running status) and posts them.
+   *  It wraps an IMIDIReceiveHook, so ports read into it without allocating. SysEx is not scheduled and is skipped */
+  ReceiveFunctor newReceiver();
+
+  /** Messages are delivered latency seconds after their timestamp; nullptr stops delivery */
+  void setReader(IMIDIReader* reader, double latency);
+
+  /** Forget the clock mapping (sample rate changed) */
+  void resetClock() { m_clockValid = false; }
+
+  /** Mixing thread; sync the clock at mixPosition and move posted messages into the pending list */
+  void beginBlock(uint64_t mixPosition, double sampleRate);
+
+  /** Mixing thread; dispatch messages due at mixPosition and return the frames (at most `frames`) until the next */
+  size_t deliver(uint64_t mixPosition, size_t frames);
+
+  /** Messages lost to a full queue */
+  size_t droppedMessages() const { return m_dropped.load(std::memory_order_relaxed); }
+};
+
+} // namespace boo
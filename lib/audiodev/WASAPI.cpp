@@ -566,25 +566,31 @@ struct WASAPIAudioVoiceEngine : BaseAudioVoiceEngine {
 #ifdef TE_VIRTUAL_MIDI
   static void CALLBACK VirtualMIDIReceiveProc(LPVM_MIDI_PORT midiPort, LPBYTE midiDataBytes, DWORD length,
                                               IMIDIReceiver* dwInstance) {
-    std::vector<uint8_t> bytes;
-    bytes.resize(length);
-    memcpy(&bytes[0], midiDataBytes, length);
-
     double timestamp;
     LARGE_INTEGER perf;
     QueryPerformanceCounter(&perf);
     timestamp = perf.QuadPart / PerfFrequency;
 
-    dwInstance->m_receiver(std::move(bytes), timestamp);
+    dwInstance->_receive(midiDataBytes, length, timestamp);
   }
 #endif
 
   static void CALLBACK MIDIReceiveProc(HMIDIIN hMidiIn, UINT wMsg, IMIDIReceiver* dwInstance, DWORD_PTR dwParam1,
                                        DWORD_PTR dwParam2) {
     if (wMsg == MIM_DATA) {
+      /* dwParam2 counts from midiInStart; stamp with QPC so all ports share the steady_clock base */
+      LARGE_INTEGER perf;
+      QueryPerformanceCounter(&perf);
       uint8_t(&ptr)[3] = reinterpret_cast<uint8_t(&)[3]>(dwParam1);
-      std::vector<uint8_t> bytes(std::cbegin(ptr), std::cend(ptr));
-      dwInstance->m_receiver(std::move(bytes), dwParam2 / 1000.0);
+
+      /* Short messages are packed into a DWORD; forward only the bytes that belong to the message
+       * so the padding isn't read as running-status data */
+      size_t len = 3;
+      if (ptr[0] >= 0xf8 || ptr[0] == 0xf6)
+        len = 1;
+      else if ((ptr[0] & 0xe0) == 0xc0 || ptr[0] == 0xf1 || ptr[0] == 0xf3)
+        len = 2;
+      dwInstance->_receive(ptr, len, perf.QuadPart / PerfFrequency);
     }
   }
 
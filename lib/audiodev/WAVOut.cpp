@@ -1,6 +1,9 @@
 #include "lib/audiodev/AudioVoiceEngine.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <cstdio>
+#include <thread>
 
 #include "boo/audiodev/IAudioVoiceEngine.hpp"
 #include <logvisor/logvisor.hpp>
@@ -252,4 +255,38 @@ std::unique_ptr<IAudioVoiceEngine> NewWAVAudioVoiceEngine(const wchar_t* path, d
 }
 #endif
 
+void RenderWAVJobs(std::vector<WAVRenderJob>& jobs, unsigned threadCount) {
+  if (jobs.empty())
+    return;
+  if (!threadCount)
+    threadCount = std::max(1u, std::thread::hardware_concurrency());
+  threadCount = unsigned(std::min(size_t(threadCount), jobs.size()));
+
+  std::atomic_size_t nextJob = 0;
+  auto worker = [&]() {
+    for (size_t i = nextJob++; i < jobs.size(); i = nextJob++) {
+      WAVRenderJob& job = jobs[i];
+      job.succeeded = false;
+      std::unique_ptr<IAudioVoiceEngine> engine =
+          NewWAVAudioVoiceEngine(job.path.c_str(), job.sampleRate, job.numChans);
+      if (!engine) {
+        Log.report(logvisor::Error, FMT_STRING("unable to open '{}' for rendering"), job.path);
+        continue;
+      }
+      if (job.render)
+        job.render(*engine);
+      engine.reset();
+      job.succeeded = true;
+    }
+  };
+
+  std::vector<std::thread> pool;
+  pool.reserve(threadCount - 1);
+  for (unsigned t = 1; t < threadCount; ++t)
+    pool.emplace_back(worker);
+  worker();
+  for (std::thread& thr : pool)
+    thr.join();
+}
+
 } // namespace boo
@@ -7,12 +7,13 @@ namespace boo {
 DeviceBase::DeviceBase(uint64_t typeHash, DeviceToken* token) : m_typeHash(typeHash), m_token(token) {}
 
 void DeviceBase::_deviceDisconnected() {
-  deviceDisconnected();
+  /* Stop the reader first; where that is synchronous, finalCycle has published its state before the callback */
   m_token = nullptr;
   if (m_hidDev) {
     m_hidDev->_deviceDisconnected();
     m_hidDev.reset();
   }
+  deviceDisconnected();
 }
 
 void DeviceBase::closeDevice() {
@@ -1,4 +1,5 @@
 #include "boo/inputdev/DeviceFinder.hpp"
+#include "lib/inputdev/HIDCapture.hpp"
 
 #include <cstdio>
 #include <cstdlib>
@@ -19,14 +20,9 @@ DeviceFinder::DeviceFinder(std::unordered_set<uint64_t> types) {
     std::abort();
   }
   skDevFinder = this;
-  for (const uint64_t& typeHash : types) {
-    const DeviceSignature* sigIter = BOO_DEVICE_SIGS;
-    while (sigIter->m_name) {
-      if (sigIter->m_typeHash == typeHash)
-        m_types.push_back(sigIter);
-      ++sigIter;
-    }
-  }
+  for (const DeviceSignature* sigIter = BOO_DEVICE_SIGS; sigIter->m_name; ++sigIter)
+    if (types.find(sigIter->m_typeHash) != types.end())
+      m_types.push_back(sigIter);
 }
 
 DeviceFinder::~DeviceFinder() {
@@ -35,7 +31,7 @@ DeviceFinder::~DeviceFinder() {
   skDevFinder = nullptr;
 }
 
-bool DeviceFinder::_insertToken(std::unique_ptr<DeviceToken>&& token) {
+bool DeviceFinder::_insertToken(std::unique_ptr<DeviceToken>&& token, InputClock::time_point arrival) {
   if (!DeviceSignature::DeviceMatchToken(*token, m_types)) {
     return false;
   }
@@ -43,7 +39,11 @@ bool DeviceFinder::_insertToken(std::unique_ptr<DeviceToken>&& token) {
   m_tokensLock.lock();
   const TInsertedDeviceToken insertedTok = m_tokens.emplace(token->getDevicePath(), std::move(token));
   m_tokensLock.unlock();
+  /* A hotplug event may race a manual scan to the same device */
+  if (!insertedTok.second)
+    return false;
   deviceConnected(*insertedTok.first->second);
+  m_arrivalLatency.record(arrival);
   return true;
 }
 
@@ -62,6 +62,34 @@ void DeviceFinder::_removeToken(const std::string& path) {
   m_tokensLock.unlock();
 }
 
+bool DeviceFinder::addReplayDevice(const char* capturePath, const HIDReplayOptions& options) {
+  const InputClock::time_point arrival = InputClock::now();
+  HIDCapture capture;
+  if (!capture.load(capturePath))
+    return false;
+
+  std::string path(ReplayPathPrefix);
+  path += capturePath;
+  if (_hasToken(path))
+    return false;
+  RegisterHIDReplay(path, options);
+  if (!_insertToken(std::make_unique<DeviceToken>(capture.m_type, capture.m_vid, capture.m_pid,
+                                                  capture.m_vendorName.c_str(), capture.m_productName.c_str(),
+                                                  path.c_str()),
+                    arrival)) {
+    UnregisterHIDReplay(path);
+    return false;
+  }
+  return true;
+}
+
+void DeviceFinder::removeReplayDevice(const char* capturePath) {
+  std::string path(ReplayPathPrefix);
+  path += capturePath;
+  _removeToken(path);
+  UnregisterHIDReplay(path);
+}
+
 bool DeviceFinder::startScanning() {
   if (!m_listener)
     m_listener = IHIDListenerNew(*this);
@@ -1,55 +1,82 @@
 #include "boo/inputdev/DeviceSignature.hpp"
 #include "boo/inputdev/DeviceToken.hpp"
+#include "boo/inputdev/EvdevPad.hpp"
 #include "boo/inputdev/GenericPad.hpp"
+#include "lib/inputdev/HIDCapture.hpp"
 #include "lib/inputdev/IHIDDevice.hpp"
 
+#include <algorithm>
+#include <unordered_map>
+
 namespace boo {
 
 extern const DeviceSignature BOO_DEVICE_SIGS[];
 
+const DeviceSignature* DeviceSignature::Find(unsigned vid, unsigned pid) {
+  /* Generic classes (zero VID/PID) are chosen by device type, not indexed; the first entry for an ID wins */
+  static const std::unordered_map<uint64_t, const DeviceSignature*> Index = []() {
+    std::unordered_map<uint64_t, const DeviceSignature*> index;
+    for (const DeviceSignature* sig = BOO_DEVICE_SIGS; sig->m_name; ++sig)
+      if (sig->m_vid || sig->m_pid)
+        index.emplace(uint64_t(sig->m_vid) << 32 | sig->m_pid, sig);
+    return index;
+  }();
+
+  const auto search = Index.find(uint64_t(vid) << 32 | pid);
+  return search != Index.end() ? search->second : nullptr;
+}
+
 bool DeviceSignature::DeviceMatchToken(const DeviceToken& token, const TDeviceSignatureSet& sigSet) {
+  /* The interested set holds at most one entry per device class */
+  const auto interested = [&](const DeviceSignature* sig) {
+    return std::find(sigSet.begin(), sigSet.end(), sig) != sigSet.end();
+  };
+  const DeviceSignature* sig = Find(token.getVendorId(), token.getProductId());
   if (token.getDeviceType() == DeviceType::HID) {
-    uint64_t genPadHash = dev_typeid(GenericPad);
-    bool hasGenericPad = false;
-    for (const DeviceSignature* sig : sigSet) {
-      if (sig->m_vid == token.getVendorId() && sig->m_pid == token.getProductId() && sig->m_type != DeviceType::HID)
-        return false;
-      if (sig->m_typeHash == genPadHash)
-        hasGenericPad = true;
-    }
-    return hasGenericPad;
+    /* The HID interface of a device driven through another transport is left to that one */
+    if (sig && sig->m_type != DeviceType::HID && interested(sig))
+      return false;
+    static const uint64_t GenericPadHash = dev_typeid(GenericPad);
+    return std::any_of(sigSet.begin(), sigSet.end(),
+                       [](const DeviceSignature* s) { return s->m_typeHash == GenericPadHash; });
   }
-  for (const DeviceSignature* sig : sigSet) {
-    if (sig->m_vid == token.getVendorId() && sig->m_pid == token.getProductId())
-      return true;
+  if (token.getDeviceType() == DeviceType::Evdev) {
+    /* Likewise a device with a dedicated class skips its kernel driver's node */
+    if (sig && interested(sig))
+      return false;
+    static const uint64_t EvdevPadHash = dev_typeid(EvdevPad);
+    return std::any_of(sigSet.begin(), sigSet.end(),
+                       [](const DeviceSignature* s) { return s->m_typeHash == EvdevPadHash; });
   }
-  return false;
+  return sig && interested(sig);
 }
 
 std::shared_ptr<IHIDDevice> IHIDDeviceNew(DeviceToken& token, const std::shared_ptr<DeviceBase>& devImp);
+std::shared_ptr<IHIDDevice> IHIDDeviceReplayNew(DeviceToken& token, const std::shared_ptr<DeviceBase>& devImp);
+
+static std::shared_ptr<IHIDDevice> HIDDeviceNew(DeviceToken& token, const std::shared_ptr<DeviceBase>& devImp) {
+  if (token.getDevicePath().starts_with(ReplayPathPrefix))
+    return IHIDDeviceReplayNew(token, devImp);
+  return IHIDDeviceNew(token, devImp);
+}
+
 std::shared_ptr<DeviceBase> DeviceSignature::DeviceNew(DeviceToken& token) {
   std::shared_ptr<DeviceBase> retval;
 
-  /* Perform signature-matching to find the appropriate device-factory */
-  const DeviceSignature* foundSig = nullptr;
-  const DeviceSignature* sigIter = BOO_DEVICE_SIGS;
-  unsigned targetVid = token.getVendorId();
-  unsigned targetPid = token.getProductId();
-  while (sigIter->m_name) {
-    if (sigIter->m_vid == targetVid && sigIter->m_pid == targetPid) {
-      foundSig = sigIter;
-      break;
-    }
-    ++sigIter;
-  }
+  /* Perform signature-matching to find the appropriate device-factory; evdev nodes are always generic */
+  const DeviceSignature* foundSig =
+      token.getDeviceType() != DeviceType::Evdev ? Find(token.getVendorId(), token.getProductId()) : nullptr;
   if (!foundSig) {
-    /* Try Generic HID devices */
-    if (token.getDeviceType() == DeviceType::HID) {
-      retval = std::make_shared<GenericPad>(&token);
+    /* Try Generic HID and evdev devices */
+    if (token.getDeviceType() == DeviceType::HID || token.getDeviceType() == DeviceType::Evdev) {
+      if (token.getDeviceType() == DeviceType::HID)
+        retval = std::make_shared<GenericPad>(&token);
+      else
+        retval = std::make_shared<EvdevPad>(&token);
       if (!retval)
         return nullptr;
 
-      retval->m_hidDev = IHIDDeviceNew(token, retval);
+      retval->m_hidDev = HIDDeviceNew(token, retval);
       if (!retval->m_hidDev)
         return nullptr;
       retval->m_hidDev->_startThread();
@@ -66,7 +93,7 @@ std::shared_ptr<DeviceBase> DeviceSignature::DeviceNew(DeviceToken& token) {
   if (!retval)
     return nullptr;
 
-  retval->m_hidDev = IHIDDeviceNew(token, retval);
+  retval->m_hidDev = HIDDeviceNew(token, retval);
   if (!retval->m_hidDev)
     return nullptr;
   retval->m_hidDev->_startThread();
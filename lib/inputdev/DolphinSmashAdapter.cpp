@@ -50,34 +50,37 @@ void DolphinSmashAdapter::initialCycle() {
 void DolphinSmashAdapter::transferCycle() {
   std::array<uint8_t, 37> payload;
   const size_t recvSz = receiveUSBInterruptTransfer(payload.data(), payload.size());
-  if (recvSz != payload.size() || payload[0] != 0x21) {
-    return;
-  }
-
-  // fmt::print("RECEIVED DATA {} {:02X}\n", recvSz, payload[0]);
+  receivedPayload(payload.data(), recvSz);
+}
 
-  std::lock_guard<std::mutex> lk(m_callbackLock);
-  if (!m_callback) {
+void DolphinSmashAdapter::receivedPayload(const uint8_t* payload, size_t length) {
+  if (length != 37 || payload[0] != 0x21) {
     return;
   }
 
   /* Parse controller states */
+  TimedState<DolphinSmashAdapterState>& latest = m_latestState.back();
+  latest.m_time = reportTime();
+  DolphinSmashAdapterState& ports = latest.m_state;
   const uint8_t* controller = &payload[1];
   uint8_t rumbleMask = 0;
+  uint8_t connected = 0;
+  uint8_t disconnected = 0;
   for (uint32_t i = 0; i < 4; i++, controller += 9) {
-    DolphinControllerState state;
+    DolphinControllerState& state = ports.m_states[i];
     bool rumble = false;
     const EDolphinControllerType type = parseState(&state, controller, rumble);
+    ports.m_types[i] = type;
 
     if (True(type) && (m_knownControllers & (1U << i)) == 0) {
       m_leftStickCal = state.m_leftStick;
       m_rightStickCal = state.m_rightStick;
       m_triggersCal = state.m_analogTriggers;
       m_knownControllers |= 1U << i;
-      m_callback->controllerConnected(i, type);
+      connected |= 1U << i;
     } else if (False(type) && (m_knownControllers & (1U << i)) != 0) {
       m_knownControllers &= ~(1U << i);
-      m_callback->controllerDisconnected(i);
+      disconnected |= 1U << i;
     }
 
     if ((m_knownControllers & (1U << i)) != 0) {
@@ -87,12 +90,33 @@ void DolphinSmashAdapter::transferCycle() {
       state.m_rightStick[1] = state.m_rightStick[1] - m_rightStickCal[1];
       state.m_analogTriggers[0] = state.m_analogTriggers[0] - m_triggersCal[0];
       state.m_analogTriggers[1] = state.m_analogTriggers[1] - m_triggersCal[1];
-      m_callback->controllerUpdate(i, type, state);
+    } else {
+      state.reset();
     }
 
     rumbleMask |= rumble ? 1U << i : 0;
   }
 
+  /* Pollers see the new state before any callback runs */
+  m_history.record(latest.m_time, ports);
+  m_latestState.publish();
+
+  {
+    std::lock_guard<std::mutex> lk(m_callbackLock);
+    if (m_callback) {
+      for (uint32_t i = 0; i < 4; i++) {
+        if ((connected & (1U << i)) != 0) {
+          m_callback->controllerConnected(i, ports.m_types[i]);
+        } else if ((disconnected & (1U << i)) != 0) {
+          m_callback->controllerDisconnected(i);
+        }
+        if ((m_knownControllers & (1U << i)) != 0) {
+          m_callback->controllerUpdate(i, ports.m_types[i], ports.m_states[i]);
+        }
+      }
+    }
+  }
+
   /* Send rumble message (if needed) */
   const uint8_t rumbleReq = m_rumbleRequest & rumbleMask;
   if (rumbleReq != m_rumbleState) {
@@ -115,6 +139,7 @@ void DolphinSmashAdapter::transferCycle() {
 void DolphinSmashAdapter::finalCycle() {
   constexpr std::array<uint8_t, 5> rumbleMessage{0x11, 0, 0, 0, 0};
   sendUSBInterruptTransfer(rumbleMessage.data(), sizeof(rumbleMessage));
+  m_latestState.publish({InputClock::now(), DolphinSmashAdapterState{}});
 }
 
 void DolphinSmashAdapter::deviceDisconnected() {
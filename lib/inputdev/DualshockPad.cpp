@@ -68,12 +68,15 @@ void DualshockPad::finalCycle() {
   m_report.rumble.rightDuration = 0;
   m_report.rumble.rightOn = false;
   sendHIDReport(m_report.buf, sizeof(m_report), HIDReportType::Output, 0x01);
+  m_latestState.publish({InputClock::now(), DualshockPadState{}});
 }
 
 void DualshockPad::receivedHIDReport(const uint8_t* data, size_t length, HIDReportType tp, uint32_t message) {
   if (message != 1 || length != 49 || tp != HIDReportType::Input)
     return;
-  DualshockPadState state = *reinterpret_cast<const DualshockPadState*>(data);
+  /* The state struct extends past the 49-byte report with fields computed below */
+  DualshockPadState state{};
+  memcpy(&state, data, length);
 
   for (int i = 0; i < 3; i++)
     state.m_accelerometer[i] = bswap16(state.m_accelerometer[i]);
@@ -86,6 +89,9 @@ void DualshockPad::receivedHIDReport(const uint8_t* data, size_t length, HIDRepo
   state.accPitch = (atan2(accYval, accZval) + M_PIF) * RAD_TO_DEG;
   state.accYaw = (atan2(accXval, accZval) + M_PIF) * RAD_TO_DEG;
   state.gyroZ = (state.m_gyrometerZ / 1023.f);
+  const InputClock::time_point time = reportTime();
+  m_history.record(time, state);
+  m_latestState.publish({time, state});
 
   {
     std::lock_guard<std::mutex> lk(m_callbackLock);
@@ -0,0 +1,103 @@
+#include "boo/inputdev/EvdevPad.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "boo/inputdev/DeviceSignature.hpp"
+
+#undef min
+#undef max
+
+namespace boo {
+namespace {
+/* From linux/input-event-codes.h; this class also builds where that header doesn't exist */
+constexpr uint16_t EvKey = 0x01;
+constexpr uint16_t EvAbs = 0x03;
+constexpr uint16_t BtnJoystick = 0x120;
+constexpr uint16_t BtnDPadUp = 0x220;
+
+void ApplyEvent(EvdevPadState& state, const EvdevEvent& ev) {
+  if (ev.m_type == EvKey) {
+    uint64_t bit;
+    if (ev.m_code >= BtnJoystick && ev.m_code < BtnJoystick + 32)
+      bit = uint64_t(1) << (ev.m_code - BtnJoystick);
+    else if (ev.m_code >= BtnDPadUp && ev.m_code < BtnDPadUp + 4)
+      bit = uint64_t(1) << (ev.m_code - BtnDPadUp + 32);
+    else
+      return;
+    /* Autorepeat (2) leaves the key held */
+    if (ev.m_value)
+      state.m_buttons |= EEvdevPadButtons(bit);
+    else
+      state.m_buttons &= ~EEvdevPadButtons(bit);
+  } else if (ev.m_type == EvAbs && ev.m_code < size_t(EEvdevPadAxis::Count)) {
+    state.m_axes[ev.m_code] = ev.m_value;
+  }
+}
+} // Anonymous namespace
+
+EvdevPad::EvdevPad(DeviceToken* token) : TDeviceBase<IEvdevPadCallback>(dev_typeid(EvdevPad), token) {}
+
+EvdevPad::~EvdevPad() = default;
+
+void EvdevPad::deviceDisconnected() {
+  std::lock_guard lk{m_callbackLock};
+  if (m_callback != nullptr) {
+    m_callback->controllerDisconnected();
+  }
+}
+
+void EvdevPad::initialCycle() {
+  for (size_t i = 0; i < m_axisInfo.size(); ++i) {
+    EvdevAxisInfo info{};
+    if (receiveHIDReport(reinterpret_cast<uint8_t*>(&info), sizeof(info), HIDReportType::Feature, uint32_t(i)) ==
+        sizeof(info))
+      m_axisInfo[i] = info;
+  }
+
+  std::lock_guard lk{m_callbackLock};
+  if (m_callback != nullptr) {
+    m_callback->controllerConnected();
+  }
+}
+
+void EvdevPad::finalCycle() { m_latestState.publish({InputClock::now(), EvdevPadState{}}); }
+
+void EvdevPad::receivedHIDReport(const uint8_t* data, size_t length, HIDReportType tp, uint32_t message) {
+  if (tp != HIDReportType::Input) {
+    return;
+  }
+
+  /* The whole frame lands before anyone sees it, so a stick never reads one new and one old coordinate */
+  EvdevPadState state = m_last;
+  for (size_t off = 0; off + sizeof(EvdevEvent) <= length; off += sizeof(EvdevEvent)) {
+    EvdevEvent ev;
+    std::memcpy(&ev, data + off, sizeof(ev));
+    ApplyEvent(state, ev);
+  }
+
+  const InputClock::time_point time = reportTime();
+  m_history.record(time, state);
+  if (state == m_last) {
+    return;
+  }
+  m_last = state;
+  m_latestState.publish({time, state});
+
+  std::lock_guard lk{m_callbackLock};
+  if (m_callback != nullptr) {
+    m_callback->controllerUpdate(*this, state);
+  }
+}
+
+float EvdevPad::normalizedAxis(const EvdevPadState& state, EEvdevPadAxis axis) const {
+  const EvdevAxisInfo& info = m_axisInfo[size_t(axis)];
+  if (info.m_maximum <= info.m_minimum) {
+    return 0.f;
+  }
+  const float range = float(int64_t(info.m_maximum) - info.m_minimum);
+  const float val = float(int64_t(std::clamp(state.axis(axis), info.m_minimum, info.m_maximum)) - info.m_minimum);
+  return val / range * 2.f - 1.f;
+}
+
+} // namespace boo
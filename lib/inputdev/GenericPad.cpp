@@ -1,6 +1,12 @@
 #include "boo/inputdev/GenericPad.hpp"
 #include "boo/inputdev/DeviceToken.hpp"
 
+#include <algorithm>
+#include <bit>
+
+#undef min
+#undef max
+
 namespace boo {
 
 GenericPad::GenericPad(DeviceToken* token) : TDeviceBase<IGenericPadCallback>(dev_typeid(GenericPad), token) {}
@@ -23,20 +29,57 @@ void GenericPad::initialCycle() {
   std::vector<uint8_t> reportDesc = getReportDescriptor();
   m_parser.Parse(reportDesc.data(), reportDesc.size());
 #endif
+  const size_t count = m_parser.GetValueCount();
+  m_values.assign(count, 0);
+  m_decoded.assign(count, 0);
+  m_received.assign((count + 63) / 64, 0);
+  m_changed.assign((count + 63) / 64, 0);
+  m_latestState.publish({InputClock::now(), m_values});
+
   std::lock_guard<std::mutex> lk(m_callbackLock);
   if (m_callback)
     m_callback->controllerConnected();
 }
 
 void GenericPad::receivedHIDReport(const uint8_t* data, size_t length, HIDReportType tp, uint32_t message) {
+  if (length == 0 || tp != HIDReportType::Input)
+    return;
+
+  bool changed = false;
+  const auto range = m_parser.DecodeValues(data, length, m_decoded.data());
+  if (range.first == range.second)
+    return;
+  std::fill(m_changed.begin(), m_changed.end(), 0);
+  for (uint32_t i = range.first; i < range.second; ++i) {
+    const uint64_t bit = uint64_t(1) << (i % 64);
+    if (m_decoded[i] == m_values[i] && (m_received[i / 64] & bit))
+      continue;
+    m_values[i] = m_decoded[i];
+    m_received[i / 64] |= bit;
+    m_changed[i / 64] |= bit;
+    changed = true;
+  }
+  const InputClock::time_point time = reportTime();
+  m_history.record(time, m_values);
+  if (!changed)
+    return;
+  TimedState<std::vector<int32_t>>& latest = m_latestState.back();
+  latest.m_time = time;
+  latest.m_state = m_values;
+  m_latestState.publish();
+
   std::lock_guard<std::mutex> lk(m_callbackLock);
-  if (length == 0 || tp != HIDReportType::Input || !m_callback)
+  if (!m_callback)
     return;
-  std::function<bool(const HIDMainItem&, int32_t)> func = [this](const HIDMainItem& item, int32_t value) {
-    m_callback->valueUpdate(item, value);
-    return true;
-  };
-  m_parser.ScanValues(func, data, length);
+  if (!m_batchedUpdates) {
+    for (size_t w = 0; w < m_changed.size(); ++w) {
+      for (uint64_t bits = m_changed[w]; bits; bits &= bits - 1) {
+        const size_t slot = w * 64 + std::countr_zero(bits);
+        m_callback->valueUpdate(m_parser.GetValueItem(slot), m_values[slot]);
+      }
+    }
+  }
+  m_callback->valuesChanged(m_changed, m_values);
 }
 
 void GenericPad::enumerateValues(const std::function<bool(const HIDMainItem& item)>& valueCB) const {
@@ -0,0 +1,199 @@
+#include "lib/inputdev/HIDCapture.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+
+#include "boo/inputdev/DeviceToken.hpp"
+
+#include <logvisor/logvisor.hpp>
+
+#undef min
+#undef max
+
+namespace boo {
+namespace {
+logvisor::Module Log("boo::HIDCapture");
+
+constexpr std::array<uint8_t, 4> CaptureMagic{'B', 'H', 'C', '1'};
+
+std::mutex CaptureDirLock;
+std::string CaptureDir;
+unsigned CaptureCount = 0;
+
+class CaptureReader {
+  const uint8_t* m_cur;
+  const uint8_t* m_end;
+
+public:
+  bool m_error = false;
+
+  CaptureReader(const uint8_t* data, size_t len) : m_cur(data), m_end(data + len) {}
+
+  bool atEnd() const { return m_cur == m_end; }
+  size_t position(const uint8_t* base) const { return m_cur - base; }
+
+  uint64_t varint() {
+    uint64_t val = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      if (m_cur == m_end) {
+        m_error = true;
+        return 0;
+      }
+      const uint8_t byte = *m_cur++;
+      val |= uint64_t(byte & 0x7f) << shift;
+      if (!(byte & 0x80))
+        return val;
+    }
+    m_error = true;
+    return 0;
+  }
+
+  uint8_t byte() {
+    if (m_cur == m_end) {
+      m_error = true;
+      return 0;
+    }
+    return *m_cur++;
+  }
+
+  const uint8_t* skip(size_t len) {
+    if (size_t(m_end - m_cur) < len) {
+      m_error = true;
+      m_cur = m_end;
+      return nullptr;
+    }
+    const uint8_t* ret = m_cur;
+    m_cur += len;
+    return ret;
+  }
+
+  std::string string() {
+    const size_t len = varint();
+    const uint8_t* str = skip(len);
+    return str ? std::string(reinterpret_cast<const char*>(str), len) : std::string();
+  }
+};
+} // Anonymous namespace
+
+void SetHIDCaptureDirectory(std::string_view dir) {
+  std::lock_guard lk(CaptureDirLock);
+  CaptureDir = dir;
+}
+
+HIDCaptureWriter::HIDCaptureWriter(FILE* file) : m_file(file), m_lastTime(InputClock::now()) {}
+
+HIDCaptureWriter::~HIDCaptureWriter() { std::fclose(m_file); }
+
+std::unique_ptr<HIDCaptureWriter> HIDCaptureWriter::Open(const DeviceToken& token) {
+  std::string path;
+  {
+    std::lock_guard lk(CaptureDirLock);
+    if (CaptureDir.empty())
+      return {};
+    path = fmt::format(FMT_STRING("{}/{:04x}-{:04x}-{}.bhc"), CaptureDir, token.getVendorId(),
+                       token.getProductId(), CaptureCount++);
+  }
+
+  FILE* file = std::fopen(path.c_str(), "wb");
+  if (!file) {
+    Log.report(logvisor::Error, FMT_STRING("unable to create capture '{}': {}"), path, strerror(errno));
+    return {};
+  }
+
+  auto writer = std::make_unique<HIDCaptureWriter>(file);
+  std::fwrite(CaptureMagic.data(), 1, CaptureMagic.size(), file);
+  writer->_writeVarint(uint64_t(token.getDeviceType()));
+  writer->_writeVarint(token.getVendorId());
+  writer->_writeVarint(token.getProductId());
+  for (std::string_view str : {token.getVendorName(), token.getProductName()}) {
+    writer->_writeVarint(str.size());
+    std::fwrite(str.data(), 1, str.size(), file);
+  }
+  Log.report(logvisor::Info, FMT_STRING("recording {} to '{}'"), token.getProductName(), path);
+  return writer;
+}
+
+void HIDCaptureWriter::_writeVarint(uint64_t val) {
+  uint8_t buf[10];
+  size_t len = 0;
+  do {
+    buf[len] = uint8_t(val & 0x7f);
+    val >>= 7;
+    if (val)
+      buf[len] |= 0x80;
+    ++len;
+  } while (val);
+  std::fwrite(buf, 1, len, m_file);
+}
+
+void HIDCaptureWriter::write(HIDCaptureRecord kind, InputClock::time_point time, const uint8_t* data, size_t length,
+                             HIDReportType tp, uint32_t message) {
+  std::lock_guard lk(m_lock);
+  /* Records from different threads may be stamped slightly out of order */
+  const auto delta = std::chrono::duration_cast<std::chrono::microseconds>(time - m_lastTime).count();
+  m_lastTime = std::max(m_lastTime, time);
+  std::fputc(int(kind), m_file);
+  _writeVarint(uint64_t(std::max<int64_t>(0, delta)));
+  _writeVarint(uint64_t(tp));
+  _writeVarint(message);
+  _writeVarint(length);
+  if (length)
+    std::fwrite(data, 1, length, m_file);
+}
+
+bool HIDCapture::load(const char* path) {
+  FILE* file = std::fopen(path, "rb");
+  if (!file) {
+    Log.report(logvisor::Error, FMT_STRING("unable to open capture '{}'"), path);
+    return false;
+  }
+  std::vector<uint8_t> buf;
+  std::array<uint8_t, 65536> chunk;
+  while (const size_t len = std::fread(chunk.data(), 1, chunk.size(), file))
+    buf.insert(buf.end(), chunk.begin(), chunk.begin() + len);
+  std::fclose(file);
+
+  if (buf.size() < CaptureMagic.size() || !std::equal(CaptureMagic.begin(), CaptureMagic.end(), buf.begin())) {
+    Log.report(logvisor::Error, FMT_STRING("'{}' is not a HID capture"), path);
+    return false;
+  }
+
+  CaptureReader reader(buf.data() + CaptureMagic.size(), buf.size() - CaptureMagic.size());
+  m_type = DeviceType(reader.varint());
+  m_vid = unsigned(reader.varint());
+  m_pid = unsigned(reader.varint());
+  m_vendorName = reader.string();
+  m_productName = reader.string();
+  if (reader.m_error) {
+    Log.report(logvisor::Error, FMT_STRING("'{}' has a truncated header"), path);
+    return false;
+  }
+
+  /* Payloads stay in the file image */
+  m_events.clear();
+  uint64_t timeUs = 0;
+  while (!reader.atEnd() && !reader.m_error) {
+    Event ev;
+    ev.m_kind = HIDCaptureRecord(reader.byte());
+    timeUs += reader.varint();
+    ev.m_timeUs = timeUs;
+    ev.m_reportType = HIDReportType(reader.varint());
+    ev.m_message = uint32_t(reader.varint());
+    ev.m_length = reader.varint();
+    ev.m_offset = reader.position(buf.data());
+    if (!reader.skip(ev.m_length))
+      break;
+    m_events.push_back(ev);
+  }
+
+  /* A capture cut short by a crash still replays up to its last whole record */
+  if (reader.m_error)
+    Log.report(logvisor::Warning, FMT_STRING("'{}' is truncated after {} records"), path, m_events.size());
+
+  m_data = std::move(buf);
+  return true;
+}
+
+} // namespace boo
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "boo/inputdev/DeviceBase.hpp"
+#include "boo/inputdev/DeviceSignature.hpp"
+#include "boo/inputdev/HIDCapture.hpp"
+
+namespace boo {
+class DeviceToken;
+
+/* Capture file (.bhc): the magic "BHC1", a header of device type, VID, PID, vendor and product name,
+ * then records until end of file. Each record is a kind byte followed by the microseconds since the
+ * previous record, report type, message and payload length (all LEB128 varints) and the payload */
+enum class HIDCaptureRecord : uint8_t {
+  Descriptor = 1,  /* Report descriptor as returned to the device class */
+  Report = 2,      /* Input report passed to receivedHIDReport */
+  USBTransfer = 3, /* Completed interrupt IN transfer handed to transferCycle */
+  Feature = 4,     /* Result of a feature report read */
+  Disconnect = 5,
+};
+
+/** Tees one open device's traffic into a capture file; safe to call from any thread */
+class HIDCaptureWriter {
+  std::mutex m_lock;
+  FILE* m_file;
+  InputClock::time_point m_lastTime;
+
+  void _writeVarint(uint64_t val);
+
+public:
+  explicit HIDCaptureWriter(FILE* file);
+  ~HIDCaptureWriter();
+
+  /** New capture for token in the directory set by SetHIDCaptureDirectory, or null when not recording */
+  static std::unique_ptr<HIDCaptureWriter> Open(const DeviceToken& token);
+
+  void write(HIDCaptureRecord kind, InputClock::time_point time, const uint8_t* data, size_t length,
+             HIDReportType tp = HIDReportType::Input, uint32_t message = 0);
+};
+
+/** Device path prefix of tokens that replay a capture file instead of opening hardware */
+constexpr std::string_view ReplayPathPrefix = "replay:";
+
+void RegisterHIDReplay(std::string_view tokenPath, const HIDReplayOptions& options);
+void UnregisterHIDReplay(std::string_view tokenPath);
+
+/** Capture file loaded into memory for replay */
+struct HIDCapture {
+  struct Event {
+    HIDCaptureRecord m_kind;
+    HIDReportType m_reportType;
+    uint32_t m_message;
+    uint64_t m_timeUs; /* From the first record */
+    size_t m_offset;   /* Payload position in m_data */
+    size_t m_length;
+  };
+
+  DeviceType m_type = DeviceType::None;
+  unsigned m_vid = 0;
+  unsigned m_pid = 0;
+  std::string m_vendorName;
+  std::string m_productName;
+  std::vector<Event> m_events;
+  std::vector<uint8_t> m_data;
+
+  /** Read the capture at path; returns false (and logs) if it is missing or malformed */
+  bool load(const char* path);
+
+  const uint8_t* payload(const Event& ev) const { return m_data.data() + ev.m_offset; }
+};
+
+} // namespace boo
@@ -0,0 +1,200 @@
+#include "lib/inputdev/IHIDDevice.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include "boo/inputdev/DeviceToken.hpp"
+#include "lib/inputdev/HIDCapture.hpp"
+
+#include <logvisor/logvisor.hpp>
+
+#undef min
+#undef max
+
+namespace boo {
+namespace {
+std::mutex ReplayOptionsLock;
+std::unordered_map<std::string, HIDReplayOptions> ReplayOptions;
+} // Anonymous namespace
+
+void RegisterHIDReplay(std::string_view tokenPath, const HIDReplayOptions& options) {
+  std::lock_guard lk(ReplayOptionsLock);
+  ReplayOptions[std::string(tokenPath)] = options;
+}
+
+void UnregisterHIDReplay(std::string_view tokenPath) {
+  std::lock_guard lk(ReplayOptionsLock);
+  ReplayOptions.erase(std::string(tokenPath));
+}
+
+/** Feeds a recorded capture through the device class on its own thread, as the platform backend
+ *  would have delivered it. Output reports and transfers are accepted and discarded */
+class HIDDeviceReplay final : public IHIDDevice {
+  std::shared_ptr<DeviceBase> m_devImp;
+  HIDCapture m_capture;
+  HIDReplayOptions m_options;
+
+  std::thread m_thread;
+  std::mutex m_stopLock;
+  std::condition_variable m_stopCond;
+  std::atomic_bool m_stop{false};
+  /* Pairs finalCycle with initialCycle whether the device is closed from outside or its own callback */
+  std::atomic_bool m_cycling{false};
+
+  /* Transfer being handed to transferCycle; replay thread only */
+  const HIDCapture::Event* m_pendingTransfer = nullptr;
+
+  /* Latest recorded feature report per report ID */
+  std::mutex m_featureLock;
+  std::unordered_map<uint32_t, const HIDCapture::Event*> m_features;
+
+  bool _waitUntil(InputClock::time_point time) {
+    std::unique_lock lk(m_stopLock);
+    return !m_stopCond.wait_until(lk, time, [this]() { return m_stop.load(); });
+  }
+
+  void _dispatch(const HIDCapture::Event& ev) {
+    switch (ev.m_kind) {
+    case HIDCaptureRecord::Report:
+      _stampReport(*m_devImp, InputClock::now());
+      m_devImp->receivedHIDReport(m_capture.payload(ev), ev.m_length, ev.m_reportType, ev.m_message);
+      break;
+    case HIDCaptureRecord::USBTransfer:
+      _stampReport(*m_devImp, InputClock::now());
+      m_pendingTransfer = &ev;
+      m_devImp->transferCycle();
+      m_pendingTransfer = nullptr;
+      break;
+    case HIDCaptureRecord::Feature: {
+      std::lock_guard lk(m_featureLock);
+      m_features[ev.m_message] = &ev;
+      break;
+    }
+    default:
+      break;
+    }
+  }
+
+  void _run() {
+    logvisor::RegisterThreadName("Boo Replay");
+    m_cycling = true;
+    m_devImp->initialCycle();
+    do {
+      const InputClock::time_point start = InputClock::now();
+      for (const HIDCapture::Event& ev : m_capture.m_events) {
+        /* The recorded unplug only ends the pass; the device stays open until it is closed or removed */
+        if (ev.m_kind == HIDCaptureRecord::Disconnect)
+          break;
+        if (m_options.m_speed > 0.0) {
+          const auto offset = std::chrono::duration<double, std::micro>(ev.m_timeUs / m_options.m_speed);
+          if (!_waitUntil(start + std::chrono::duration_cast<InputClock::duration>(offset)))
+            return;
+        } else if (m_stop) {
+          return;
+        }
+        _dispatch(ev);
+      }
+    } while (m_options.m_loop && !m_stop);
+  }
+
+  void _deviceDisconnected() override {
+    {
+      std::lock_guard lk(m_stopLock);
+      m_stop = true;
+    }
+    m_stopCond.notify_all();
+    if (m_thread.joinable()) {
+      /* Closed from a callback on the replay thread, which returns once the callback does */
+      if (m_thread.get_id() == std::this_thread::get_id())
+        m_thread.detach();
+      else
+        m_thread.join();
+    }
+    if (m_cycling.exchange(false))
+      m_devImp->finalCycle();
+  }
+
+  bool _sendUSBInterruptTransfer(const uint8_t* data, size_t length) override { return true; }
+
+  size_t _receiveUSBInterruptTransfer(uint8_t* data, size_t length) override {
+    if (!m_pendingTransfer)
+      return 0;
+    const size_t count = std::min(length, m_pendingTransfer->m_length);
+    std::memcpy(data, m_capture.payload(*m_pendingTransfer), count);
+    m_pendingTransfer = nullptr;
+    return count;
+  }
+
+#if _WIN32
+#if !WINDOWS_STORE
+  /* Preparsed data can't be reconstructed from a captured descriptor */
+  const PHIDP_PREPARSED_DATA _getReportDescriptor() override { return nullptr; }
+#endif
+#else
+  std::vector<uint8_t> _getReportDescriptor() override {
+    for (const HIDCapture::Event& ev : m_capture.m_events) {
+      if (ev.m_kind == HIDCaptureRecord::Descriptor)
+        return {m_capture.payload(ev), m_capture.payload(ev) + ev.m_length};
+    }
+    return {};
+  }
+#endif
+
+  bool _sendHIDReport(const uint8_t* data, size_t length, HIDReportType tp, uint32_t message) override { return true; }
+
+  size_t _receiveHIDReport(uint8_t* data, size_t length, HIDReportType tp, uint32_t message) override {
+    if (tp != HIDReportType::Feature)
+      return 0;
+    std::lock_guard lk(m_featureLock);
+    const auto search = m_features.find(message);
+    if (search == m_features.end())
+      return 0;
+    const size_t count = std::min(length, search->second->m_length);
+    std::memcpy(data, m_capture.payload(*search->second), count);
+    return count;
+  }
+
+  void _startThread() override {
+    m_thread = std::thread([self = std::static_pointer_cast<HIDDeviceReplay>(shared_from_this())]() { self->_run(); });
+  }
+
+public:
+  HIDDeviceReplay(HIDCapture&& capture, const HIDReplayOptions& options, const std::shared_ptr<DeviceBase>& devImp)
+  : m_devImp(devImp), m_capture(std::move(capture)), m_options(options) {
+    /* Feature reads recorded before the first input report answer queries made during initialCycle */
+    for (const HIDCapture::Event& ev : m_capture.m_events) {
+      if (ev.m_kind == HIDCaptureRecord::Report || ev.m_kind == HIDCaptureRecord::USBTransfer)
+        break;
+      if (ev.m_kind == HIDCaptureRecord::Feature)
+        m_features[ev.m_message] = &ev;
+    }
+  }
+
+  ~HIDDeviceReplay() override {
+    if (m_thread.joinable())
+      m_thread.detach();
+  }
+};
+
+std::shared_ptr<IHIDDevice> IHIDDeviceReplayNew(DeviceToken& token, const std::shared_ptr<DeviceBase>& devImp) {
+  HIDReplayOptions options;
+  {
+    std::lock_guard lk(ReplayOptionsLock);
+    const auto search = ReplayOptions.find(std::string(token.getDevicePath()));
+    if (search != ReplayOptions.end())
+      options = search->second;
+  }
+
+  HIDCapture capture;
+  if (!capture.load(std::string(token.getDevicePath().substr(ReplayPathPrefix.size())).c_str()))
+    return {};
+  return std::make_shared<HIDDeviceReplay>(std::move(capture), options, devImp);
+}
+
+} // namespace boo
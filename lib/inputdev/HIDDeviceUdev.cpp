@@ -1,14 +1,21 @@
 #include "lib/inputdev/IHIDDevice.hpp"
 
-#include <condition_variable>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
 #include <cstdio>
 #include <cstring>
 #include <mutex>
-#include <thread>
+#include <vector>
 
 #include "boo/inputdev/DeviceToken.hpp"
 #include "boo/inputdev/DeviceBase.hpp"
+#include "boo/inputdev/EvdevPad.hpp"
 #include "boo/inputdev/HIDParser.hpp"
+#include "lib/inputdev/HIDCapture.hpp"
+#include "lib/inputdev/InputReactorUdev.hpp"
 
 #include <fcntl.h>
 #include <libudev.h>
@@ -16,6 +23,7 @@
 #include <linux/usbdevice_fs.h>
 #include <linux/input.h>
 #include <linux/hidraw.h>
+#include <sys/epoll.h>
 #include <sys/ioctl.h>
 #include <unistd.h>
 
@@ -27,56 +35,124 @@ udev* GetUdev();
  * Reference: http://tali.admingilde.org/linux-docbook/usb/ch07s06.html
  */
 
-class HIDDeviceUdev final : public IHIDDevice {
+/* hidraw reports and usbdevfs URB completions are dispatched as they arrive;
+ * transferCycle runs on these schedules for HID and Bluetooth devices */
+constexpr std::chrono::milliseconds HIDCyclePeriod{10};
+constexpr std::chrono::milliseconds BTCyclePeriod{1};
+
+/* Events taken from an evdev node per read */
+constexpr size_t EvdevReadEvents = 64;
+static_assert(sizeof(EvdevAxisInfo) == sizeof(input_absinfo), "EvdevAxisInfo must mirror input_absinfo");
+
+class HIDDeviceUdev final : public IHIDDevice, public InputReactor::Source {
   DeviceToken& m_token;
   std::shared_ptr<DeviceBase> m_devImp;
 
   int m_devFd = 0;
   unsigned m_usbIntfInPipe = 0;
   unsigned m_usbIntfOutPipe = 0;
-  bool m_runningTransferLoop = false;
+
+  /* Every device is serviced by the shared input reactor. m_reactorId clears once detached,
+   * which may happen on the reactor thread (hang-up) before the listener reports the disconnect;
+   * m_cycling pairs finalCycle with initialCycle regardless of who detached */
+  std::atomic<uint64_t> m_reactorId{0};
+  std::atomic_bool m_cycling{false};
+  udev_device* m_udevDev = nullptr;
+  std::unique_ptr<uint8_t[]> m_readBuf;
+  size_t m_readSz = 0;
+
+  /* usbdevfs interrupt transfers are asynchronous URBs reaped when the descriptor polls writable.
+   * Several IN URBs stay queued so the host polls the device every interval; transferCycle runs
+   * once per completed IN transfer and receives its payload */
+  static constexpr size_t USBInTransfers = 4;
+  static constexpr size_t USBOutTransfers = 4;
+  static constexpr size_t USBTransferSize = 64;
+  /* Consecutive failed IN completions (stalls, protocol errors) before the IN URBs are left unqueued */
+  static constexpr unsigned USBInErrorLimit = 16;
+  struct USBTransfer {
+    uint8_t m_buf[USBTransferSize];
+    bool m_busy = false;
+    usbdevfs_urb m_urb; /* Ends in an (unused) flexible array */
+  };
+  std::unique_ptr<USBTransfer[]> m_usbIn;
+  std::unique_ptr<USBTransfer[]> m_usbOut;
+  std::mutex m_usbOutLock;
+  const USBTransfer* m_usbCompleted = nullptr;
+  unsigned m_usbInErrors = 0;
+
+  /* Evdev events are gathered into m_evdevFrame and delivered as one report at each SYN_REPORT.
+   * After SYN_DROPPED the partial frame is discarded and the next one rebuilt from the device state */
+  std::vector<EvdevEvent> m_evdevFrame;
+  std::vector<uint16_t> m_evdevKeys;
+  std::vector<uint16_t> m_evdevAxes;
+  bool m_evdevDropped = false;
+  bool m_evdevMonotonic = false;
 
   std::string_view m_devPath;
-  std::mutex m_initMutex;
-  std::condition_variable m_initCond;
-  std::thread m_thread;
+
+  /* Raw traffic tee, when SetHIDCaptureDirectory was active at open */
+  std::unique_ptr<HIDCaptureWriter> m_capture;
+
+  bool _submitURB(USBTransfer& xfer, unsigned endpoint, size_t length) {
+    std::memset(&xfer.m_urb, 0, sizeof(xfer.m_urb));
+    xfer.m_urb.type = USBDEVFS_URB_TYPE_INTERRUPT;
+    xfer.m_urb.endpoint = endpoint;
+    xfer.m_urb.buffer = xfer.m_buf;
+    xfer.m_urb.buffer_length = int(length);
+    xfer.m_urb.usercontext = &xfer;
+    return ioctl(m_devFd, USBDEVFS_SUBMITURB, &xfer.m_urb) == 0;
+  }
 
   bool _sendUSBInterruptTransfer(const uint8_t* data, size_t length) override {
-    if (m_devFd) {
-      usbdevfs_bulktransfer xfer = {m_usbIntfOutPipe | USB_DIR_OUT, (unsigned)length, 30, (void*)data};
-      int ret = ioctl(m_devFd, USBDEVFS_BULK, &xfer);
-      if (ret != (int)length)
-        return false;
-      return true;
+    if (!m_devFd)
+      return false;
+
+    if (m_reactorId && length <= USBTransferSize) {
+      std::lock_guard lk(m_usbOutLock);
+      for (size_t i = 0; i < USBOutTransfers; ++i) {
+        USBTransfer& xfer = m_usbOut[i];
+        if (xfer.m_busy)
+          continue;
+        std::memcpy(xfer.m_buf, data, length);
+        xfer.m_busy = _submitURB(xfer, m_usbIntfOutPipe | USB_DIR_OUT, length);
+        return xfer.m_busy;
+      }
     }
-    return false;
+
+    /* Detached from the reactor (finalCycle) or every OUT URB is still in flight */
+    usbdevfs_bulktransfer xfer = {m_usbIntfOutPipe | USB_DIR_OUT, (unsigned)length, 30, (void*)data};
+    int ret = ioctl(m_devFd, USBDEVFS_BULK, &xfer);
+    if (ret != (int)length)
+      return false;
+    return true;
   }
 
   size_t _receiveUSBInterruptTransfer(uint8_t* data, size_t length) override {
-    if (m_devFd) {
+    if (!m_usbCompleted) {
+      /* Outside a completion (initialCycle, finalCycle or another thread); queued IN URBs are served first */
+      if (!m_devFd)
+        return 0;
       usbdevfs_bulktransfer xfer = {m_usbIntfInPipe | USB_DIR_IN, (unsigned)length, 30, data};
-      return ioctl(m_devFd, USBDEVFS_BULK, &xfer);
+      const int ret = ioctl(m_devFd, USBDEVFS_BULK, &xfer);
+      return ret > 0 ? size_t(ret) : 0;
     }
-    return 0;
+    const size_t count = std::min(length, size_t(m_usbCompleted->m_urb.actual_length));
+    std::memcpy(data, m_usbCompleted->m_buf, count);
+    m_usbCompleted = nullptr;
+    return count;
   }
 
-  static void _threadProcUSBLL(std::shared_ptr<HIDDeviceUdev> device) {
-    int i;
-    std::unique_lock<std::mutex> lk(device->m_initMutex);
-    udev_device* udevDev = udev_device_new_from_syspath(GetUdev(), device->m_devPath.data());
+  bool _openUSB() {
+    m_udevDev = udev_device_new_from_syspath(GetUdev(), m_devPath.data());
 
     /* Get device file */
-    const char* dp = udev_device_get_devnode(udevDev);
-    int fd = open(dp, O_RDWR);
+    const char* dp = udev_device_get_devnode(m_udevDev);
+    int fd = open(dp, O_RDWR | O_NONBLOCK | O_CLOEXEC);
     if (fd < 0) {
-      device->m_devImp->deviceError(FMT_STRING("Unable to open {}@{}: {}\n"),
-        device->m_token.getProductName(), dp, strerror(errno));
-      lk.unlock();
-      device->m_initCond.notify_one();
-      udev_device_unref(udevDev);
-      return;
+      m_devImp->deviceError(FMT_STRING("Unable to open {}@{}: {}\n"), m_token.getProductName(), dp, strerror(errno));
+      return false;
     }
-    device->m_devFd = fd;
+    m_devFd = fd;
     usb_device_descriptor devDesc = {};
     read(fd, &devDesc, 1);
     read(fd, &devDesc.bDescriptorType, devDesc.bLength - 1);
@@ -88,15 +164,15 @@ class HIDDeviceUdev final : public IHIDDevice {
         usb_interface_descriptor intfDesc = {};
         read(fd, &intfDesc, 1);
         read(fd, &intfDesc.bDescriptorType, intfDesc.bLength - 1);
-        for (i = 0; i < intfDesc.bNumEndpoints + 1; ++i) {
+        for (int i = 0; i < intfDesc.bNumEndpoints + 1; ++i) {
           usb_endpoint_descriptor endpDesc = {};
           read(fd, &endpDesc, 1);
           read(fd, &endpDesc.bDescriptorType, endpDesc.bLength - 1);
           if ((endpDesc.bmAttributes & USB_ENDPOINT_XFERTYPE_MASK) == USB_ENDPOINT_XFER_INT) {
             if ((endpDesc.bEndpointAddress & USB_ENDPOINT_DIR_MASK) == USB_DIR_IN)
-              device->m_usbIntfInPipe = endpDesc.bEndpointAddress & USB_ENDPOINT_NUMBER_MASK;
+              m_usbIntfInPipe = endpDesc.bEndpointAddress & USB_ENDPOINT_NUMBER_MASK;
             else if ((endpDesc.bEndpointAddress & USB_ENDPOINT_DIR_MASK) == USB_DIR_OUT)
-              device->m_usbIntfOutPipe = endpDesc.bEndpointAddress & USB_ENDPOINT_NUMBER_MASK;
+              m_usbIntfOutPipe = endpDesc.bEndpointAddress & USB_ENDPOINT_NUMBER_MASK;
           }
         }
       }
@@ -106,111 +182,261 @@ class HIDDeviceUdev final : public IHIDDevice {
     usbdevfs_ioctl disconnectReq = {0, USBDEVFS_DISCONNECT, nullptr};
     ioctl(fd, USBDEVFS_IOCTL, &disconnectReq);
 
-    /* Return control to main thread */
-    device->m_runningTransferLoop = true;
-    lk.unlock();
-    device->m_initCond.notify_one();
-
-    /* Start transfer loop */
-    device->m_devImp->initialCycle();
-    while (device->m_runningTransferLoop)
-      device->m_devImp->transferCycle();
-    device->m_devImp->finalCycle();
-
-    /* Cleanup */
-    close(fd);
-    device->m_devFd = 0;
-    udev_device_unref(udevDev);
+    m_usbIn.reset(new USBTransfer[USBInTransfers]);
+    m_usbOut.reset(new USBTransfer[USBOutTransfers]);
+    return true;
   }
 
-  static void _threadProcBTLL(std::shared_ptr<HIDDeviceUdev> device) {
-    std::unique_lock<std::mutex> lk(device->m_initMutex);
-    udev_device* udevDev = udev_device_new_from_syspath(GetUdev(), device->m_devPath.data());
+  void _submitUSBIn(USBTransfer& xfer) {
+    xfer.m_busy = _submitURB(xfer, m_usbIntfInPipe | USB_DIR_IN, USBTransferSize);
+  }
 
-    /* Return control to main thread */
-    device->m_runningTransferLoop = true;
-    lk.unlock();
-    device->m_initCond.notify_one();
+  void _reapUSB() {
+    usbdevfs_urb* urb;
+    while (ioctl(m_devFd, USBDEVFS_REAPURBNDELAY, &urb) == 0) {
+      USBTransfer& xfer = *static_cast<USBTransfer*>(urb->usercontext);
+      if (!(urb->endpoint & USB_DIR_IN)) {
+        std::lock_guard lk(m_usbOutLock);
+        xfer.m_busy = false;
+        continue;
+      }
 
-    /* Start transfer loop */
-    device->m_devImp->initialCycle();
-    while (device->m_runningTransferLoop)
-      device->m_devImp->transferCycle();
-    device->m_devImp->finalCycle();
+      xfer.m_busy = false;
+      if (urb->status == 0) {
+        m_usbInErrors = 0;
+        const InputClock::time_point now = InputClock::now();
+        _stampReport(*m_devImp, now);
+        if (m_capture)
+          m_capture->write(HIDCaptureRecord::USBTransfer, now, xfer.m_buf, size_t(urb->actual_length));
+        m_usbCompleted = &xfer;
+        m_devImp->transferCycle();
+        m_usbCompleted = nullptr;
+        if (!m_reactorId)
+          return; /* Closed from a callback */
+      }
 
-    udev_device_unref(udevDev);
+      /* Requeue unless the URB was killed or the device went away */
+      if (urb->status == -ENOENT || urb->status == -ECONNRESET || urb->status == -ESHUTDOWN ||
+          urb->status == -ENODEV)
+        continue;
+
+      /* An endpoint that keeps failing would otherwise be resubmitted forever */
+      if (urb->status != 0 && ++m_usbInErrors >= USBInErrorLimit) {
+        if (m_usbInErrors == USBInErrorLimit)
+          m_devImp->deviceError(FMT_STRING("Stopped polling {}@{}: {}\n"), m_token.getProductName(), m_devPath,
+                                strerror(-urb->status));
+        continue;
+      }
+      _submitUSBIn(xfer);
+    }
   }
 
-  static void _threadProcHID(std::shared_ptr<HIDDeviceUdev> device) {
-    std::unique_lock<std::mutex> lk(device->m_initMutex);
-    udev_device* udevDev = udev_device_new_from_syspath(GetUdev(), device->m_devPath.data());
+  bool _openHID() {
+    m_udevDev = udev_device_new_from_syspath(GetUdev(), m_devPath.data());
 
     /* Get device file */
-    const char* dp = udev_device_get_devnode(udevDev);
-    int fd = open(dp, O_RDWR | O_NONBLOCK);
+    const char* dp = udev_device_get_devnode(m_udevDev);
+    int fd = open(dp, O_RDWR | O_NONBLOCK | O_CLOEXEC);
     if (fd < 0) {
-      device->m_devImp->deviceError(FMT_STRING("Unable to open {}@{}: {}\n"),
-                                    device->m_token.getProductName(), dp, strerror(errno));
-      lk.unlock();
-      device->m_initCond.notify_one();
-      udev_device_unref(udevDev);
-      return;
+      m_devImp->deviceError(FMT_STRING("Unable to open {}@{}: {}\n"), m_token.getProductName(), dp, strerror(errno));
+      return false;
     }
-    device->m_devFd = fd;
-
-    /* Return control to main thread */
-    device->m_runningTransferLoop = true;
-    lk.unlock();
-    device->m_initCond.notify_one();
+    m_devFd = fd;
 
     /* Report descriptor size */
     int reportDescSize;
     if (ioctl(fd, HIDIOCGRDESCSIZE, &reportDescSize) == -1) {
-      device->m_devImp->deviceError(FMT_STRING("Unable to ioctl(HIDIOCGRDESCSIZE) {}@{}: {}\n"),
-                                    device->m_token.getProductName(), dp, strerror(errno));
-      close(fd);
-      return;
+      m_devImp->deviceError(FMT_STRING("Unable to ioctl(HIDIOCGRDESCSIZE) {}@{}: {}\n"), m_token.getProductName(), dp,
+                            strerror(errno));
+      return false;
     }
 
     /* Get report descriptor */
     hidraw_report_descriptor reportDesc;
     reportDesc.size = reportDescSize;
     if (ioctl(fd, HIDIOCGRDESC, &reportDesc) == -1) {
-      device->m_devImp->deviceError(FMT_STRING("Unable to ioctl(HIDIOCGRDESC) {}@{}: {}\n"),
-                                    device->m_token.getProductName(), dp, strerror(errno));
-      close(fd);
-      return;
+      m_devImp->deviceError(FMT_STRING("Unable to ioctl(HIDIOCGRDESC) {}@{}: {}\n"), m_token.getProductName(), dp,
+                            strerror(errno));
+      return false;
+    }
+    m_readSz = HIDParser::CalculateMaxInputReportSize(reportDesc.value, reportDesc.size);
+    m_readBuf.reset(new uint8_t[m_readSz]);
+    return true;
+  }
+
+  bool _openEvdev() {
+    m_udevDev = udev_device_new_from_syspath(GetUdev(), m_devPath.data());
+
+    /* Get device file */
+    const char* dp = udev_device_get_devnode(m_udevDev);
+    int fd = open(dp, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+      m_devImp->deviceError(FMT_STRING("Unable to open {}@{}: {}\n"), m_token.getProductName(), dp, strerror(errno));
+      return false;
+    }
+    m_devFd = fd;
+
+    /* Event times then share InputClock's epoch */
+    int clock = CLOCK_MONOTONIC;
+    m_evdevMonotonic = ioctl(fd, EVIOCSCLOCKID, &clock) == 0;
+
+    /* Codes the device reports, for rebuilding its state */
+    constexpr size_t LongBits = sizeof(unsigned long) * 8;
+    unsigned long keyBits[KEY_CNT / LongBits + 1] = {};
+    unsigned long absBits[ABS_CNT / LongBits + 1] = {};
+    if (ioctl(fd, EVIOCGBIT(EV_KEY, sizeof(keyBits)), keyBits) >= 0)
+      for (uint16_t code = 0; code < KEY_CNT; ++code)
+        if (keyBits[code / LongBits] >> (code % LongBits) & 1)
+          m_evdevKeys.push_back(code);
+    if (ioctl(fd, EVIOCGBIT(EV_ABS, sizeof(absBits)), absBits) >= 0)
+      for (uint16_t code = 0; code < ABS_CNT; ++code)
+        if (absBits[code / LongBits] >> (code % LongBits) & 1)
+          m_evdevAxes.push_back(code);
+
+    m_readSz = EvdevReadEvents * sizeof(input_event);
+    m_readBuf.reset(new uint8_t[m_readSz]);
+    m_evdevFrame.reserve(EvdevReadEvents);
+    return true;
+  }
+
+  InputClock::time_point _evdevTime(const input_event& ev) const {
+    if (!m_evdevMonotonic)
+      return InputClock::now();
+    return InputClock::time_point(std::chrono::duration_cast<InputClock::duration>(
+        std::chrono::seconds(ev.input_event_sec) + std::chrono::microseconds(ev.input_event_usec)));
+  }
+
+  /* Replace the pending frame with the device's full current key and axis state */
+  void _syncEvdev() {
+    m_evdevFrame.clear();
+    constexpr size_t LongBits = sizeof(unsigned long) * 8;
+    unsigned long keyState[KEY_CNT / LongBits + 1] = {};
+    if (ioctl(m_devFd, EVIOCGKEY(sizeof(keyState)), keyState) >= 0)
+      for (uint16_t code : m_evdevKeys)
+        m_evdevFrame.push_back({EV_KEY, code, int32_t(keyState[code / LongBits] >> (code % LongBits) & 1)});
+    for (uint16_t code : m_evdevAxes) {
+      input_absinfo info;
+      if (ioctl(m_devFd, EVIOCGABS(code), &info) == 0)
+        m_evdevFrame.push_back({EV_ABS, code, info.value});
     }
-    size_t readSz = HIDParser::CalculateMaxInputReportSize(reportDesc.value, reportDesc.size);
-    std::unique_ptr<uint8_t[]> readBuf(new uint8_t[readSz]);
-
-    /* Start transfer loop */
-    device->m_devImp->initialCycle();
-    while (device->m_runningTransferLoop) {
-      fd_set readset;
-      FD_ZERO(&readset);
-      FD_SET(fd, &readset);
-      struct timeval timeout = {0, 10000};
-      if (select(fd + 1, &readset, nullptr, nullptr, &timeout) > 0) {
-        while (true) {
-          ssize_t sz = read(fd, readBuf.get(), readSz);
-          if (sz < 0)
-            break;
-          device->m_devImp->receivedHIDReport(readBuf.get(), sz, HIDReportType::Input, readBuf[0]);
+  }
+
+  void _deliverEvdevFrame(InputClock::time_point time) {
+    const auto* data = reinterpret_cast<const uint8_t*>(m_evdevFrame.data());
+    const size_t length = m_evdevFrame.size() * sizeof(EvdevEvent);
+    _stampReport(*m_devImp, time);
+    if (m_capture)
+      m_capture->write(HIDCaptureRecord::Report, time, data, length);
+    m_devImp->receivedHIDReport(data, length, HIDReportType::Input, 0);
+    m_evdevFrame.clear();
+  }
+
+  void _readEvdev() {
+    while (true) {
+      const ssize_t sz = read(m_devFd, m_readBuf.get(), m_readSz);
+      if (sz < ssize_t(sizeof(input_event)))
+        return;
+      const auto* events = reinterpret_cast<const input_event*>(m_readBuf.get());
+      for (size_t i = 0, count = size_t(sz) / sizeof(input_event); i < count; ++i) {
+        const input_event& ev = events[i];
+        if (ev.type != EV_SYN) {
+          if (!m_evdevDropped)
+            m_evdevFrame.push_back({ev.type, ev.code, ev.value});
+        } else if (ev.code == SYN_DROPPED) {
+          m_evdevDropped = true;
+          m_evdevFrame.clear();
+        } else if (ev.code == SYN_REPORT) {
+          if (m_evdevDropped) {
+            m_evdevDropped = false;
+            _syncEvdev();
+          }
+          _deliverEvdevFrame(_evdevTime(ev));
+          if (!m_reactorId)
+            return; /* Closed from a callback */
         }
       }
-      if (device->m_runningTransferLoop)
-        device->m_devImp->transferCycle();
+      /* A short read emptied the queue; no need for another syscall to hit EAGAIN */
+      if (size_t(sz) < m_readSz)
+        return;
+    }
+  }
+
+  void _closeDev() {
+    if (m_devFd) {
+      close(m_devFd);
+      m_devFd = 0;
+    }
+    if (m_udevDev) {
+      udev_device_unref(m_udevDev);
+      m_udevDev = nullptr;
+    }
+  }
+
+  void reactorAttached(uint64_t id) override { m_reactorId = id; }
+
+  void reactorStart() override {
+    m_cycling = true;
+    m_devImp->initialCycle();
+    if (m_token.getDeviceType() == DeviceType::Evdev) {
+      /* Keys already held and axes off zero show up in the first frame */
+      _syncEvdev();
+      _deliverEvdevFrame(InputClock::now());
+    }
+    if (m_usbIn)
+      for (size_t i = 0; i < USBInTransfers; ++i)
+        _submitUSBIn(m_usbIn[i]);
+  }
+
+  void reactorEvent(uint32_t events) override {
+    if (events & EPOLLOUT) {
+      _reapUSB();
+      if (!m_reactorId)
+        return;
+    }
+    if ((events & EPOLLIN) && m_token.getDeviceType() == DeviceType::Evdev) {
+      _readEvdev();
+      if (!m_reactorId)
+        return;
+    } else if (events & EPOLLIN) {
+      while (true) {
+        ssize_t sz = read(m_devFd, m_readBuf.get(), m_readSz);
+        if (sz <= 0)
+          break;
+        const InputClock::time_point now = InputClock::now();
+        _stampReport(*m_devImp, now);
+        if (m_capture)
+          m_capture->write(HIDCaptureRecord::Report, now, m_readBuf.get(), sz, HIDReportType::Input, m_readBuf[0]);
+        m_devImp->receivedHIDReport(m_readBuf.get(), sz, HIDReportType::Input, m_readBuf[0]);
+        if (!m_reactorId)
+          return;
+      }
+    }
+    /* Unplugged; stop watching until the listener reports the disconnect */
+    if (events & (EPOLLERR | EPOLLHUP)) {
+      if (const uint64_t id = m_reactorId.exchange(0))
+        InputReactor::Get().remove(id);
     }
-    device->m_devImp->finalCycle();
+  }
 
-    /* Cleanup */
-    close(fd);
-    device->m_devFd = 0;
-    udev_device_unref(udevDev);
+  void reactorTimer() override {
+    _stampReport(*m_devImp, InputClock::now());
+    m_devImp->transferCycle();
   }
 
-  void _deviceDisconnected() override { m_runningTransferLoop = false; }
+  void _deviceDisconnected() override {
+    /* Keep ourselves alive past the reactor's reference */
+    std::shared_ptr<InputReactor::Source> self;
+    if (const uint64_t id = m_reactorId.exchange(0))
+      self = InputReactor::Get().remove(id);
+    if (m_cycling.exchange(false))
+      m_devImp->finalCycle();
+    /* Closing a usbdevfs descriptor also discards its queued URBs */
+    _closeDev();
+    if (m_capture) {
+      m_capture->write(HIDCaptureRecord::Disconnect, InputClock::now(), nullptr, 0);
+      m_capture.reset();
+    }
+  }
 
   std::vector<uint8_t> _getReportDescriptor() override {
     /* Report descriptor size */
@@ -225,6 +451,8 @@ class HIDDeviceUdev final : public IHIDDevice {
       return {};
     std::vector<uint8_t> ret(reportDesc.size, '\0');
     memmove(ret.data(), reportDesc.value, reportDesc.size);
+    if (m_capture)
+      m_capture->write(HIDCaptureRecord::Descriptor, InputClock::now(), ret.data(), ret.size());
     return ret;
   }
 
@@ -246,12 +474,25 @@ class HIDDeviceUdev final : public IHIDDevice {
   }
 
   size_t _receiveHIDReport(uint8_t* data, size_t length, HIDReportType tp, uint32_t message) override {
+    if (m_devFd && m_token.getDeviceType() == DeviceType::Evdev) {
+      /* Evdev feature reports are the input_absinfo of the ABS_* code in message */
+      input_absinfo info;
+      if (tp != HIDReportType::Feature || message >= ABS_CNT || ioctl(m_devFd, EVIOCGABS(message), &info) < 0)
+        return 0;
+      const size_t count = std::min(length, sizeof(info));
+      std::memcpy(data, &info, count);
+      if (m_capture)
+        m_capture->write(HIDCaptureRecord::Feature, InputClock::now(), data, count, tp, message);
+      return count;
+    }
     if (m_devFd) {
       if (tp == HIDReportType::Feature) {
         data[0] = message;
         int ret = ioctl(m_devFd, HIDIOCGFEATURE(length), data);
         if (ret < 0)
           return 0;
+        if (m_capture)
+          m_capture->write(HIDCaptureRecord::Feature, InputClock::now(), data, length, tp, message);
         return length;
       }
     }
@@ -263,26 +504,42 @@ public:
   : m_token(token), m_devImp(devImp), m_devPath(token.getDevicePath()) {}
 
   void _startThread() override {
-    std::unique_lock<std::mutex> lk(m_initMutex);
+    m_capture = HIDCaptureWriter::Open(m_token);
     DeviceType dType = m_token.getDeviceType();
-    if (dType == DeviceType::USB)
-      m_thread = std::thread(_threadProcUSBLL, std::static_pointer_cast<HIDDeviceUdev>(shared_from_this()));
-    else if (dType == DeviceType::Bluetooth)
-      m_thread = std::thread(_threadProcBTLL, std::static_pointer_cast<HIDDeviceUdev>(shared_from_this()));
-    else if (dType == DeviceType::HID)
-      m_thread = std::thread(_threadProcHID, std::static_pointer_cast<HIDDeviceUdev>(shared_from_this()));
-    else {
+    if (dType == DeviceType::USB) {
+      if (!_openUSB()) {
+        _closeDev();
+        return;
+      }
+      if (!InputReactor::Get().add(std::static_pointer_cast<HIDDeviceUdev>(shared_from_this()), m_devFd,
+                                   EPOLLOUT | EPOLLERR | EPOLLHUP, {}))
+        _closeDev();
+    } else if (dType == DeviceType::Bluetooth) {
+      m_udevDev = udev_device_new_from_syspath(GetUdev(), m_devPath.data());
+      InputReactor::Get().add(std::static_pointer_cast<HIDDeviceUdev>(shared_from_this()), -1, 0, BTCyclePeriod);
+    } else if (dType == DeviceType::HID) {
+      if (!_openHID()) {
+        _closeDev();
+        return;
+      }
+      if (!InputReactor::Get().add(std::static_pointer_cast<HIDDeviceUdev>(shared_from_this()), m_devFd,
+                                   EPOLLIN | EPOLLERR | EPOLLHUP, HIDCyclePeriod))
+        _closeDev();
+    } else if (dType == DeviceType::Evdev) {
+      if (!_openEvdev()) {
+        _closeDev();
+        return;
+      }
+      if (!InputReactor::Get().add(std::static_pointer_cast<HIDDeviceUdev>(shared_from_this()), m_devFd,
+                                   EPOLLIN | EPOLLERR | EPOLLHUP, {}))
+        _closeDev();
+    } else {
       fmt::print(stderr, FMT_STRING("invalid token supplied to device constructor"));
       abort();
     }
-    m_initCond.wait(lk);
   }
 
-  ~HIDDeviceUdev() override {
-    m_runningTransferLoop = false;
-    if (m_thread.joinable())
-      m_thread.detach();
-  }
+  ~HIDDeviceUdev() override { _closeDev(); }
 };
 
 std::shared_ptr<IHIDDevice> IHIDDeviceNew(DeviceToken& token, const std::shared_ptr<DeviceBase>& devImp) {
@@ -1,16 +1,17 @@
 #include "boo/inputdev/IHIDListener.hpp"
 #include "boo/inputdev/DeviceFinder.hpp"
 #include "boo/inputdev/HIDParser.hpp"
+#include "lib/inputdev/InputReactorUdev.hpp"
 #include "logvisor/logvisor.hpp"
 #include <libudev.h>
+#include <atomic>
 #include <cstring>
 #include <cstdio>
-#include <signal.h>
 #include <fcntl.h>
 #include <linux/hidraw.h>
+#include <sys/epoll.h>
 #include <sys/ioctl.h>
 #include <unistd.h>
-#include <thread>
 
 namespace boo {
 
@@ -22,13 +23,22 @@ udev* GetUdev() {
 }
 
 class HIDListenerUdev final : public IHIDListener {
+  /* Hotplug events are drained on the input reactor thread as they arrive. Reactor callbacks run without
+   * its lock, so the finder's token lock (held by apps opening devices, which adds reactor sources) never nests */
+  struct MonitorSource : InputReactor::Source {
+    HIDListenerUdev& m_listener;
+    explicit MonitorSource(HIDListenerUdev& listener) : m_listener(listener) {}
+    void reactorEvent(uint32_t events) override { m_listener._receiveEvents(); }
+  };
+
   DeviceFinder& m_finder;
 
   udev_monitor* m_udevMon;
-  std::thread m_udevThread;
-  bool m_scanningEnabled;
+  uint64_t m_reactorId = 0;
+  std::atomic_bool m_scanningEnabled{false};
+  bool m_enumerated = false;
 
-  void deviceConnected(udev_device* device) {
+  void deviceConnected(udev_device* device, InputClock::time_point arrival) {
     if (!m_scanningEnabled)
       return;
 
@@ -37,7 +47,7 @@ class HIDListenerUdev final : public IHIDListener {
     if (m_finder._hasToken(devPath))
       return;
 
-    /* Filter to USB/BT */
+    /* Filter to USB/BT, HID gamepads and evdev joysticks */
     const char* dt = udev_device_get_devtype(device);
     DeviceType type = DeviceType::None;
     int vid = 0, pid = 0;
@@ -67,6 +77,24 @@ class HIDListenerUdev final : public IHIDListener {
       udev_list_entry* producte = udev_list_entry_get_by_name(attrs, "ID_MODEL");
       if (producte)
         product = udev_list_entry_get_value(producte);
+    } else if (!strcmp(udev_device_get_subsystem(device), "input")) {
+      /* Event nodes the input_id builtin tagged as joysticks (which covers gamepads) */
+      const char* sysname = udev_device_get_sysname(device);
+      const char* joystick = udev_device_get_property_value(device, "ID_INPUT_JOYSTICK");
+      if (!sysname || strncmp(sysname, "event", 5) || !joystick || strcmp(joystick, "1"))
+        return;
+      type = DeviceType::Evdev;
+
+      /* The parent inputN device carries the bus IDs and name */
+      udev_device* parent = udev_device_get_parent_with_subsystem_devtype(device, "input", nullptr);
+      if (!parent)
+        return;
+      if (const char* vids = udev_device_get_sysattr_value(parent, "id/vendor"))
+        vid = strtol(vids, nullptr, 16);
+      if (const char* pids = udev_device_get_sysattr_value(parent, "id/product"))
+        pid = strtol(pids, nullptr, 16);
+      product = udev_device_get_sysattr_value(parent, "name");
+      manuf = product;
     } else if (!strcmp(udev_device_get_subsystem(device), "hidraw")) {
       type = DeviceType::HID;
       udev_device* parent = udev_device_get_parent(device);
@@ -128,7 +156,7 @@ class HIDListenerUdev final : public IHIDListener {
     std::fputs("\n\n", stderr);
 #endif
 
-    m_finder._insertToken(std::make_unique<DeviceToken>(type, vid, pid, manuf, product, devPath));
+    m_finder._insertToken(std::make_unique<DeviceToken>(type, vid, pid, manuf, product, devPath), arrival);
   }
 
   void deviceDisconnected(udev_device* device) {
@@ -136,32 +164,15 @@ class HIDListenerUdev final : public IHIDListener {
     m_finder._removeToken(devPath);
   }
 
-  void _udevProc() {
-    logvisor::RegisterThreadName("Boo udev");
-    udev_monitor_enable_receiving(m_udevMon);
-    int fd = udev_monitor_get_fd(m_udevMon);
-    while (true) {
-      fd_set fds;
-      FD_ZERO(&fds);
-      FD_SET(fd, &fds);
-      if (pselect(fd + 1, &fds, nullptr, nullptr, nullptr, nullptr) < 0) {
-        /* SIGTERM handled here */
-        if (errno == EINTR)
-          break;
-      }
-      int oldtype;
-      pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &oldtype);
-      udev_device* dev = udev_monitor_receive_device(m_udevMon);
-      if (dev) {
-        const char* action = udev_device_get_action(dev);
-        if (!strcmp(action, "add"))
-          deviceConnected(dev);
-        else if (!strcmp(action, "remove"))
-          deviceDisconnected(dev);
-        udev_device_unref(dev);
-      }
-      pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, &oldtype);
-      pthread_testcancel();
+  void _receiveEvents() {
+    while (udev_device* dev = udev_monitor_receive_device(m_udevMon)) {
+      const InputClock::time_point arrival = InputClock::now();
+      const char* action = udev_device_get_action(dev);
+      if (!strcmp(action, "add"))
+        deviceConnected(dev, arrival);
+      else if (!strcmp(action, "remove"))
+        deviceDisconnected(dev);
+      udev_device_unref(dev);
     }
   }
 
@@ -176,27 +187,28 @@ public:
     udev_monitor_filter_add_match_subsystem_devtype(m_udevMon, "usb", "usb_device");
     udev_monitor_filter_add_match_subsystem_devtype(m_udevMon, "bluetooth", "bluetooth_device");
     udev_monitor_filter_add_match_subsystem_devtype(m_udevMon, "hidraw", nullptr);
+    udev_monitor_filter_add_match_subsystem_devtype(m_udevMon, "input", nullptr);
     udev_monitor_filter_update(m_udevMon);
 
-    /* Initial HID Device Add */
-    m_scanningEnabled = true;
-    scanNow();
-    m_scanningEnabled = false;
-
-    /* Start hotplug thread */
-    m_udevThread = std::thread(std::bind(&HIDListenerUdev::_udevProc, this), this);
+    /* Receiving before the initial enumeration leaves no gap; duplicates are dropped by the finder */
+    udev_monitor_enable_receiving(m_udevMon);
+    m_reactorId = InputReactor::Get().add(std::make_shared<MonitorSource>(*this), udev_monitor_get_fd(m_udevMon),
+                                          EPOLLIN, {});
+    if (!m_reactorId)
+      fmt::print(stderr, FMT_STRING("unable to watch udev_monitor; hotplug disabled"));
   }
 
   ~HIDListenerUdev() override {
-    pthread_cancel(m_udevThread.native_handle());
-    if (m_udevThread.joinable())
-      m_udevThread.join();
+    if (m_reactorId)
+      InputReactor::Get().remove(m_reactorId);
     udev_monitor_unref(m_udevMon);
   }
 
-  /* Automatic device scanning */
+  /* Automatic device scanning; the first start enumerates present devices */
   bool startScanning() override {
     m_scanningEnabled = true;
+    if (!m_enumerated)
+      scanNow();
     return true;
   }
   bool stopScanning() override {
@@ -206,10 +218,15 @@ public:
 
   /* Manual device scanning */
   bool scanNow() override {
+    /* Everything found by one scan shares its arrival time, so cold-start latency includes the walk */
+    const InputClock::time_point arrival = InputClock::now();
+    const bool wasEnabled = m_scanningEnabled.exchange(true);
+    m_enumerated = true;
     udev_enumerate* uenum = udev_enumerate_new(GetUdev());
     udev_enumerate_add_match_subsystem(uenum, "usb");
     udev_enumerate_add_match_subsystem(uenum, "bluetooth");
     udev_enumerate_add_match_subsystem(uenum, "hidraw");
+    udev_enumerate_add_match_subsystem(uenum, "input");
     udev_enumerate_scan_devices(uenum);
     udev_list_entry* uenumList = udev_enumerate_get_list_entry(uenum);
     udev_list_entry* uenumItem;
@@ -217,10 +234,11 @@ public:
       const char* devPath = udev_list_entry_get_name(uenumItem);
       udev_device* dev = udev_device_new_from_syspath(UDEV_INST, devPath);
       if (dev)
-        deviceConnected(dev);
+        deviceConnected(dev, arrival);
       udev_device_unref(dev);
     }
     udev_enumerate_unref(uenum);
+    m_scanningEnabled = wasEnabled;
     return true;
   }
 };
@@ -2,7 +2,13 @@
 
 #include <algorithm>
 #include <array>
+#include <bit>
+#include <cstring>
 #include <map>
+#include <mutex>
+#include <unordered_map>
+
+#include "xxhash/xxhash.h"
 
 #undef min
 #undef max
@@ -362,16 +368,6 @@ struct HIDItemState {
   }
 };
 
-struct HIDCollectionItem {
-  /* [6.2.2.6] Collection, End Collection Items */
-  HIDCollectionType m_type;
-  HIDUsagePage m_usagePage;
-  HIDUsage m_usage;
-
-  HIDCollectionItem(HIDCollectionType type, const HIDItemState& state)
-  : m_type(type), m_usagePage(state.m_usagePage), m_usage(state.GetUsage(0)) {}
-};
-
 HIDMainItem::HIDMainItem(uint32_t flags, const HIDItemState& state, uint32_t reportIdx) : m_flags(uint16_t(flags)) {
   m_usagePage = state.m_usagePage;
   m_usage = state.GetUsage(reportIdx);
@@ -418,23 +414,6 @@ const char* HIDMainItem::GetUsageName() const {
   }
 }
 
-struct HIDReports {
-  std::map<int32_t, std::vector<HIDMainItem>> m_inputReports;
-  std::map<int32_t, std::vector<HIDMainItem>> m_outputReports;
-  std::map<int32_t, std::vector<HIDMainItem>> m_featureReports;
-
-  static void _AddItem(std::map<int32_t, std::vector<HIDMainItem>>& m, uint32_t flags, const HIDItemState& state) {
-    std::vector<HIDMainItem>& report = m[state.m_reportID];
-    report.reserve(report.size() + state.m_reportCount);
-    for (uint32_t i = 0; i < state.m_reportCount; ++i)
-      report.emplace_back(flags, state, i);
-  }
-
-  void AddInputItem(uint32_t flags, const HIDItemState& state) { _AddItem(m_inputReports, flags, state); }
-  void AddOutputItem(uint32_t flags, const HIDItemState& state) { _AddItem(m_outputReports, flags, state); }
-  void AddFeatureItem(uint32_t flags, const HIDItemState& state) { _AddItem(m_featureReports, flags, state); }
-};
-
 #if _WIN32
 #if !WINDOWS_STORE
 HIDParser::ParserStatus HIDParser::Parse(const PHIDP_PREPARSED_DATA descriptorData) {
@@ -502,6 +481,13 @@ HIDParser::ParserStatus HIDParser::Parse(const PHIDP_PREPARSED_DATA descriptorDa
   for (const auto& item : inputItems)
     m_itemPool.push_back(item.second);
 
+  m_valueItems.reset(new uint32_t[m_itemPool.size()]);
+  m_valueCount = 0;
+  for (uint32_t i = 0; i < m_itemPool.size(); ++i)
+    if (!m_itemPool[i].IsConstant())
+      m_valueItems[m_valueCount++] = i;
+  m_scanValues.reset(new int32_t[m_valueCount]);
+
   m_status = ParserStatus::Done;
   return ParserStatus::Done;
 }
@@ -551,9 +537,66 @@ static uint32_t GetShortValue(const uint8_t*& it, const uint8_t* end, int adv, H
   return 0;
 }
 
-HIDParser::ParserStatus HIDParser::ParseItem(HIDReports& reportsOut, std::stack<HIDItemState>& stateStack,
-                                             std::stack<HIDCollectionItem>& collectionStack, const uint8_t*& it,
-                                             const uint8_t* end, bool& multipleReports) {
+static int32_t GetSignedShortValue(uint32_t data, int adv) {
+  switch (adv) {
+  case 1:
+    return int8_t(data);
+  case 2:
+    return int16_t(data);
+  default:
+    return int32_t(data);
+  }
+}
+
+namespace {
+/* Main item expanded per report count, tagged with the report it belongs to */
+struct ScannedItem {
+  HIDItemTag m_kind; /* Input, Output or Feature */
+  int32_t m_reportId;
+  HIDMainItem m_item;
+};
+
+/* Single walk over a descriptor collecting main items, the report ID mode and the first application
+ * collection. Global state is a plain vector stack; local usages reuse the top entry's storage */
+struct DescriptorScan {
+  HIDParser::ParserStatus m_status = HIDParser::ParserStatus::OK;
+  std::vector<ScannedItem> m_items;
+  bool m_multipleReports = false;
+  std::pair<HIDUsagePage, HIDUsage> m_applicationUsage = {};
+
+  std::vector<HIDItemState> m_stateStack;
+  std::vector<HIDCollectionType> m_collectionStack;
+  bool m_foundApplication = false;
+
+  void _addItems(HIDItemTag kind, uint32_t flags) {
+    const HIDItemState& state = m_stateStack.back();
+    m_items.reserve(m_items.size() + state.m_reportCount);
+    for (uint32_t i = 0; i < state.m_reportCount; ++i)
+      m_items.push_back({kind, int32_t(state.m_reportID), HIDMainItem(flags, state, i)});
+  }
+
+  HIDParser::ParserStatus parseItem(const uint8_t*& it, const uint8_t* end);
+
+  void scan(const uint8_t* descriptorData, size_t len) {
+    m_stateStack.reserve(4);
+    m_stateStack.emplace_back();
+    const uint8_t* end = descriptorData + len;
+    for (const uint8_t* it = descriptorData; it != end;) {
+      const HIDParser::ParserStatus status = parseItem(it, end);
+      if (m_status != HIDParser::ParserStatus::Error)
+        m_status = status;
+      if (status == HIDParser::ParserStatus::OK)
+        continue;
+      /* Enumeration tolerates malformed items outside any collection while looking for the application */
+      if (status == HIDParser::ParserStatus::Error && m_collectionStack.empty() && !m_foundApplication)
+        continue;
+      break;
+    }
+  }
+};
+
+HIDParser::ParserStatus DescriptorScan::parseItem(const uint8_t*& it, const uint8_t* end) {
+  using ParserStatus = HIDParser::ParserStatus;
   ParserStatus status = ParserStatus::OK;
   uint8_t head = *it++;
   if (head == 0b11111110) {
@@ -573,71 +616,75 @@ HIDParser::ParserStatus HIDParser::ParseItem(HIDReports& reportsOut, std::stack<
     if (status == ParserStatus::Error)
       return ParserStatus::Error;
 
+    HIDItemState& state = m_stateStack.back();
     switch (HIDItemType((head >> 2) & 0x3)) {
     case HIDItemType::Main:
       switch (HIDItemTag(head >> 4)) {
       case HIDItemTag::Input:
-        reportsOut.AddInputItem(data, stateStack.top());
-        break;
       case HIDItemTag::Output:
-        reportsOut.AddOutputItem(data, stateStack.top());
-        break;
       case HIDItemTag::Feature:
-        reportsOut.AddFeatureItem(data, stateStack.top());
+        _addItems(HIDItemTag(head >> 4), data);
         break;
       case HIDItemTag::Collection:
-        collectionStack.emplace(HIDCollectionType(data), stateStack.top());
+        m_collectionStack.push_back(HIDCollectionType(data));
+        if (!m_foundApplication && HIDCollectionType(data) == HIDCollectionType::Application) {
+          m_foundApplication = true;
+          m_applicationUsage = {state.m_usagePage, state.GetUsage(0)};
+        }
         break;
       case HIDItemTag::EndCollection:
-        if (collectionStack.empty())
+        if (m_collectionStack.empty())
           return ParserStatus::Error;
-        collectionStack.pop();
+        m_collectionStack.pop_back();
         break;
       default:
         return ParserStatus::Error;
       }
-      stateStack.top().ResetLocalItems();
+      state.ResetLocalItems();
       break;
     case HIDItemType::Global:
       switch (HIDItemTag(head >> 4)) {
       case HIDItemTag::UsagePage:
-        stateStack.top().m_usagePage = HIDUsagePage(data);
+        state.m_usagePage = HIDUsagePage(data);
         break;
       case HIDItemTag::LogicalMinimum:
-        stateStack.top().m_logicalRange.first = data;
+        state.m_logicalRange.first = GetSignedShortValue(data, head & 0x3);
         break;
       case HIDItemTag::LogicalMaximum:
-        stateStack.top().m_logicalRange.second = data;
+        /* Signed only when the minimum is; many descriptors encode 255 as a single byte */
+        state.m_logicalRange.second =
+            state.m_logicalRange.first < 0 ? GetSignedShortValue(data, head & 0x3) : int32_t(data);
         break;
       case HIDItemTag::PhysicalMinimum:
-        stateStack.top().m_physicalRange.first = data;
+        state.m_physicalRange.first = data;
         break;
       case HIDItemTag::PhysicalMaximum:
-        stateStack.top().m_physicalRange.second = data;
+        state.m_physicalRange.second = data;
         break;
       case HIDItemTag::UnitExponent:
-        stateStack.top().m_unitExponent = data;
+        state.m_unitExponent = data;
         break;
       case HIDItemTag::Unit:
-        stateStack.top().m_unit = data;
+        state.m_unit = data;
         break;
       case HIDItemTag::ReportSize:
-        stateStack.top().m_reportSize = data;
+        state.m_reportSize = data;
         break;
       case HIDItemTag::ReportID:
-        multipleReports = true;
-        stateStack.top().m_reportID = data;
+        m_multipleReports = true;
+        state.m_reportID = data;
         break;
       case HIDItemTag::ReportCount:
-        stateStack.top().m_reportCount = data;
+        state.m_reportCount = data;
         break;
       case HIDItemTag::Push:
-        stateStack.push(stateStack.top());
+        m_stateStack.push_back(state);
         break;
       case HIDItemTag::Pop:
-        if (stateStack.empty())
+        /* The base state must remain */
+        if (m_stateStack.size() < 2)
           return ParserStatus::Error;
-        stateStack.pop();
+        m_stateStack.pop_back();
         break;
       default:
         return ParserStatus::Error;
@@ -646,13 +693,13 @@ HIDParser::ParserStatus HIDParser::ParseItem(HIDReports& reportsOut, std::stack<
     case HIDItemType::Local:
       switch (HIDItemTag(head >> 4)) {
       case HIDItemTag::Usage:
-        stateStack.top().m_usage.push_back(HIDUsage(data));
+        state.m_usage.push_back(HIDUsage(data));
         break;
       case HIDItemTag::UsageMinimum:
-        stateStack.top().m_usageRange.first = data;
+        state.m_usageRange.first = data;
         break;
       case HIDItemTag::UsageMaximum:
-        stateStack.top().m_usageRange.second = data;
+        state.m_usageRange.second = data;
         break;
       case HIDItemTag::DesignatorIndex:
       case HIDItemTag::DesignatorMinimum:
@@ -674,100 +721,204 @@ HIDParser::ParserStatus HIDParser::ParseItem(HIDReports& reportsOut, std::stack<
   return it == end ? ParserStatus::Done : ParserStatus::OK;
 }
 
-HIDParser::ParserStatus HIDParser::Parse(const uint8_t* descriptorData, size_t len) {
-  std::stack<HIDItemState> stateStack;
-  stateStack.emplace();
-  std::stack<HIDCollectionItem> collectionStack;
-  HIDReports reports;
-
-  const uint8_t* end = descriptorData + len;
-  for (const uint8_t* it = descriptorData; it != end;)
-    if ((m_status = ParseItem(reports, stateStack, collectionStack, it, end, m_multipleReports)) != ParserStatus::OK)
-      break;
-
-  if (m_status != ParserStatus::Done)
-    return m_status;
+/* Reserve count T in an arena of size bytes, returning the aligned offset */
+template <typename T>
+size_t ArenaReserve(size_t& size, size_t count) {
+  const size_t offset = (size + alignof(T) - 1) & ~(alignof(T) - 1);
+  size = offset + sizeof(T) * count;
+  return offset;
+}
 
-  uint32_t itemCount = 0;
-  uint32_t reportCount =
-      uint32_t(reports.m_inputReports.size() + reports.m_outputReports.size() + reports.m_featureReports.size());
+template <typename T>
+T* ArenaArray(uint8_t* arena, size_t offset, size_t count) {
+  T* ret = reinterpret_cast<T*>(arena + offset);
+  std::uninitialized_default_construct_n(ret, count);
+  return ret;
+}
 
-  for (const auto& rep : reports.m_inputReports)
-    itemCount += rep.second.size();
-  for (const auto& rep : reports.m_outputReports)
-    itemCount += rep.second.size();
-  for (const auto& rep : reports.m_featureReports)
-    itemCount += rep.second.size();
+/* Entries beyond this are dropped wholesale; open devices keep their layouts alive */
+constexpr size_t LayoutCacheCapacity = 64;
+} // Anonymous namespace
+
+std::shared_ptr<const HIDParser::Layout> HIDParser::_buildLayout(const uint8_t* descriptorData, size_t len) {
+  DescriptorScan scan;
+  scan.scan(descriptorData, len);
+
+  auto layout = std::make_shared<Layout>();
+  layout->m_status = scan.m_status;
+  layout->m_applicationUsage = scan.m_applicationUsage;
+  if (scan.m_status != ParserStatus::Done)
+    return layout;
+  layout->m_multipleReports = scan.m_multipleReports;
+
+  /* Bucket items by (kind, report ID) in one pass; descriptors declare only a handful of reports */
+  struct Bucket {
+    HIDItemTag m_kind;
+    int32_t m_reportId;
+    uint32_t m_count = 0;
+    uint32_t m_next = 0; /* Item pool fill position */
+  };
+  std::vector<Bucket> buckets;
+  std::vector<uint32_t> itemBuckets(scan.m_items.size());
+  uint32_t inputItemCount = 0;
+  for (size_t i = 0; i < scan.m_items.size(); ++i) {
+    const ScannedItem& item = scan.m_items[i];
+    auto search = std::find_if(buckets.begin(), buckets.end(), [&](const Bucket& b) {
+      return b.m_kind == item.m_kind && b.m_reportId == item.m_reportId;
+    });
+    if (search == buckets.end())
+      search = buckets.insert(buckets.end(), Bucket{item.m_kind, item.m_reportId});
+    ++search->m_count;
+    itemBuckets[i] = uint32_t(search - buckets.begin());
+    if (item.m_kind == HIDItemTag::Input)
+      ++inputItemCount;
+  }
 
-  m_itemPool.reset(new HIDMainItem[itemCount]);
-  m_reportPool.reset(new Report[reportCount]);
+  /* Reports are ordered input, output, feature, each by report ID */
+  std::vector<uint32_t> order(buckets.size());
+  for (uint32_t i = 0; i < order.size(); ++i)
+    order[i] = i;
+  std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+    return std::make_pair(buckets[a].m_kind, buckets[a].m_reportId) <
+           std::make_pair(buckets[b].m_kind, buckets[b].m_reportId);
+  });
+  const auto countReports = [&](HIDItemTag kind) {
+    return uint32_t(std::count_if(buckets.begin(), buckets.end(), [&](const Bucket& b) { return b.m_kind == kind; }));
+  };
+  const uint32_t inputReportCount = countReports(HIDItemTag::Input);
+  const uint32_t outputReportCount = countReports(HIDItemTag::Output);
+
+  size_t arenaSize = 0;
+  const size_t itemOffset = ArenaReserve<HIDMainItem>(arenaSize, scan.m_items.size());
+  const size_t reportOffset = ArenaReserve<Report>(arenaSize, buckets.size());
+  const size_t opOffset = ArenaReserve<ExtractOp>(arenaSize, inputItemCount);
+  const size_t planOffset = ArenaReserve<InputPlan>(arenaSize, inputReportCount);
+  const size_t valueOffset = ArenaReserve<uint32_t>(arenaSize, inputItemCount);
+  layout->m_arena.reset(new uint8_t[arenaSize]);
+  uint8_t* arena = layout->m_arena.get();
+  layout->m_itemPool = ArenaArray<HIDMainItem>(arena, itemOffset, scan.m_items.size());
+  layout->m_reportPool = ArenaArray<Report>(arena, reportOffset, buckets.size());
+  layout->m_opPool = ArenaArray<ExtractOp>(arena, opOffset, inputItemCount);
+  layout->m_inputPlans = ArenaArray<InputPlan>(arena, planOffset, inputReportCount);
+  layout->m_valueItems = ArenaArray<uint32_t>(arena, valueOffset, inputItemCount);
 
   uint32_t itemIndex = 0;
-  uint32_t reportIndex = 0;
-
-  auto func = [&](std::pair<uint32_t, uint32_t>& out, const std::map<int32_t, std::vector<HIDMainItem>>& in) {
-    out = std::make_pair(reportIndex, reportIndex + in.size());
-    for (const auto& rep : in) {
-      m_reportPool[reportIndex++] = std::make_pair(rep.first, std::make_pair(itemIndex, itemIndex + rep.second.size()));
-      for (const auto& item : rep.second)
-        m_itemPool[itemIndex++] = item;
-    }
+  for (uint32_t i = 0; i < order.size(); ++i) {
+    Bucket& bucket = buckets[order[i]];
+    bucket.m_next = itemIndex;
+    layout->m_reportPool[i] = std::make_pair(bucket.m_reportId, std::make_pair(itemIndex, itemIndex + bucket.m_count));
+    itemIndex += bucket.m_count;
+  }
+  for (size_t i = 0; i < scan.m_items.size(); ++i)
+    layout->m_itemPool[buckets[itemBuckets[i]].m_next++] = scan.m_items[i].m_item;
+
+  layout->m_inputReports = std::make_pair(0, inputReportCount);
+  layout->m_outputReports = std::make_pair(inputReportCount, inputReportCount + outputReportCount);
+  layout->m_featureReports = std::make_pair(inputReportCount + outputReportCount, uint32_t(buckets.size()));
+
+  _compileInputPlans(*layout);
+  return layout;
+}
+
+std::shared_ptr<const HIDParser::Layout> HIDParser::_getLayout(const uint8_t* descriptorData, size_t len) {
+  struct CacheEntry {
+    std::vector<uint8_t> m_descriptor;
+    std::shared_ptr<const Layout> m_layout;
   };
-  func(m_inputReports, reports.m_inputReports);
-  func(m_outputReports, reports.m_outputReports);
-  func(m_featureReports, reports.m_featureReports);
+  static std::mutex CacheLock;
+  static std::unordered_map<uint64_t, CacheEntry> Cache;
+
+  const uint64_t key = XXH64(descriptorData, len, 0);
+  {
+    std::lock_guard lk(CacheLock);
+    const auto search = Cache.find(key);
+    if (search != Cache.end() &&
+        std::equal(descriptorData, descriptorData + len, search->second.m_descriptor.begin(),
+                   search->second.m_descriptor.end()))
+      return search->second.m_layout;
+  }
 
+  /* Miss: parse outside the lock so enumeration threads don't serialize on each other */
+  std::shared_ptr<const Layout> layout = _buildLayout(descriptorData, len);
+  std::lock_guard lk(CacheLock);
+  if (Cache.size() >= LayoutCacheCapacity)
+    Cache.clear();
+  Cache.insert_or_assign(key, CacheEntry{{descriptorData, descriptorData + len}, layout});
+  return layout;
+}
+
+HIDParser::ParserStatus HIDParser::Parse(const uint8_t* descriptorData, size_t len) {
+  m_layout = _getLayout(descriptorData, len);
+  m_status = m_layout->m_status;
+  m_scanValues.reset(new int32_t[m_layout->m_valueCount]);
   return m_status;
 }
 
-size_t HIDParser::CalculateMaxInputReportSize(const uint8_t* descriptorData, size_t len) {
-  std::stack<HIDItemState> stateStack;
-  stateStack.emplace();
-  std::stack<HIDCollectionItem> collectionStack;
-  HIDReports reports;
-  ParserStatus status = ParserStatus::Done;
-
-  bool multipleReports = false;
-  const uint8_t* end = descriptorData + len;
-  for (const uint8_t* it = descriptorData; it != end;)
-    if ((status = ParseItem(reports, stateStack, collectionStack, it, end, multipleReports)) != ParserStatus::OK)
-      break;
+void HIDParser::_compileInputPlans(Layout& layout) {
+  const uint32_t planCount = layout.m_inputReports.second - layout.m_inputReports.first;
+  layout.m_maxInputReportSize = layout.m_multipleReports;
+  uint32_t opCount = 0;
+  uint32_t valueCount = 0;
+
+  for (uint32_t i = 0; i < planCount; ++i) {
+    const Report& rep = layout.m_reportPool[layout.m_inputReports.first + i];
+    InputPlan& plan = layout.m_inputPlans[i];
+    plan.m_reportId = rep.first;
+    plan.m_ops.first = opCount;
+    plan.m_values.first = valueCount;
+
+    uint32_t bitOffset = layout.m_multipleReports ? 8 : 0;
+    ExtractOp* run = nullptr;
+    for (uint32_t j = rep.second.first; j < rep.second.second; ++j) {
+      const HIDMainItem& item = layout.m_itemPool[j];
+      const uint32_t bits = uint32_t(std::max(item.m_reportSize, 0));
+      const uint32_t offset = bitOffset;
+      bitOffset += bits;
+      if (item.IsConstant()) {
+        run = nullptr;
+        continue;
+      }
 
-  if (status != ParserStatus::Done)
-    return 0;
+      const uint32_t slot = valueCount++;
+      layout.m_valueItems[slot] = j;
+      const uint32_t valueBits = std::min(bits, 32u);
+      const uint32_t signBit = (item.m_logicalRange.first < 0 && valueBits) ? 1u << (valueBits - 1) : 0;
+
+      /* Consecutive byte-aligned 8/16-bit fields of the same signedness extend the current run */
+      const uint8_t width = (offset % 8 == 0 && (bits == 8 || bits == 16)) ? uint8_t(bits / 8) : 0;
+      if (width && run && run->m_width == width && run->m_signBit == signBit &&
+          run->m_byteOffset + run->m_count * width == offset / 8 && run->m_count < UINT16_MAX) {
+        ++run->m_count;
+        continue;
+      }
+
+      ExtractOp& op = layout.m_opPool[opCount++];
+      op.m_byteOffset = offset / 8;
+      op.m_value = slot;
+      op.m_mask = valueBits == 32 ? ~0u : (1u << valueBits) - 1;
+      op.m_signBit = signBit;
+      op.m_shift = uint8_t(offset % 8);
+      op.m_width = width;
+      op.m_count = 1;
+      run = width ? &op : nullptr;
+    }
 
-  size_t maxSize = 0;
-  for (const auto& rep : reports.m_inputReports) {
-    size_t repSize = 0;
-    for (const auto& item : rep.second)
-      repSize += item.m_reportSize;
-    if (repSize > maxSize)
-      maxSize = repSize;
+    plan.m_ops.second = opCount;
+    plan.m_values.second = valueCount;
+    plan.m_length = (bitOffset + 7) / 8;
+    layout.m_maxInputReportSize = std::max<size_t>(layout.m_maxInputReportSize, plan.m_length);
   }
 
-  return (maxSize + 7) / 8 + multipleReports;
+  layout.m_valueCount = valueCount;
 }
 
-std::pair<HIDUsagePage, HIDUsage> HIDParser::GetApplicationUsage(const uint8_t* descriptorData, size_t len) {
-  std::stack<HIDItemState> stateStack;
-  stateStack.emplace();
-  std::stack<HIDCollectionItem> collectionStack;
-  HIDReports reports;
-  ParserStatus status = ParserStatus::Done;
-
-  bool multipleReports = false;
-  const uint8_t* end = descriptorData + len;
-  for (const uint8_t* it = descriptorData; it != end;) {
-    status = ParseItem(reports, stateStack, collectionStack, it, end, multipleReports);
-    if (collectionStack.empty())
-      continue;
-    if (collectionStack.top().m_type == HIDCollectionType::Application)
-      return {collectionStack.top().m_usagePage, collectionStack.top().m_usage};
-    if (status != ParserStatus::OK)
-      break;
-  }
+size_t HIDParser::CalculateMaxInputReportSize(const uint8_t* descriptorData, size_t len) {
+  const std::shared_ptr<const Layout> layout = _getLayout(descriptorData, len);
+  return layout->m_status == ParserStatus::Done ? layout->m_maxInputReportSize : 0;
+}
 
-  return {};
+std::pair<HIDUsagePage, HIDUsage> HIDParser::GetApplicationUsage(const uint8_t* descriptorData, size_t len) {
+  return _getLayout(descriptorData, len)->m_applicationUsage;
 }
 #endif
 
@@ -790,10 +941,11 @@ void HIDParser::EnumerateValues(const std::function<bool(const HIDMainItem& item
   if (m_status != ParserStatus::Done)
     return;
 
-  for (uint32_t i = m_inputReports.first; i < m_inputReports.second; ++i) {
-    const Report& rep = m_reportPool[i];
+  const Layout& layout = *m_layout;
+  for (uint32_t i = layout.m_inputReports.first; i < layout.m_inputReports.second; ++i) {
+    const Report& rep = layout.m_reportPool[i];
     for (uint32_t j = rep.second.first; j < rep.second.second; ++j) {
-      const HIDMainItem& item = m_itemPool[j];
+      const HIDMainItem& item = layout.m_itemPool[j];
       if (item.IsConstant())
         continue;
       if (!valueCB(item))
@@ -804,99 +956,121 @@ void HIDParser::EnumerateValues(const std::function<bool(const HIDMainItem& item
 #endif
 
 #if _WIN32
-void HIDParser::ScanValues(const std::function<bool(const HIDMainItem& item, int32_t value)>& valueCB,
-                           const uint8_t* data, size_t len) const {
+std::pair<uint32_t, uint32_t> HIDParser::DecodeValues(const uint8_t* data, size_t len, int32_t* values) const {
 #if !WINDOWS_STORE
   if (m_status != ParserStatus::Done)
-    return;
+    return {};
 
   ULONG dataLen = m_dataList.size();
   if (HidP_GetData(HidP_Input, m_dataList.data(), &dataLen, m_descriptorData, PCHAR(data), len) != HIDP_STATUS_SUCCESS)
-    return;
-
-  int idx = 0;
-  auto it = m_dataList.begin();
-  auto end = m_dataList.begin() + dataLen;
-  for (const HIDMainItem& item : m_itemPool) {
-    if (item.IsConstant())
-      continue;
-    int32_t value = 0;
-    if (it != end) {
-      const HIDP_DATA& hidData = *it;
-      if (hidData.DataIndex == idx) {
-        value = hidData.RawValue;
-        ++it;
-      }
-    }
-    if (!valueCB(item, value))
-      return;
-    ++idx;
+    return {};
+
+  /* Data indices count the non-constant items, so they are value slots */
+  std::fill(values, values + m_valueCount, 0);
+  for (ULONG i = 0; i < dataLen; ++i) {
+    const HIDP_DATA& hidData = m_dataList[i];
+    if (hidData.DataIndex < m_valueCount)
+      values[hidData.DataIndex] = int32_t(hidData.RawValue);
   }
+  return {0, m_valueCount};
+#else
+  return {};
 #endif
 }
 #else
 
-class BitwiseIterator {
-  const uint8_t*& m_it;
-  const uint8_t* m_end;
-  int m_bit = 0;
-
-public:
-  BitwiseIterator(const uint8_t*& it, const uint8_t* end) : m_it(it), m_end(end) {}
-
-  uint32_t GetUnsignedValue(int numBits, HIDParser::ParserStatus& status) {
-    uint32_t val = 0;
-    for (int i = 0; i < numBits;) {
-      if (m_it >= m_end) {
-        status = HIDParser::ParserStatus::Error;
-        return 0;
-      }
-      int remBits = std::min(8 - m_bit, numBits - i);
-      val |= uint32_t((*m_it >> m_bit) & ((1 << remBits) - 1)) << i;
-      i += remBits;
-      m_bit += remBits;
-      if (m_bit == 8) {
-        m_bit = 0;
-        AdvanceIt(m_it, m_end, 1);
-      }
-    }
+namespace {
+/* Little-endian load of 8 report bytes, zero-filled past the end of the report.
+ * HID reports and every supported host are little-endian */
+uint64_t LoadReportBits(const uint8_t* data, size_t len, size_t offset) {
+  uint64_t val = 0;
+  if (offset + sizeof(val) <= len) {
+    std::memcpy(&val, data + offset, sizeof(val));
     return val;
   }
-};
-
-void HIDParser::ScanValues(const std::function<bool(const HIDMainItem& item, int32_t value)>& valueCB,
-                           const uint8_t* data, size_t len) const {
-  if (m_status != ParserStatus::Done)
-    return;
-
-  auto it = data;
-  auto end = data + len;
-  ParserStatus status = ParserStatus::OK;
-  uint8_t reportId = 0;
-  if (m_multipleReports)
-    reportId = GetByteValue(it, end, status);
-  if (status == ParserStatus::Error)
-    return;
+  if (len >= sizeof(val) && offset < len) {
+    /* Fields near the end: load the final 8 bytes and shift the overhang out */
+    std::memcpy(&val, data + len - sizeof(val), sizeof(val));
+    return val >> ((offset + sizeof(val) - len) * 8);
+  }
+  for (size_t i = 0; i < sizeof(val) && offset + i < len; ++i)
+    val |= uint64_t(data[offset + i]) << (i * 8);
+  return val;
+}
 
-  BitwiseIterator bitIt(it, end);
+/* Straight-line widening loops the compiler vectorizes */
+template <typename T>
+void DecodeRun(const uint8_t* src, uint32_t count, int32_t* out) {
+  for (uint32_t i = 0; i < count; ++i) {
+    if constexpr (sizeof(T) == 1)
+      out[i] = T(src[i]);
+    else
+      out[i] = T(src[i * 2] | src[i * 2 + 1] << 8);
+  }
+}
 
-  for (uint32_t i = m_inputReports.first; i < m_inputReports.second; ++i) {
-    const Report& rep = m_reportPool[i];
-    if (rep.first != reportId)
+void DecodeRun(const uint8_t* src, uint8_t width, bool isSigned, uint32_t count, int32_t* out) {
+  if (width == 1) {
+    if (isSigned)
+      DecodeRun<int8_t>(src, count, out);
+    else
+      DecodeRun<uint8_t>(src, count, out);
+  } else {
+    if (isSigned)
+      DecodeRun<int16_t>(src, count, out);
+    else
+      DecodeRun<uint16_t>(src, count, out);
+  }
+}
+} // Anonymous namespace
+
+std::pair<uint32_t, uint32_t> HIDParser::DecodeValues(const uint8_t* data, size_t len, int32_t* values) const {
+  if (m_status != ParserStatus::Done || len == 0)
+    return {};
+
+  const Layout& layout = *m_layout;
+  const uint32_t reportId = layout.m_multipleReports ? data[0] : 0;
+  const InputPlan* plan = nullptr;
+  for (uint32_t i = 0; i < layout.m_inputReports.second - layout.m_inputReports.first; ++i) {
+    if (layout.m_inputPlans[i].m_reportId == reportId) {
+      plan = &layout.m_inputPlans[i];
+      break;
+    }
+  }
+  if (!plan)
+    return {};
+
+  /* Short reports yield the values that arrived whole */
+  const bool complete = len >= plan->m_length;
+  for (uint32_t i = plan->m_ops.first; i < plan->m_ops.second; ++i) {
+    const ExtractOp& op = layout.m_opPool[i];
+    if (op.m_width) {
+      uint32_t count = op.m_count;
+      if (!complete && op.m_byteOffset + count * op.m_width > len) {
+        count = op.m_byteOffset < len ? uint32_t(len - op.m_byteOffset) / op.m_width : 0;
+        DecodeRun(data + op.m_byteOffset, op.m_width, op.m_signBit != 0, count, values + op.m_value);
+        return {plan->m_values.first, op.m_value + count};
+      }
+      DecodeRun(data + op.m_byteOffset, op.m_width, op.m_signBit != 0, count, values + op.m_value);
       continue;
-    for (uint32_t j = rep.second.first; j < rep.second.second; ++j) {
-      const HIDMainItem& item = m_itemPool[j];
-      int32_t val = bitIt.GetUnsignedValue(item.m_reportSize, status);
-      if (status == ParserStatus::Error)
-        return;
-      if (item.IsConstant())
-        continue;
-      if (!valueCB(item, val))
-        return;
     }
-    break;
+
+    if (!complete && op.m_byteOffset + (op.m_shift + std::bit_width(op.m_mask) + 7) / 8 > len)
+      return {plan->m_values.first, op.m_value};
+    const uint32_t val = uint32_t(LoadReportBits(data, len, op.m_byteOffset) >> op.m_shift) & op.m_mask;
+    values[op.m_value] = int32_t((val ^ op.m_signBit) - op.m_signBit);
   }
+
+  return plan->m_values;
 }
 #endif
 
+void HIDParser::ScanValues(const std::function<bool(const HIDMainItem& item, int32_t value)>& valueCB,
+                           const uint8_t* data, size_t len) const {
+  const auto range = DecodeValues(data, len, m_scanValues.get());
+  for (uint32_t i = range.first; i < range.second; ++i)
+    if (!valueCB(GetValueItem(i), m_scanValues[i]))
+      return;
+}
+
 } // namespace boo
@@ -28,6 +28,10 @@ class IHIDDevice : public std::enable_shared_from_this<IHIDDevice> {
   virtual size_t _receiveHIDReport(uint8_t* data, size_t length, HIDReportType tp, uint32_t message) = 0;
   virtual void _startThread() = 0;
 
+protected:
+  /** Record when the next report or transfer handed to dev arrived */
+  static void _stampReport(DeviceBase& dev, InputClock::time_point time) { dev.m_reportTime = time; }
+
 public:
   virtual ~IHIDDevice() = default;
 };
@@ -0,0 +1,204 @@
+#include "lib/inputdev/InputReactorUdev.hpp"
+
+#include <cerrno>
+#include <cstring>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <logvisor/logvisor.hpp>
+
+namespace boo {
+static logvisor::Module Log("boo::InputReactor");
+
+/* epoll tags carry the entry id with the low bit selecting its timerfd */
+static constexpr uint64_t FdTag(uint64_t id) { return id << 1; }
+static constexpr uint64_t TimerTag(uint64_t id) { return id << 1 | 1; }
+
+InputReactor& InputReactor::Get() {
+  static InputReactor reactor;
+  return reactor;
+}
+
+InputReactor::~InputReactor() {
+  std::unique_lock lk(m_lock);
+  if (m_thread.joinable())
+    _stop(lk);
+}
+
+void InputReactor::_unwatch(Entry& entry) {
+  if (entry.m_fd >= 0)
+    epoll_ctl(m_epoll, EPOLL_CTL_DEL, entry.m_fd, nullptr);
+  if (entry.m_timerFd >= 0) {
+    epoll_ctl(m_epoll, EPOLL_CTL_DEL, entry.m_timerFd, nullptr);
+    close(entry.m_timerFd);
+  }
+  entry.m_fd = entry.m_timerFd = -1;
+}
+
+void InputReactor::_dispatch(std::unique_lock<std::mutex>& lk, uint64_t tag, uint32_t events) {
+  const uint64_t id = tag >> 1;
+  auto search = m_entries.find(id);
+  if (search == m_entries.end())
+    return;
+
+  /* Sources may remove themselves (or others) from their callbacks. The lock is released so callbacks
+   * can block on their own locks; remove() of this entry from another thread waits for the return */
+  const std::shared_ptr<Source> source = search->second.m_source;
+  const int timerFd = search->second.m_timerFd;
+  m_dispatching = id;
+  m_dispatchThread = std::this_thread::get_id();
+  lk.unlock();
+  if (events == 0) {
+    source->reactorStart();
+  } else if (tag & 1) {
+    uint64_t expirations;
+    if (read(timerFd, &expirations, sizeof(expirations)) > 0)
+      source->reactorTimer();
+  } else {
+    source->reactorEvent(events);
+  }
+  lk.lock();
+  m_dispatching = 0;
+  m_dispatchDone.notify_all();
+}
+
+void InputReactor::_run(int epoll, int wakeFd) {
+  logvisor::RegisterThreadName("Boo Input");
+  epoll_event events[32];
+  std::vector<uint64_t> starting;
+  while (true) {
+    int count = epoll_wait(epoll, events, 32, -1);
+    if (count < 0) {
+      if (errno == EINTR)
+        continue;
+      Log.report(logvisor::Error, FMT_STRING("epoll_wait failed: {}"), strerror(errno));
+      return;
+    }
+
+    std::unique_lock lk(m_lock);
+    if (epoll != m_epoll)
+      return;
+
+    starting.swap(m_pendingStart);
+    for (uint64_t id : starting)
+      _dispatch(lk, FdTag(id), 0); /* No events runs reactorStart() */
+    starting.clear();
+
+    for (int i = 0; i < count; ++i) {
+      if (events[i].data.u64 == 0) {
+        uint64_t val;
+        [[maybe_unused]] ssize_t ret = read(wakeFd, &val, sizeof(val));
+        continue;
+      }
+      _dispatch(lk, events[i].data.u64, events[i].events);
+    }
+  }
+}
+
+bool InputReactor::_start() {
+  m_epoll = epoll_create1(EPOLL_CLOEXEC);
+  m_wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  epoll_event ev{};
+  ev.events = EPOLLIN;
+  ev.data.u64 = 0;
+  if (m_epoll < 0 || m_wakeFd < 0 || epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_wakeFd, &ev) < 0) {
+    Log.report(logvisor::Error, FMT_STRING("unable to create input epoll instance: {}"), strerror(errno));
+    if (m_epoll >= 0)
+      close(m_epoll);
+    if (m_wakeFd >= 0)
+      close(m_wakeFd);
+    m_epoll = m_wakeFd = -1;
+    return false;
+  }
+  m_thread = std::thread(&InputReactor::_run, this, m_epoll, m_wakeFd);
+  return true;
+}
+
+void InputReactor::_stop(std::unique_lock<std::mutex>& lk) {
+  const int epoll = m_epoll;
+  const int wakeFd = m_wakeFd;
+  m_epoll = m_wakeFd = -1;
+  const uint64_t val = 1;
+  [[maybe_unused]] ssize_t ret = write(wakeFd, &val, sizeof(val));
+  std::thread thread = std::move(m_thread);
+  lk.unlock();
+  thread.join();
+  close(epoll);
+  close(wakeFd);
+  lk.lock();
+}
+
+void InputReactor::_wake() {
+  const uint64_t val = 1;
+  [[maybe_unused]] ssize_t ret = write(m_wakeFd, &val, sizeof(val));
+}
+
+uint64_t InputReactor::add(std::shared_ptr<Source> source, int fd, uint32_t events,
+                           std::chrono::microseconds period) {
+  std::unique_lock lk(m_lock);
+  if (m_epoll < 0 && !_start())
+    return 0;
+
+  const uint64_t id = m_nextId++;
+  Entry entry;
+  entry.m_source = std::move(source);
+
+  if (fd >= 0) {
+    epoll_event ev{};
+    ev.events = events;
+    ev.data.u64 = FdTag(id);
+    if (epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &ev) < 0) {
+      Log.report(logvisor::Error, FMT_STRING("unable to watch input descriptor: {}"), strerror(errno));
+      return 0;
+    }
+    entry.m_fd = fd;
+  }
+
+  if (period.count() > 0) {
+    entry.m_timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    itimerspec spec{};
+    spec.it_interval.tv_sec = time_t(period.count() / 1000000);
+    spec.it_interval.tv_nsec = long(period.count() % 1000000) * 1000;
+    spec.it_value = spec.it_interval;
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.u64 = TimerTag(id);
+    if (entry.m_timerFd < 0 || timerfd_settime(entry.m_timerFd, 0, &spec, nullptr) < 0 ||
+        epoll_ctl(m_epoll, EPOLL_CTL_ADD, entry.m_timerFd, &ev) < 0) {
+      Log.report(logvisor::Error, FMT_STRING("unable to create input schedule: {}"), strerror(errno));
+      if (entry.m_timerFd >= 0)
+        close(entry.m_timerFd);
+      entry.m_timerFd = -1;
+      _unwatch(entry);
+      return 0;
+    }
+  }
+
+  /* Still under the lock, so the source knows its id before any callback */
+  entry.m_source->reactorAttached(id);
+  m_entries.emplace(id, std::move(entry));
+  m_pendingStart.push_back(id);
+  _wake();
+  return id;
+}
+
+std::shared_ptr<InputReactor::Source> InputReactor::remove(uint64_t id) {
+  std::unique_lock lk(m_lock);
+  m_dispatchDone.wait(lk, [&]() { return m_dispatching != id || m_dispatchThread == std::this_thread::get_id(); });
+  std::shared_ptr<Source> source;
+  auto search = m_entries.find(id);
+  if (search != m_entries.end()) {
+    _unwatch(search->second);
+    source = std::move(search->second.m_source);
+    m_entries.erase(search);
+  }
+  /* A source removed from within its own callback leaves the idle thread for reuse */
+  if (m_entries.empty() && m_thread.joinable() && m_thread.get_id() != std::this_thread::get_id())
+    _stop(lk);
+  return source;
+}
+
+} // namespace boo
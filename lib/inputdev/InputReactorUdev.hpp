@@ -0,0 +1,71 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace boo {
+
+/** One thread servicing every open udev input device through epoll.
+ *  A source registers a descriptor to watch and/or a period, which becomes a timerfd schedule.
+ *  Callbacks run on the reactor thread without the reactor's lock held, so they may take locks of their own
+ *  that other threads hold while calling add() or remove(); reactorStart() always comes first. Once remove()
+ *  returns the thread no longer touches the source, unless remove() was called from one of its own callbacks.
+ *  The thread starts with the first source and is joined once the last one is removed.
+ *  Each thread owns its epoll instance, so a thread still winding down never services newer sources */
+class InputReactor {
+public:
+  struct Source {
+    virtual ~Source() = default;
+    /** Called from add() with the new id before the reactor can dispatch to the source */
+    virtual void reactorAttached(uint64_t id) {}
+    virtual void reactorStart() {}
+    /** The watched descriptor signalled; events holds the EPOLL* flags */
+    virtual void reactorEvent(uint32_t events) {}
+    virtual void reactorTimer() {}
+  };
+
+private:
+  struct Entry {
+    std::shared_ptr<Source> m_source;
+    int m_fd = -1;
+    int m_timerFd = -1;
+  };
+
+  std::mutex m_lock;
+  std::unordered_map<uint64_t, Entry> m_entries;
+  std::vector<uint64_t> m_pendingStart;
+  /* Entry whose callback is running (with m_lock released); remove() waits it out */
+  uint64_t m_dispatching = 0;
+  std::thread::id m_dispatchThread;
+  std::condition_variable m_dispatchDone;
+  uint64_t m_nextId = 1; /* 0 tags the wakeup eventfd */
+  std::thread m_thread;
+  int m_epoll = -1;
+  int m_wakeFd = -1;
+
+  void _unwatch(Entry& entry);
+  void _dispatch(std::unique_lock<std::mutex>& lk, uint64_t tag, uint32_t events);
+  void _run(int epoll, int wakeFd);
+  bool _start();
+  void _stop(std::unique_lock<std::mutex>& lk);
+  void _wake();
+
+public:
+  static InputReactor& Get();
+  ~InputReactor();
+
+  /** Start servicing source. fd (if not -1) is watched for events; a non-zero period fires reactorTimer()
+   *  at that rate. Returns an id for remove(), or 0 on failure */
+  uint64_t add(std::shared_ptr<Source> source, int fd, uint32_t events, std::chrono::microseconds period);
+
+  /** Stop servicing; the source is returned so the caller controls where the reactor's reference is released */
+  std::shared_ptr<Source> remove(uint64_t id);
+};
+
+} // namespace boo
@@ -29,15 +29,21 @@ void NintendoPowerA::transferCycle() {
 
   NintendoPowerAState state;
   std::memcpy(&state, payload.data(), sizeof(state));
+  const InputClock::time_point time = reportTime();
+  m_history.record(time, state);
+  if (state == m_last) {
+    return;
+  }
+  m_last = state;
+  m_latestState.publish({time, state});
 
   std::lock_guard lk{m_callbackLock};
-  if (state != m_last && m_callback != nullptr) {
+  if (m_callback != nullptr) {
     m_callback->controllerUpdate(state);
   }
-  m_last = state;
 }
 
-void NintendoPowerA::finalCycle() {}
+void NintendoPowerA::finalCycle() { m_latestState.publish({InputClock::now(), NintendoPowerAState{}}); }
 
 void NintendoPowerA::receivedHIDReport(const uint8_t* data, size_t length, HIDReportType tp, uint32_t message) {}
 
@@ -56,14 +56,22 @@ static struct {int num_coefs; stage_fn_t fn; float att;} const half_firs[] = {
 
 #define FUNCTION vpoly0
 #define FIR_LENGTH VAR_LENGTH
+#if RATE_AVX2 /* 8-wide kernels from rate32avx2.c */
+#define CONVOLVE sum = poly0_avx2(&coef(p->shared->poly_fir_coefs, 0, FIR_LENGTH, rem, 0, 0), at, FIR_LENGTH), (void)j;
+#else
 #define CONVOLVE VAR_CONVOLVE
+#endif
 #include "poly-fir0.h"
 
 #define FUNCTION vpoly1
 #define COEF_INTERP 1
 #define PHASE_BITS VAR_POLY_PHASE_BITS
 #define FIR_LENGTH VAR_LENGTH
+#if RATE_AVX2
+#define CONVOLVE sum = poly1_avx2(&coef(p->shared->poly_fir_coefs, 1, FIR_LENGTH, phase, 1, 0), in, x, FIR_LENGTH), (void)j;
+#else
 #define CONVOLVE VAR_CONVOLVE
+#endif
 #include "poly-fir.h"
 
 #define FUNCTION vpoly2
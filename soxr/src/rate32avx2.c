@@ -0,0 +1,57 @@
+/* SoX Resampler Library      Copyright (c) 2007-13 robs@users.sourceforge.net
+ * Licence for this file: LGPL v2.1                  See LICENCE for details. */
+
+/* rate32s.c built with AVX2/FMA enabled and selected at run-time by soxr_create.
+ * The variable-length poly-phase stages used for rational and linearly
+ * interpolated ratios get 8-wide FMA kernels; DFT stages still use SSE pffft. */
+
+#include <immintrin.h>
+
+static float hsum_avx2(__m256 sum8)
+{
+  __m128 sum = _mm_add_ps(_mm256_castps256_ps128(sum8), _mm256_extractf128_ps(sum8, 1));
+  sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+  return _mm_cvtss_f32(_mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1)));
+}
+
+/* Non-interpolated: coefs of one phase are contiguous. */
+static float poly0_avx2(float const * c, float const * in, int n)
+{
+  __m256 sum8 = _mm256_setzero_ps();
+  float sum;
+  int j = 0;
+  for (; j + 8 <= n; j += 8)
+    sum8 = _mm256_fmadd_ps(_mm256_loadu_ps(c + j), _mm256_loadu_ps(in + j), sum8);
+  sum = hsum_avx2(sum8);
+  for (; j < n; ++j)
+    sum += c[j] * in[j];
+  return sum;
+}
+
+/* Linear coef interpolation: ba holds (b, a) pairs per tap; tap = b*x + a. */
+static float poly1_avx2(float const * ba, float const * in, float x, int n)
+{
+  __m256 x8 = _mm256_set1_ps(x), sum8 = _mm256_setzero_ps();
+  float sum;
+  int j = 0;
+  for (; j + 8 <= n; j += 8) {
+    __m256 lo = _mm256_loadu_ps(ba + 2 * j), hi = _mm256_loadu_ps(ba + 2 * j + 8);
+    __m256 b = _mm256_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0));
+    __m256 a = _mm256_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1));
+    b = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(b), _MM_SHUFFLE(3, 1, 2, 0)));
+    a = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(a), _MM_SHUFFLE(3, 1, 2, 0)));
+    sum8 = _mm256_fmadd_ps(_mm256_fmadd_ps(b, x8, a), _mm256_loadu_ps(in + j), sum8);
+  }
+  sum = hsum_avx2(sum8);
+  for (; j < n; ++j)
+    sum += (ba[2 * j] * x + ba[2 * j + 1]) * in[j];
+  return sum;
+}
+
+#define sample_t   float
+#define RATE_SIMD  1
+#define RATE_AVX2  1
+#define RDFT_CB    _soxr_rdft32s_cb
+#define RATE_CB    _soxr_rate32avx2_cb
+#define RATE_ID    "single-precision-SIMD-AVX2"
+#include "rate.h"
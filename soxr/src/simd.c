@@ -6,6 +6,15 @@
 #include <stdlib.h>
 #include "simd.h"
 #include "simd-dev.h"
+#include "soxr-config.h"
+
+#if HAVE_SIMD_AVX2
+#if defined _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
 
 #define SIMD_ALIGNMENT (sizeof(float) * 4)
 
@@ -82,3 +91,65 @@ void _soxr_ordered_partial_convolve_simd(int n, float * a, const float * b)
   a[0] = ab0;
   a[1] = b[n] * a[n] - b[n+1] * a[n+1];
 }
+
+
+
+#if HAVE_SIMD_AVX2
+static int cpu_has_avx2_fma(void)
+{
+  unsigned xcr0;
+#if defined _MSC_VER
+  int r[4];
+  __cpuid(r, 0);
+  if (r[0] < 7)
+    return 0;
+  __cpuid(r, 1);
+  /* FMA, OSXSAVE and AVX */
+  if ((r[2] & 0x18001000) != 0x18001000)
+    return 0;
+  __cpuidex(r, 7, 0);
+  if (!(r[1] & 0x20))
+    return 0;
+  xcr0 = (unsigned)_xgetbv(0);
+#else
+  unsigned eax, ebx, ecx, edx;
+  if (__get_cpuid_max(0, 0) < 7)
+    return 0;
+  __cpuid(1, eax, ebx, ecx, edx);
+  if ((ecx & 0x18001000) != 0x18001000)
+    return 0;
+  __cpuid_count(7, 0, eax, ebx, ecx, edx);
+  if (!(ebx & 0x20))
+    return 0;
+  __asm__ ("xgetbv" : "=a"(xcr0), "=d"(edx) : "c"(0));
+#endif
+  /* OS saves XMM and YMM state */
+  return (xcr0 & 6) == 6;
+}
+
+static int avx2_state = -1; /* -1: not yet probed */
+#endif
+
+
+
+int _soxr_simd_avx2(void)
+{
+#if HAVE_SIMD_AVX2
+  if (avx2_state < 0)
+    avx2_state = cpu_has_avx2_fma();
+  return avx2_state;
+#else
+  return 0;
+#endif
+}
+
+
+
+void _soxr_simd_disable_avx2(int disable)
+{
+#if HAVE_SIMD_AVX2
+  avx2_state = disable? 0 : cpu_has_avx2_fma();
+#else
+  (void)disable;
+#endif
+}
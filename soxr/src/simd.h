@@ -13,4 +13,9 @@ void _soxr_simd_aligned_free(void *);
 void _soxr_ordered_convolve_simd(int n, void * not_used, float * a, const float * b);
 void _soxr_ordered_partial_convolve_simd(int n, float * a, const float * b);
 
+/* Run-time kernel selection: nonzero when the AVX2/FMA builds may be used.
+ * _soxr_simd_disable_avx2 forces the SSE kernels (e.g. for benchmarking). */
+int _soxr_simd_avx2(void);
+void _soxr_simd_disable_avx2(int disable);
+
 #endif
@@ -9,6 +9,7 @@
 #include "soxr.h"
 #include "data-io.h"
 #include "internal.h"
+#include "simd.h"
 
 
 
@@ -196,6 +197,9 @@ static bool cpu_has_simd(void)
 #endif
 
 extern control_block_t _soxr_rate32s_cb, _soxr_rate32_cb, _soxr_rate64_cb, _soxr_vr32_cb;
+#if HAVE_SIMD_AVX2
+extern control_block_t _soxr_rate32avx2_cb, _soxr_vr32avx2_cb;
+#endif
 
 
 
@@ -246,6 +250,9 @@ soxr_t soxr_create(
       p->deinterleave = (deinterleave_t)_soxr_deinterleave_f;
       p->interleave = (interleave_t)_soxr_interleave_f;
       memcpy(&p->control_block,
+#if HAVE_SIMD_AVX2
+          _soxr_simd_avx2()? ((p->q_spec.flags & SOXR_VR)? &_soxr_vr32avx2_cb : &_soxr_rate32avx2_cb) :
+#endif
           (p->q_spec.flags & SOXR_VR)? &_soxr_vr32_cb :
 #if HAVE_SIMD
           cpu_has_simd()? &_soxr_rate32s_cb :
@@ -0,0 +1,9 @@
+/* SoX Resampler Library      Copyright (c) 2007-13 robs@users.sourceforge.net
+ * Licence for this file: LGPL v2.1                  See LICENCE for details. */
+
+/* Variable-rate resampling; AVX2/FMA build, selected at run-time by soxr_create. */
+
+#define VR_AVX2 1
+#define VR_CB   _soxr_vr32avx2_cb
+#define VR_ID   "single-precision variable-rate AVX2"
+#include "vr32s.c"
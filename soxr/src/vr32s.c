@@ -3,6 +3,14 @@
 
 /* Variable-rate resampling. */
 
+/* Built twice on x86-64: as-is for SSE, and from vr32avx2.c with VR_AVX2 set
+ * (compiled with AVX2/FMA enabled) where the half-band and poly-phase FIRs
+ * run 8 taps per FMA. */
+#if !defined VR_CB
+#define VR_CB _soxr_vr32_cb
+#define VR_ID "single-precision variable-rate"
+#endif
+
 #include <assert.h>
 #include <math.h>
 #if !defined M_PI
@@ -13,7 +21,9 @@
 #endif
 #include <string.h>
 #include <stdlib.h>
-#if defined(__x86_64__) || defined(_M_X64)
+#if VR_AVX2
+#include <immintrin.h>
+#elif defined(__x86_64__) || defined(_M_X64)
 #include <xmmintrin.h>
 #elif defined(__ARM_NEON)
 #include "sse2neon.h"
@@ -47,6 +57,56 @@
 #define HALF_FIR_LEN_2 (iAL(half_fir_coefs) - 1)
 #define HALF_FIR_LEN_4 (HALF_FIR_LEN_2 / 2)
 
+#if VR_AVX2
+/* Even and odd half-band taps for the x2 up-sampling stage, zero-padded to a
+ * multiple of 8 (inputs have at least HALF_FIR_LEN_2 samples either side). */
+#define DOUBLE_FIR_LEN_8 ((HALF_FIR_LEN_4 + 7) & ~7)
+static float double_fir_coefs0[DOUBLE_FIR_LEN_8];
+static float double_fir_coefs1[DOUBLE_FIR_LEN_8];
+
+static void prepare_double_fir_coefs(void)
+{
+  int i;
+  for (i = 0; i < HALF_FIR_LEN_4; ++i) {
+    double_fir_coefs0[i] = half_fir_coefs[2*i+2];
+    double_fir_coefs1[i] = half_fir_coefs[2*i+1];
+  }
+}
+
+/* Symmetric FIR, 8 taps per step: sum of (fwd[k] + bwd[-k]) * h[k] for k < n. */
+static float sym_fir_avx2(float const * fwd, float const * bwd, float const * h, int n)
+{
+  __m256i const rev = _mm256_set_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  __m256 sum = _mm256_setzero_ps();
+  __m128 sum4;
+  int k;
+  for (k = 0; k < n; k += 8) {
+    __m256 b = _mm256_permutevar8x32_ps(_mm256_loadu_ps(bwd - k - 7), rev);
+    sum = _mm256_fmadd_ps(_mm256_add_ps(_mm256_loadu_ps(fwd + k), b), _mm256_loadu_ps(h + k), sum);
+  }
+  sum4 = _mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1));
+  sum4 = _mm_add_ps(sum4, _mm_movehl_ps(sum4, sum4));
+  return _mm_cvtss_f32(_mm_add_ss(sum4, _mm_shuffle_ps(sum4, sum4, 1)));
+}
+
+static float half_fir(float const * input)
+{
+  assert(!(HALF_FIR_LEN_2 & 7));
+  return input[0] * half_fir_coefs[0] + sym_fir_avx2(input + 1, input - 1, half_fir_coefs + 1, HALF_FIR_LEN_2);
+}
+
+static float double_fir0(float const * input)
+{
+  float sum = input[0] * half_fir_coefs[0];
+  sum += sym_fir_avx2(input + 1, input - 1, double_fir_coefs0, DOUBLE_FIR_LEN_8);
+  return sum * 2;
+}
+
+static float double_fir1(float const * input)
+{
+  return sym_fir_avx2(input + 1, input, double_fir_coefs1, DOUBLE_FIR_LEN_8) * 2;
+}
+#else
 #define _ sum += (input[-i] + input[i]) * half_fir_coefs[i], ++i;
 static float half_fir(float const * input)
 {
@@ -79,6 +139,7 @@ static float double_fir1(float const * input)
   return (float)(sum * 2);
 }
 #undef _
+#endif
 
 static float fast_half_fir(float const * input)
 {
@@ -170,6 +231,34 @@ static void prepare_coefs(__m128 * coefs_a, __m128 * coefs_b,
 static __m128 poly_fir_coefs_d_a[POLY_FIR_LEN_D_VEC * PHASES_D];
 static __m128 poly_fir_coefs_d_b[POLY_FIR_LEN_D_VEC * PHASES_D];
 
+#if VR_AVX2
+/* Coefficient vectors of one phase are contiguous, so pairs load as one __m256. */
+#define AVX2_TAPS8(sum8, a8, b8, x8, in) \
+    sum8 = _mm256_fmadd_ps(_mm256_fmadd_ps(_mm256_loadu_ps(b8), x8, _mm256_loadu_ps(a8)), _mm256_loadu_ps(in), sum8)
+#define AVX2_TAPS4(sum4, a4, b4, x4, in) \
+    sum4 = _mm_fmadd_ps(_mm_fmadd_ps(_mm_load_ps(b4), x4, _mm_load_ps(a4)), _mm_loadu_ps(in), sum4)
+
+static float avx2_hsum(__m256 sum8, __m128 sum4)
+{
+  __m128 sum = _mm_add_ps(sum4, _mm_add_ps(_mm256_castps256_ps128(sum8), _mm256_extractf128_ps(sum8, 1)));
+  sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+  return _mm_cvtss_f32(_mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1)));
+}
+
+static float poly_fir1_d(float const * input, uint32_t frac)
+{
+  int phase = (int)(frac >> (32 - PHASE_BITS_D));
+  float const * ca = (float const *)&coefs(poly_fir_coefs_d_a, POLY_FIR_LEN_D_VEC, phase, 0);
+  float const * cb = (float const *)&coefs(poly_fir_coefs_d_b, POLY_FIR_LEN_D_VEC, phase, 0);
+  __m256 x8 = _mm256_set1_ps((float)(frac << PHASE_BITS_D) * (float)(1 / MULT32));
+  __m256 sum8 = _mm256_setzero_ps();
+  __m128 sum4 = _mm_setzero_ps();
+  AVX2_TAPS8(sum8, ca, cb, x8, input);
+  AVX2_TAPS8(sum8, ca + 8, cb + 8, x8, input + 8);
+  AVX2_TAPS4(sum4, ca + 16, cb + 16, _mm256_castps256_ps128(x8), input + 16);
+  return avx2_hsum(sum8, sum4);
+}
+#else
 static float poly_fir1_d(float const * input, uint32_t frac)
 {
   int i = 0, phase = (int)(frac >> (32 - PHASE_BITS_D));
@@ -178,6 +267,7 @@ static float poly_fir1_d(float const * input, uint32_t frac)
   assert(i == POLY_FIR_LEN_D_VEC);
   return ((float*)&sum)[0] + ((float*)&sum)[1] + ((float*)&sum)[2] + ((float*)&sum)[3];
 }
+#endif
 #undef a
 #undef b
 #define a (coefs(poly_fir_coefs_u_a, POLY_FIR_LEN_U_VEC, phase, i))
@@ -185,6 +275,22 @@ static float poly_fir1_d(float const * input, uint32_t frac)
 static __m128 poly_fir_coefs_u_a[POLY_FIR_LEN_U_VEC * PHASES_U];
 static __m128 poly_fir_coefs_u_b[POLY_FIR_LEN_U_VEC * PHASES_U];
 
+#if VR_AVX2
+static float poly_fir1_u(float const * input, uint32_t frac)
+{
+  int phase = (int)(frac >> (32 - PHASE_BITS_U));
+  float const * ca = (float const *)&coefs(poly_fir_coefs_u_a, POLY_FIR_LEN_U_VEC, phase, 0);
+  float const * cb = (float const *)&coefs(poly_fir_coefs_u_b, POLY_FIR_LEN_U_VEC, phase, 0);
+  __m256 x8 = _mm256_set1_ps((float)(frac << PHASE_BITS_U) * (float)(1 / MULT32));
+  __m256 sum8 = _mm256_setzero_ps();
+  __m128 sum4 = _mm_setzero_ps();
+  AVX2_TAPS8(sum8, ca, cb, x8, input);
+  AVX2_TAPS4(sum4, ca + 8, cb + 8, _mm256_castps256_ps128(x8), input + 8);
+  return avx2_hsum(sum8, sum4);
+}
+#undef AVX2_TAPS8
+#undef AVX2_TAPS4
+#else
 static float poly_fir1_u(float const * input, uint32_t frac)
 {
   int i = 0, phase = (int)(frac >> (32 - PHASE_BITS_U));
@@ -193,6 +299,7 @@ static float poly_fir1_u(float const * input, uint32_t frac)
   assert(i == POLY_FIR_LEN_U_VEC);
   return ((float*)&sum)[0] + ((float*)&sum)[1] + ((float*)&sum)[2] + ((float*)&sum)[3];
 }
+#endif
 #undef a
 #undef b
 #undef _
@@ -329,6 +436,9 @@ static void vr_init(rate_t * p, double default_io_ratio, int num_stages, double
       fade_coefs[i] = (float)(.5 * (1 + cos(M_PI * i / (AL(fade_coefs) - 1))));
     prepare_coefs(poly_fir_coefs_u_a, poly_fir_coefs_u_b, POLY_FIR_LEN_U, PHASES0_U, PHASES_U, coefs0_u, mult);
     prepare_coefs(poly_fir_coefs_d_a, poly_fir_coefs_d_b, POLY_FIR_LEN_D, PHASES0_D, PHASES_D, coefs0_d, mult *.5);
+#if VR_AVX2
+    prepare_double_fir_coefs();
+#endif
   }
   assert(fade_coefs[0]);
 }
@@ -647,11 +757,11 @@ static char const * vr_create(void * channel, void * shared,double max_io_ratio,
 
 static char const * vr_id(void)
 {
-  return "single-precision variable-rate";
+  return VR_ID;
 }
 
 typedef void (* fn_t)(void);
-fn_t _soxr_vr32_cb[] = {
+fn_t VR_CB[] = {
   (fn_t)vr_input,
   (fn_t)vr_process,
   (fn_t)vr_output,
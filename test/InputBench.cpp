@@ -0,0 +1,334 @@
+/* Times the input-thread parsers against captured and synthesized corpora, without hardware:
+ * MIDIDecoder over dense running-status streams, HIDParser descriptor parsing, report scanning
+ * and decoding, DualshockPad and DolphinSmashAdapter report handling. Reports ns per report
+ * (or message), ns per byte and heap allocations per call. */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <span>
+#include <vector>
+
+#include <boo/audiodev/IMIDIReader.hpp>
+#include <boo/audiodev/MIDIDecoder.hpp>
+#include <boo/inputdev/DolphinSmashAdapter.hpp>
+#include <boo/inputdev/DualshockPad.hpp>
+#include <boo/inputdev/HIDParser.hpp>
+
+#undef min
+#undef max
+
+namespace {
+std::atomic<size_t> Allocations{0};
+} // Anonymous namespace
+
+void* operator new(std::size_t size) {
+  Allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* ptr = std::malloc(size ? size : 1))
+    return ptr;
+  throw std::bad_alloc();
+}
+void* operator new[](std::size_t size) { return operator new(size); }
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+namespace {
+constexpr int Repeats = 5;
+volatile int64_t Sink = 0; /* Keeps callback work from being optimized out */
+constexpr double MinRunMs = 20.0;
+
+/* Sony Sixaxis / DualShock 3 (054c:0268) report descriptor */
+constexpr uint8_t DS3Descriptor[] = {
+    0x05, 0x01, 0x09, 0x04, 0xA1, 0x01, 0xA1, 0x02, 0x85, 0x01, 0x75, 0x08, 0x95, 0x01, 0x15, 0x00, 0x26, 0xFF,
+    0x00, 0x81, 0x03, 0x75, 0x01, 0x95, 0x13, 0x15, 0x00, 0x25, 0x01, 0x35, 0x00, 0x45, 0x01, 0x05, 0x09, 0x19,
+    0x01, 0x29, 0x13, 0x81, 0x02, 0x75, 0x01, 0x95, 0x0D, 0x06, 0x00, 0xFF, 0x81, 0x03, 0x15, 0x00, 0x26, 0xFF,
+    0x00, 0x05, 0x01, 0x09, 0x01, 0xA1, 0x00, 0x75, 0x08, 0x95, 0x04, 0x35, 0x00, 0x46, 0xFF, 0x00, 0x09, 0x30,
+    0x09, 0x31, 0x09, 0x32, 0x09, 0x35, 0x81, 0x02, 0xC0, 0x05, 0x01, 0x95, 0x13, 0x09, 0x01, 0x81, 0x02, 0x95,
+    0x0C, 0x81, 0x01, 0x75, 0x10, 0x95, 0x04, 0x26, 0xFF, 0x03, 0x46, 0xFF, 0x03, 0x09, 0x01, 0x81, 0x02, 0xC0,
+    0xA1, 0x02, 0x85, 0x02, 0x75, 0x08, 0x95, 0x30, 0x09, 0x01, 0xB1, 0x02, 0xC0, 0xA1, 0x02, 0x85, 0xEE, 0x75,
+    0x08, 0x95, 0x30, 0x09, 0x01, 0xB1, 0x02, 0xC0, 0xA1, 0x02, 0x85, 0xEF, 0x75, 0x08, 0x95, 0x30, 0x09, 0x01,
+    0xB1, 0x02, 0xC0, 0xC0};
+
+/* DragonRise generic USB gamepad (0079:0006): 5 byte axes, hat, 12 buttons, no report ID */
+constexpr uint8_t DragonRiseDescriptor[] = {
+    0x05, 0x01, 0x09, 0x04, 0xA1, 0x01, 0xA1, 0x02, 0x75, 0x08, 0x95, 0x05, 0x15, 0x00, 0x26, 0xFF, 0x00, 0x35,
+    0x00, 0x46, 0xFF, 0x00, 0x09, 0x30, 0x09, 0x30, 0x09, 0x30, 0x09, 0x30, 0x09, 0x31, 0x81, 0x02, 0x75, 0x04,
+    0x95, 0x01, 0x25, 0x07, 0x46, 0x3B, 0x01, 0x65, 0x14, 0x09, 0x39, 0x81, 0x42, 0x65, 0x00, 0x75, 0x01, 0x95,
+    0x0C, 0x25, 0x01, 0x45, 0x01, 0x05, 0x09, 0x19, 0x01, 0x29, 0x0C, 0x81, 0x02, 0x06, 0x00, 0xFF, 0x75, 0x01,
+    0x95, 0x08, 0x25, 0x01, 0x45, 0x01, 0x09, 0x01, 0x81, 0x02, 0xC0, 0xA1, 0x02, 0x75, 0x08, 0x95, 0x07, 0x46,
+    0xFF, 0x00, 0x26, 0xFF, 0x00, 0x09, 0x02, 0x91, 0x02, 0xC0, 0xC0};
+
+/* XInput-style HID gamepad: report ID 1, four 16-bit sticks, two 10-bit triggers, 16 buttons, hat */
+constexpr uint8_t Generic16Descriptor[] = {
+    0x05, 0x01, 0x09, 0x05, 0xA1, 0x01, 0x85, 0x01, 0x09, 0x01, 0xA1, 0x00, 0x09, 0x30, 0x09, 0x31, 0x09, 0x33,
+    0x09, 0x34, 0x15, 0x00, 0x27, 0xFF, 0xFF, 0x00, 0x00, 0x75, 0x10, 0x95, 0x04, 0x81, 0x02, 0xC0, 0x09, 0x32,
+    0x09, 0x35, 0x26, 0xFF, 0x03, 0x75, 0x0A, 0x95, 0x02, 0x81, 0x02, 0x75, 0x04, 0x95, 0x01, 0x81, 0x03, 0x05,
+    0x09, 0x19, 0x01, 0x29, 0x10, 0x15, 0x00, 0x25, 0x01, 0x75, 0x01, 0x95, 0x10, 0x81, 0x02, 0x05, 0x01, 0x09,
+    0x39, 0x15, 0x01, 0x25, 0x08, 0x35, 0x00, 0x46, 0x3B, 0x01, 0x65, 0x14, 0x75, 0x04, 0x95, 0x01, 0x81, 0x42,
+    0x65, 0x00, 0x75, 0x04, 0x95, 0x01, 0x81, 0x03, 0xC0};
+
+constexpr size_t CorpusReports = 4096;
+
+struct Rng {
+  uint32_t m_seed = 1;
+  uint8_t next() {
+    m_seed = m_seed * 1664525u + 1013904223u;
+    return uint8_t(m_seed >> 24);
+  }
+};
+
+/* Reports with slowly drifting sticks and occasional button changes, like a player moving */
+std::vector<std::vector<uint8_t>> MakeReports(size_t length, int reportId, Rng& rng) {
+  std::vector<std::vector<uint8_t>> reports(CorpusReports, std::vector<uint8_t>(length));
+  std::vector<uint8_t> cur(length, 0x80);
+  for (auto& report : reports) {
+    for (size_t i = 0; i < length; ++i)
+      if ((rng.next() & 0x7) == 0)
+        cur[i] = uint8_t(cur[i] + (rng.next() & 0x7) - 3);
+    report = cur;
+    if (reportId >= 0)
+      report[0] = uint8_t(reportId);
+  }
+  return reports;
+}
+
+std::vector<std::vector<uint8_t>> MakeGCAdapterPayloads(Rng& rng) {
+  auto payloads = MakeReports(37, 0x21, rng);
+  for (auto& payload : payloads)
+    for (size_t c = 0; c < 4; ++c)
+      payload[1 + c * 9] = c < 2 ? 0x10 : 0x00; /* Two wired controllers plugged in */
+  return payloads;
+}
+
+/* Dense controller automation on all channels under running status, with clock ticks and notes mixed in */
+std::vector<uint8_t> MakeDenseCCStream(Rng& rng) {
+  std::vector<uint8_t> stream;
+  for (int run = 0; run < 512; ++run) {
+    const uint8_t chan = run & 0xf;
+    stream.push_back(0xB0 | chan);
+    for (int i = 0; i < 48; ++i) {
+      stream.push_back(rng.next() & 0x7f);
+      stream.push_back(rng.next() & 0x7f);
+      if (i % 16 == 15)
+        stream.push_back(0xF8);
+    }
+    stream.insert(stream.end(), {uint8_t(0x90 | chan), 60, 100, uint8_t(0xE0 | chan), 0x00, 0x40});
+  }
+  return stream;
+}
+
+struct NullMIDIReader : boo::IMIDIReader {
+  size_t m_messages = 0;
+  void noteOff(uint8_t, uint8_t, uint8_t) override { ++m_messages; }
+  void noteOn(uint8_t, uint8_t, uint8_t) override { ++m_messages; }
+  void notePressure(uint8_t, uint8_t, uint8_t) override { ++m_messages; }
+  void controlChange(uint8_t, uint8_t, uint8_t) override { ++m_messages; }
+  void programChange(uint8_t, uint8_t) override { ++m_messages; }
+  void channelPressure(uint8_t, uint8_t) override { ++m_messages; }
+  void pitchBend(uint8_t, int16_t) override { ++m_messages; }
+  void allSoundOff(uint8_t) override { ++m_messages; }
+  void resetAllControllers(uint8_t) override { ++m_messages; }
+  void localControl(uint8_t, bool) override { ++m_messages; }
+  void allNotesOff(uint8_t) override { ++m_messages; }
+  void omniMode(uint8_t, bool) override { ++m_messages; }
+  void polyMode(uint8_t, bool) override { ++m_messages; }
+  void sysex(const void*, size_t) override { ++m_messages; }
+  void timeCodeQuarterFrame(uint8_t, uint8_t) override { ++m_messages; }
+  void songPositionPointer(uint16_t) override { ++m_messages; }
+  void songSelect(uint8_t) override { ++m_messages; }
+  void tuneRequest() override { ++m_messages; }
+  void startSeq() override { ++m_messages; }
+  void continueSeq() override { ++m_messages; }
+  void stopSeq() override { ++m_messages; }
+  void reset() override { ++m_messages; }
+};
+
+/* One pass over a corpus; returns {items, bytes, calls} for normalizing */
+struct Pass {
+  size_t m_items = 0;
+  size_t m_bytes = 0;
+  size_t m_calls = 0;
+};
+
+template <typename Func>
+void Measure(const char* name, Func&& func) {
+  double bestNs = 0.0;
+  Pass pass;
+  size_t allocs = 0;
+  for (int r = 0; r < Repeats; ++r) {
+    size_t iters = 0;
+    const size_t allocStart = Allocations.load(std::memory_order_relaxed);
+    const auto start = std::chrono::steady_clock::now();
+    double ms;
+    do {
+      pass = func();
+      ++iters;
+      ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    } while (ms < MinRunMs);
+    const size_t runAllocs = Allocations.load(std::memory_order_relaxed) - allocStart;
+    const double ns = ms * 1.0e6 / double(iters);
+    if (r == 0 || ns < bestNs) {
+      bestNs = ns;
+      allocs = runAllocs / iters;
+    }
+  }
+  std::printf("  %-40s %9.1f ns/item %8.2f ns/byte %8.2f allocs/call\n", name, bestNs / double(pass.m_items),
+              bestNs / double(pass.m_bytes), double(allocs) / double(pass.m_calls));
+}
+
+void BenchMIDI(const std::vector<uint8_t>& stream, size_t chunk) {
+  NullMIDIReader reader;
+  boo::MIDIDecoder decoder(reader);
+  std::vector<uint8_t> buf;
+  buf.reserve(chunk + 3);
+  char name[64];
+  std::snprintf(name, sizeof(name), "MIDIDecoder, %zu-byte reads", chunk);
+  Measure(name, [&]() {
+    reader.m_messages = 0;
+    Pass pass;
+    size_t carry = 0;
+    for (size_t off = 0; off < stream.size(); off += chunk) {
+      /* A trailing incomplete message is carried into the next read, as a client would */
+      const size_t len = std::min(chunk, stream.size() - off);
+      buf.resize(carry + len);
+      std::memcpy(buf.data() + carry, stream.data() + off, len);
+      const size_t used = decoder.receiveBytes(std::span<const uint8_t>(buf));
+      carry = buf.size() - used;
+      std::memmove(buf.data(), buf.data() + used, carry);
+      ++pass.m_calls;
+    }
+    pass.m_items = reader.m_messages;
+    pass.m_bytes = stream.size();
+    return pass;
+  });
+}
+
+#if !_WIN32
+void BenchHIDParse(const char* device, const uint8_t* desc, size_t len) {
+  char name[64];
+  std::snprintf(name, sizeof(name), "HIDParser::Parse, %s", device);
+  Measure(name, [&]() {
+    boo::HIDParser parser;
+    parser.Parse(desc, len);
+    return Pass{1, len, 1};
+  });
+}
+
+void BenchHIDScan(const char* device, const uint8_t* desc, size_t len,
+                  const std::vector<std::vector<uint8_t>>& reports) {
+  boo::HIDParser parser;
+  if (parser.Parse(desc, len) != boo::HIDParser::ParserStatus::Done) {
+    std::printf("  %s descriptor failed to parse\n", device);
+    return;
+  }
+  const std::function<bool(const boo::HIDMainItem&, int32_t)> func = [](const boo::HIDMainItem&, int32_t value) {
+    Sink = Sink + value;
+    return true;
+  };
+  char name[64];
+  std::snprintf(name, sizeof(name), "HIDParser::ScanValues, %s", device);
+  Measure(name, [&]() {
+    Pass pass;
+    for (const auto& report : reports) {
+      parser.ScanValues(func, report.data(), report.size());
+      pass.m_bytes += report.size();
+    }
+    pass.m_items = pass.m_calls = reports.size();
+    return pass;
+  });
+
+  std::vector<int32_t> values(parser.GetValueCount());
+  std::snprintf(name, sizeof(name), "HIDParser::DecodeValues, %s", device);
+  Measure(name, [&]() {
+    Pass pass;
+    for (const auto& report : reports) {
+      const auto range = parser.DecodeValues(report.data(), report.size(), values.data());
+      for (uint32_t i = range.first; i < range.second; ++i)
+        Sink = Sink + values[i];
+      pass.m_bytes += report.size();
+    }
+    pass.m_items = pass.m_calls = reports.size();
+    return pass;
+  });
+}
+#endif
+
+struct NullDualshockCallback : boo::IDualshockPadCallback {
+  void controllerUpdate(boo::DualshockPad&, const boo::DualshockPadState& state) override {
+    Sink = Sink + int64_t(state.accPitch);
+  }
+};
+
+struct NullDolphinCallback : boo::IDolphinSmashAdapterCallback {
+  void controllerUpdate(unsigned, boo::EDolphinControllerType, const boo::DolphinControllerState& state) override {
+    Sink = Sink + state.m_btns;
+  }
+};
+} // Anonymous namespace
+
+int main() {
+  Rng rng;
+
+  std::printf("MIDI:\n");
+  const std::vector<uint8_t> ccStream = MakeDenseCCStream(rng);
+  for (size_t chunk : {3, 64, 1024})
+    BenchMIDI(ccStream, chunk);
+
+  const auto ds3Reports = MakeReports(49, 0x01, rng);
+  const auto dragonRiseReports = MakeReports(8, -1, rng);
+  const auto generic16Reports = MakeReports(15, 0x01, rng);
+  const auto gcPayloads = MakeGCAdapterPayloads(rng);
+
+#if !_WIN32
+  std::printf("HID descriptors:\n");
+  BenchHIDParse("DualShock 3", DS3Descriptor, sizeof(DS3Descriptor));
+  BenchHIDParse("DragonRise", DragonRiseDescriptor, sizeof(DragonRiseDescriptor));
+  BenchHIDParse("16-bit gamepad", Generic16Descriptor, sizeof(Generic16Descriptor));
+
+  std::printf("HID reports:\n");
+  BenchHIDScan("DualShock 3", DS3Descriptor, sizeof(DS3Descriptor), ds3Reports);
+  BenchHIDScan("DragonRise", DragonRiseDescriptor, sizeof(DragonRiseDescriptor), dragonRiseReports);
+  BenchHIDScan("16-bit gamepad", Generic16Descriptor, sizeof(Generic16Descriptor), generic16Reports);
+#endif
+
+  std::printf("Device report handlers:\n");
+  {
+    NullDualshockCallback cb;
+    boo::DualshockPad pad(nullptr);
+    pad.setCallback(&cb);
+    boo::DeviceBase& base = pad; /* The override is private; reports arrive through the base interface */
+    Measure("DualshockPad::receivedHIDReport", [&]() {
+      Pass pass;
+      for (const auto& report : ds3Reports) {
+        base.receivedHIDReport(report.data(), report.size(), boo::HIDReportType::Input, 1);
+        pass.m_bytes += report.size();
+      }
+      pass.m_items = pass.m_calls = ds3Reports.size();
+      return pass;
+    });
+  }
+  {
+    NullDolphinCallback cb;
+    boo::DolphinSmashAdapter adapter(nullptr);
+    adapter.setCallback(&cb);
+    Measure("DolphinSmashAdapter::receivedPayload", [&]() {
+      Pass pass;
+      for (const auto& payload : gcPayloads) {
+        adapter.receivedPayload(payload.data(), payload.size());
+        pass.m_bytes += payload.size();
+      }
+      pass.m_items = pass.m_calls = gcPayloads.size();
+      return pass;
+    });
+  }
+
+  return 0;
+}
@@ -0,0 +1,136 @@
+/* Checks MIDIFile seek chasing against a small in-memory SMF: bank select must precede the program
+ * change it selects, and channel mode messages (CC 120-127) are neither chased nor allowed to undo
+ * the controllers recorded after them. Also checks that MIDIDecoder skips real-time bytes interleaved
+ * with a message's data bytes. Exits non-zero if any check fails. */
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <boo/audiodev/IMIDIReader.hpp>
+#include <boo/audiodev/MIDIDecoder.hpp>
+#include <boo/audiodev/MIDIFile.hpp>
+
+namespace {
+bool Failed = false;
+
+void Check(bool cond, const char* what) {
+  if (!cond) {
+    std::fprintf(stderr, "FAILED: %s\n", what);
+    Failed = true;
+  }
+}
+
+/* Records each call as text so sequences compare directly */
+struct RecordingReader : boo::IMIDIReader {
+  std::vector<std::string> m_calls;
+
+  void add(const char* fmt, int a, int b = 0, int c = 0) {
+    char buf[64];
+    std::snprintf(buf, sizeof(buf), fmt, a, b, c);
+    m_calls.emplace_back(buf);
+  }
+
+  void noteOff(uint8_t chan, uint8_t key, uint8_t velocity) override { add("off %d %d %d", chan, key, velocity); }
+  void noteOn(uint8_t chan, uint8_t key, uint8_t velocity) override { add("on %d %d %d", chan, key, velocity); }
+  void notePressure(uint8_t chan, uint8_t key, uint8_t pressure) override { add("kp %d %d %d", chan, key, pressure); }
+  void controlChange(uint8_t chan, uint8_t control, uint8_t value) override { add("cc %d %d %d", chan, control, value); }
+  void programChange(uint8_t chan, uint8_t program) override { add("pc %d %d", chan, program); }
+  void channelPressure(uint8_t chan, uint8_t pressure) override { add("cp %d %d", chan, pressure); }
+  void pitchBend(uint8_t chan, int16_t pitch) override { add("pb %d %d", chan, pitch); }
+  void allSoundOff(uint8_t chan) override { add("allSoundOff %d", chan); }
+  void resetAllControllers(uint8_t chan) override { add("resetAllControllers %d", chan); }
+  void localControl(uint8_t chan, bool on) override { add("localControl %d %d", chan, on); }
+  void allNotesOff(uint8_t chan) override { add("allNotesOff %d", chan); }
+  void omniMode(uint8_t chan, bool on) override { add("omniMode %d %d", chan, on); }
+  void polyMode(uint8_t chan, bool on) override { add("polyMode %d %d", chan, on); }
+  void sysex(const void*, size_t len) override { add("sysex %d", int(len)); }
+  void timeCodeQuarterFrame(uint8_t message, uint8_t value) override { add("mtc %d %d", message, value); }
+  void songPositionPointer(uint16_t pointer) override { add("spp %d", pointer); }
+  void songSelect(uint8_t song) override { add("song %d", song); }
+  void tuneRequest() override { add("tune", 0); }
+  void startSeq() override { add("start", 0); }
+  void continueSeq() override { add("continue", 0); }
+  void stopSeq() override { add("stop", 0); }
+  void reset() override { add("reset", 0); }
+};
+
+/* Format 0 file, 96 ticks per quarter at the default 120 BPM, holding one track of (delta, bytes) events */
+std::vector<uint8_t> MakeSMF(const std::vector<uint8_t>& track) {
+  std::vector<uint8_t> smf = {'M', 'T', 'h', 'd', 0, 0, 0, 6, 0, 0, 0, 1, 0, 96, 'M', 'T', 'r', 'k'};
+  const uint32_t len = uint32_t(track.size() + 4);
+  smf.insert(smf.end(), {uint8_t(len >> 24), uint8_t(len >> 16), uint8_t(len >> 8), uint8_t(len)});
+  smf.insert(smf.end(), track.begin(), track.end());
+  smf.insert(smf.end(), {0, 0xff, 0x2f, 0});
+  return smf;
+}
+
+void TestSeekChase() {
+  /* Everything at tick 0 except a note half a second later */
+  const std::vector<uint8_t> smf = MakeSMF({
+      0, 0xb0, 121, 0,   /* Reset All Controllers, before the controllers it must not undo */
+      0, 0xb0, 1, 64,    /* Modulation */
+      0, 0xb0, 0, 5,     /* Bank select MSB */
+      0, 0xb0, 32, 2,    /* Bank select LSB */
+      0, 0xc0, 16,       /* Program */
+      0, 0xb0, 7, 100,   /* Volume */
+      0, 0xb0, 123, 0,   /* All Notes Off */
+      0, 0xe0, 0, 0x50,  /* Pitch bend */
+      96, 0x90, 60, 100, /* Note on */
+  });
+
+  boo::MIDIFile file;
+  Check(file.load(smf), "SMF loads");
+
+  RecordingReader chase;
+  file.seek(0.25, &chase);
+  const std::vector<std::string> expected = {"cc 0 0 5", "cc 0 32 2", "pc 0 16", "cc 0 1 64", "cc 0 7 100",
+                                             "pb 0 10240"};
+  Check(chase.m_calls == expected, "seek chases bank, program, controllers, then bend, without mode messages");
+  if (chase.m_calls != expected)
+    for (const std::string& call : chase.m_calls)
+      std::fprintf(stderr, "  %s\n", call.c_str());
+
+  RecordingReader play;
+  Check(file.play(1.0, play) == 1 && play.m_calls == std::vector<std::string>{"on 0 60 100"},
+        "playback resumes at the seek point");
+}
+
+void TestDecoderRealtime() {
+  RecordingReader out;
+  boo::MIDIDecoder decoder(out);
+  const std::vector<uint8_t> bytes = {
+      0x90, 0xf8, 60, 100, /* Clock between status and data */
+      0xb1, 7, 0xfa, 90,   /* Start between data bytes */
+      0xfc, 10, 20,        /* Stop, then running status */
+      0xc2, 0xfb, 5,       /* Continue inside a program change */
+  };
+  Check(decoder.receiveBytes(bytes) == bytes.size(), "decoder consumes interleaved real-time bytes");
+  const std::vector<std::string> expected = {"on 0 60 100", "start", "cc 1 7 90", "stop",
+                                             "cc 1 10 20",  "continue", "pc 2 5"};
+  Check(out.m_calls == expected, "real-time bytes don't take a data byte's place");
+  if (out.m_calls != expected)
+    for (const std::string& call : out.m_calls)
+      std::fprintf(stderr, "  %s\n", call.c_str());
+
+  /* A message cut off after an interleaved Start is handed back whole, and Start fires once it completes */
+  RecordingReader split;
+  boo::MIDIDecoder splitDecoder(split);
+  const std::vector<uint8_t> head = {0x90, 0xfa, 61};
+  Check(splitDecoder.receiveBytes(head) == 0 && split.m_calls.empty(), "incomplete message waits");
+  const std::vector<uint8_t> whole = {0x90, 0xfa, 61, 80};
+  Check(splitDecoder.receiveBytes(whole) == whole.size() &&
+            split.m_calls == std::vector<std::string>{"start", "on 0 61 80"},
+        "resubmitted message dispatches its real-time byte once");
+}
+} // Anonymous namespace
+
+int main() {
+  TestSeekChase();
+  TestDecoderRealtime();
+  if (Failed)
+    return 1;
+  std::puts("MIDI OK");
+  return 0;
+}
@@ -0,0 +1,126 @@
+/* Times the resampler configurations boo creates per voice with soxr's SSE kernels
+ * and with the AVX2/FMA kernels, and checks that the two outputs agree within Tolerance.
+ * 32k->48k is an exact 2:3 ratio; 44.1k->48k takes the interpolated poly-FIR stage.
+ * Exits non-zero when the outputs drift further apart. */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include <soxr.h>
+
+extern "C" {
+#include "simd.h"
+}
+
+namespace {
+constexpr double InRates[] = {32000.0, 44100.0};
+constexpr double OutRate = 48000.0;
+/* FMA and 8-wide summation order differ from SSE by a few ulps of the float output */
+constexpr float Tolerance = 1e-6f;
+constexpr size_t BlockFrames = 240; /* One 5ms mixing interval at 48kHz */
+constexpr size_t Blocks = 4000;
+constexpr int Repeats = 7; /* Best-of, alternating SSE and AVX2 runs */
+
+struct Source {
+  std::vector<int16_t> m_buf;
+  uint32_t m_seed = 1;
+  double m_phase = 0.0;
+
+  static size_t Supply(Source* src, soxr_cbuf_t* data, size_t frames) {
+    if (src->m_buf.size() < frames)
+      src->m_buf.resize(frames);
+    for (size_t i = 0; i < frames; ++i) {
+      src->m_seed = src->m_seed * 1664525u + 1013904223u;
+      const double noise = double(int32_t(src->m_seed) >> 20) / 2048.0;
+      src->m_phase += 0.05 + 0.04 * std::sin(src->m_phase * 0.001);
+      src->m_buf[i] = int16_t(std::lround(20000.0 * std::sin(src->m_phase) + 2000.0 * noise));
+    }
+    *data = src->m_buf.data();
+    return frames;
+  }
+};
+
+struct Result {
+  const char* m_engine = "";
+  double m_ms = 0.0;
+  std::vector<float> m_out;
+};
+
+Result Run(double inRate, bool variableRate) {
+  soxr_io_spec_t ioSpec = soxr_io_spec(SOXR_INT16_I, SOXR_FLOAT32_I);
+  soxr_quality_spec_t qSpec = soxr_quality_spec(SOXR_20_BITQ, variableRate ? SOXR_VR : 0);
+  soxr_error_t err;
+  soxr_t src = soxr_create(inRate, OutRate, 1, &err, &ioSpec, &qSpec, nullptr);
+  if (!src) {
+    std::fprintf(stderr, "soxr_create failed: %s\n", soxr_strerror(err));
+    return {};
+  }
+
+  Source source;
+  soxr_set_input_fn(src, soxr_input_fn_t(Source::Supply), &source, 0);
+
+  Result res;
+  res.m_out.resize(Blocks * BlockFrames);
+  const auto start = std::chrono::steady_clock::now();
+  for (size_t b = 0; b < Blocks; ++b) {
+    if (variableRate) {
+      /* Pitch sweep between -1 and +1 octave, slewed like AudioVoice::setPitchRatio */
+      const double pitch = std::exp2(std::sin(b * 0.01));
+      soxr_set_io_ratio(src, pitch * inRate / OutRate, BlockFrames);
+    }
+    soxr_output(src, res.m_out.data() + b * BlockFrames, BlockFrames);
+  }
+  res.m_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  res.m_engine = soxr_engine(src);
+  soxr_delete(src);
+  return res;
+}
+
+Result Best(double inRate, bool variableRate, bool avx2, Result best) {
+  _soxr_simd_disable_avx2(!avx2);
+  Result res = Run(inRate, variableRate);
+  if (best.m_out.empty() || res.m_ms < best.m_ms)
+    return res;
+  return best;
+}
+} // Anonymous namespace
+
+int main() {
+  const bool haveAVX2 = _soxr_simd_avx2() != 0;
+  if (!haveAVX2)
+    std::printf("AVX2/FMA kernels unavailable on this build or CPU; timing SSE only\n");
+
+  bool drifted = false;
+  for (double inRate : InRates) {
+    for (bool variableRate : {true, false}) {
+      std::printf("%s %g->%g, %zu x %zu frames:\n", variableRate ? "Variable-rate" : "Fixed-rate 20-bit", inRate,
+                  OutRate, Blocks, BlockFrames);
+      Result sse, avx2;
+      for (int r = 0; r < Repeats; ++r) {
+        sse = Best(inRate, variableRate, false, std::move(sse));
+        if (haveAVX2)
+          avx2 = Best(inRate, variableRate, true, std::move(avx2));
+      }
+      std::printf("  %-40s %8.2f ms\n", sse.m_engine, sse.m_ms);
+      if (!haveAVX2)
+        continue;
+      std::printf("  %-40s %8.2f ms\n", avx2.m_engine, avx2.m_ms);
+      if (sse.m_out.empty() || sse.m_out.size() != avx2.m_out.size())
+        return 1;
+
+      float maxDiff = 0.f;
+      for (size_t i = 0; i < sse.m_out.size(); ++i)
+        maxDiff = std::max(maxDiff, std::fabs(sse.m_out[i] - avx2.m_out[i]));
+      const bool ok = maxDiff <= Tolerance;
+      std::printf("  speedup %.2fx, max |SSE - AVX2| = %g (tolerance %g) %s\n", sse.m_ms / avx2.m_ms, maxDiff,
+                  Tolerance, ok ? "ok" : "EXCEEDED");
+      drifted |= !ok;
+    }
+  }
+
+  return drifted ? 1 : 0;
+}